@@ -1,14 +1,30 @@
 /*
  * Dual printf - outputs to both standard console and debug console
  * This outputs to both printf() and RawPutChar for maximum visibility
+ *
+ * RawPutChar on a serial debug setup is slower than the DMA being
+ * measured, so in deferred mode output is only formatted into a
+ * preallocated ring and written out by dbgflush() between test phases
+ * (and at exit).
  */
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <exec/types.h>
+#include "dprintf.h"
 
 extern struct ExecBase *SysBase;
 
+/* Deferred output ring - head/tail are free-running byte counts */
+static char g_log_ring[LOG_RING_SIZE];
+static ULONG g_log_head = 0;
+static ULONG g_log_tail = 0;
+static ULONG g_log_dropped = 0;
+static int g_log_deferred = 0;
+static int g_log_atexit = 0;
+
 /* Direct call to RawPutChar via assembly (SysBase->RawPutChar at offset -516) */
 static void raw_putchar(char c)
 {
@@ -23,6 +39,94 @@ static void raw_putchar(char c)
     );
 }
 
+/*
+ * Write len bytes to both the console and the debug console
+ */
+static void output(const char *buf, ULONG len)
+{
+    ULONG i;
+
+    fwrite(buf, 1, len, stdout);
+
+    for (i = 0; i < len; i++) {
+        raw_putchar(buf[i]);
+    }
+}
+
+/*
+ * Append to the ring, dropping the oldest output if it is full
+ */
+static void ring_append(const char *buf, ULONG len)
+{
+    ULONG pos, first;
+
+    if (len > LOG_RING_SIZE) {
+        g_log_dropped += len - LOG_RING_SIZE;
+        buf += len - LOG_RING_SIZE;
+        len = LOG_RING_SIZE;
+    }
+
+    pos = g_log_head % LOG_RING_SIZE;
+    first = LOG_RING_SIZE - pos;
+    if (first > len)
+        first = len;
+
+    memcpy(&g_log_ring[pos], buf, first);
+    memcpy(g_log_ring, buf + first, len - first);
+    g_log_head += len;
+
+    if (g_log_head - g_log_tail > LOG_RING_SIZE) {
+        g_log_dropped += g_log_head - g_log_tail - LOG_RING_SIZE;
+        g_log_tail = g_log_head - LOG_RING_SIZE;
+    }
+}
+
+/*
+ * dbgflush - write out everything held in the ring
+ */
+void dbgflush(void)
+{
+    char note[64];
+    ULONG pos, len, first;
+
+    if (g_log_dropped) {
+        sprintf(note, "[log: %lu bytes dropped]\n", (unsigned long)g_log_dropped);
+        output(note, strlen(note));
+        g_log_dropped = 0;
+    }
+
+    len = g_log_head - g_log_tail;
+    if (len) {
+        pos = g_log_tail % LOG_RING_SIZE;
+        first = LOG_RING_SIZE - pos;
+        if (first > len)
+            first = len;
+
+        output(&g_log_ring[pos], first);
+        output(g_log_ring, len - first);
+        g_log_tail = g_log_head;
+    }
+
+    fflush(stdout);
+}
+
+/*
+ * dbgdefer - switch between deferred (ring) and direct output
+ * Switching back to direct output flushes the ring first
+ */
+void dbgdefer(int on)
+{
+    if (on && !g_log_atexit) {
+        atexit(dbgflush);
+        g_log_atexit = 1;
+    }
+
+    if (!on)
+        dbgflush();
+
+    g_log_deferred = on;
+}
+
 /*
  * dbgprintf - dual output printf
  * Sends output to both regular console (printf) and debug output (RawPutChar)
@@ -31,18 +135,23 @@ void dbgprintf(const char *format, ...)
 {
     va_list args;
     char buffer[512];
-    char *p;
+    int len;
 
-    /* Format the string using vsprintf */
+    /* Format the string using vsnprintf */
     va_start(args, format);
-    vsprintf(buffer, format, args);
+    len = vsnprintf(buffer, sizeof(buffer), format, args);
     va_end(args);
 
-    /* Output to regular console via printf */
-    printf("%s", buffer);
+    if (len < 0)
+        return;
+    if (len >= (int)sizeof(buffer))
+        len = sizeof(buffer) - 1;
 
-    /* Also output to debug console via RawPutChar */
-    for (p = buffer; *p; p++) {
-        raw_putchar(*p);
+    if (g_log_deferred) {
+        ring_append(buffer, len);
+        return;
     }
+
+    /* Output to regular console and debug console */
+    output(buffer, len);
 }
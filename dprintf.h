@@ -5,7 +5,40 @@
 #ifndef DPRINTF_H
 #define DPRINTF_H
 
+/* Log levels - messages above LOG_LEVEL compile to nothing */
+#define LOG_INFO    1   /* normal tool output (default, lowest) */
+#define LOG_DEBUG   2   /* per-command / per-transfer detail */
+#define LOG_TRACE   3   /* hot-path detail inside timed loops */
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL   LOG_INFO
+#endif
+
+/* dbgprintf() output is the tool's result and is never filtered */
+#if LOG_LEVEL < LOG_INFO
+#error "LOG_LEVEL must be 1 (info), 2 (debug) or 3 (trace)"
+#endif
+
+/* Deferred output ring - oldest output is dropped when it fills */
+#define LOG_RING_SIZE   (32 * 1024)
+
 /* Dual output printf - outputs to both console and debug */
 void dbgprintf(const char *format, ...);
 
+/* Deferred mode: dbgprintf() appends to the ring until dbgflush() */
+void dbgdefer(int on);
+void dbgflush(void);
+
+#if LOG_LEVEL >= LOG_DEBUG
+#define dbgdebug(...)   dbgprintf(__VA_ARGS__)
+#else
+#define dbgdebug(...)   do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_TRACE
+#define dbgtrace(...)   dbgprintf(__VA_ARGS__)
+#else
+#define dbgtrace(...)   do { } while (0)
+#endif
+
 #endif /* DPRINTF_H */
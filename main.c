@@ -6,17 +6,198 @@
 
 #include "ncr_dmatest.h"
 #include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
 #include <proto/exec.h>
 
+static void
+print_usage(void)
+{
+	dbgprintf("Usage: ncr_dmatest [mode] [--fullflush] [--direct] [--cpuverify] [--nobisect]\n\n");
+	dbgprintf("Modes:\n");
+	dbgprintf("  (none)                    - Full region sweep + scatter-gather\n");
+	dbgprintf("  quick                     - Past failures first, then a sparse region sweep\n");
+	dbgprintf("  matrix                    - Alignment 0-15 x odd/prime length matrix\n");
+	dbgprintf("  tune [save]               - Sweep DMODE/CTEST7/DCNTL burst settings\n");
+	dbgprintf("  cache                     - Cost of CacheClearU vs range cache maintenance\n");
+	dbgprintf("  soak [min] [report-min]   - Scatter-gather soak (default %ld min, report every %ld)\n",
+	          (ULONG)SOAK_DEFAULT_MINUTES, (ULONG)SOAK_REPORT_MINUTES);
+	dbgprintf("  fuzz [cases] [seed]       - Random scatter-gather chains (default %ld cases)\n",
+	          (ULONG)FUZZ_DEFAULT_CASES);
+	dbgprintf("  indirect                  - Descriptor-table gather/scatter/many-to-many vs inline\n");
+	dbgprintf("  copy                      - Asynchronous DMA copy library vs CopyMem\n");
+	dbgprintf("  patch [threshold]         - Offload large CopyMem/CopyMemQuick to DMA until Ctrl-D\n");
+	dbgprintf("  costmodel                 - Fit fixed overhead + per-byte cost per region pair\n");
+	dbgprintf("  placement                 - SCRIPTS fetch time from CHIP, MB_FAST, CPU_FASTL and ROM\n");
+	dbgprintf("  microops                  - ns per SCRIPTS instruction: moves, jumps, register ops\n");
+	dbgprintf("  fifo                      - DMA FIFO fill and read/write timeline of one 64 KB move\n");
+	dbgprintf("  stream [port]             - Fixed-address (FAM) DMA from/to a data port (default RAM stand-in)\n");
+	dbgprintf("  scale                     - 16 KB up to 16 MB single-move throughput per region pair\n");
+	dbgprintf("  crossover                 - CopyMem/CopyMemQuick/move16 vs DMA, crossover per pair\n");
+	dbgprintf("  contend [read|write|move16] [same|other]\n");
+	dbgprintf("                            - DMA and CPU MB/s with a CPU load task (default write, same)\n");
+	dbgprintf("  repro <src> <dst> <soff> <doff> <len> <pattern> [burst]\n");
+	dbgprintf("                            - Rerun a failing transfer printed by the bisector\n");
+	dbgprintf("\n");
+	dbgprintf("Options:\n");
+	dbgprintf("  --fullflush               - CacheClearU() around every DMA (old behaviour)\n");
+	dbgprintf("  --direct                  - Print immediately (default: buffer until phase end)\n");
+	dbgprintf("  --cpuverify               - Verify CHIP destinations with the CPU, not DMA readback\n");
+	dbgprintf("  --nobisect                - Do not narrow sweep failures to a reproducer\n");
+	dbgprintf("  --reps <n>                - Timed runs kept per benchmark figure (default %ld)\n",
+	          (ULONG)STATS_DEFAULT_REPS);
+	dbgprintf("  --warmup <n>              - Runs discarded before them (default %ld)\n",
+	          (ULONG)STATS_DEFAULT_WARMUP);
+	dbgprintf("  --resume                  - Sweep: skip what the journal says is done\n");
+	dbgprintf("  --journal <file>          - Sweep journal (default %s)\n", JOURNAL_DEFAULT_PATH);
+	dbgprintf("\n");
+}
+
+/*
+ * Parse command line into options
+ * Returns 0 on success, -1 on bad arguments
+ */
+static LONG
+parse_options(int argc, char **argv, struct TestOptions *opts)
+{
+	int i;
+
+	memset(opts, 0, sizeof(*opts));
+	opts->mode = MODE_STANDARD;
+	opts->stats_reps = STATS_DEFAULT_REPS;
+	opts->stats_warmup = STATS_DEFAULT_WARMUP;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--fullflush") == 0) {
+			opts->full_flush = TRUE;
+		} else if (strcmp(argv[i], "--direct") == 0) {
+			opts->direct_log = TRUE;
+		} else if (strcmp(argv[i], "--cpuverify") == 0) {
+			opts->cpu_verify = TRUE;
+		} else if (strcmp(argv[i], "--nobisect") == 0) {
+			opts->no_bisect = TRUE;
+		} else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+			opts->stats_reps = strtoul(argv[++i], NULL, 10);
+			if (opts->stats_reps < 1 || opts->stats_reps > STATS_MAX_REPS) {
+				dbgprintf("ERROR: --reps must be 1-%ld\n", (ULONG)STATS_MAX_REPS);
+				return -1;
+			}
+		} else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+			opts->stats_warmup = strtoul(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--resume") == 0) {
+			opts->resume = TRUE;
+		} else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+			opts->journal_path = argv[++i];
+		} else if (i == 1 && strcmp(argv[i], "quick") == 0) {
+			opts->mode = MODE_QUICK;
+		} else if (i == 1 && strcmp(argv[i], "matrix") == 0) {
+			opts->mode = MODE_MATRIX;
+		} else if (i == 1 && strcmp(argv[i], "tune") == 0) {
+			opts->mode = MODE_TUNE;
+		} else if (i == 1 && strcmp(argv[i], "cache") == 0) {
+			opts->mode = MODE_CACHE;
+		} else if (i == 1 && strcmp(argv[i], "soak") == 0) {
+			opts->mode = MODE_SOAK;
+		} else if (i == 1 && strcmp(argv[i], "fuzz") == 0) {
+			opts->mode = MODE_FUZZ;
+		} else if (i == 1 && strcmp(argv[i], "indirect") == 0) {
+			opts->mode = MODE_INDIRECT;
+		} else if (i == 1 && strcmp(argv[i], "copy") == 0) {
+			opts->mode = MODE_COPY;
+		} else if (i == 1 && strcmp(argv[i], "patch") == 0) {
+			opts->mode = MODE_PATCH;
+		} else if (i == 1 && strcmp(argv[i], "costmodel") == 0) {
+			opts->mode = MODE_COSTMODEL;
+		} else if (i == 1 && strcmp(argv[i], "placement") == 0) {
+			opts->mode = MODE_PLACEMENT;
+		} else if (i == 1 && strcmp(argv[i], "microops") == 0) {
+			opts->mode = MODE_MICROOPS;
+		} else if (i == 1 && strcmp(argv[i], "fifo") == 0) {
+			opts->mode = MODE_FIFO;
+		} else if (i == 1 && strcmp(argv[i], "stream") == 0) {
+			opts->mode = MODE_STREAM;
+		} else if (i == 1 && strcmp(argv[i], "scale") == 0) {
+			opts->mode = MODE_SCALE;
+		} else if (i == 1 && strcmp(argv[i], "crossover") == 0) {
+			opts->mode = MODE_CROSSOVER;
+		} else if (i == 1 && strcmp(argv[i], "contend") == 0) {
+			opts->mode = MODE_CONTEND;
+			opts->load_kind = LOAD_WRITE;
+		} else if (opts->mode == MODE_CONTEND && strcmp(argv[i], "read") == 0) {
+			opts->load_kind = LOAD_READ;
+		} else if (opts->mode == MODE_CONTEND && strcmp(argv[i], "write") == 0) {
+			opts->load_kind = LOAD_WRITE;
+		} else if (opts->mode == MODE_CONTEND && strcmp(argv[i], "move16") == 0) {
+			opts->load_kind = LOAD_MOVE16;
+		} else if (opts->mode == MODE_CONTEND && strcmp(argv[i], "same") == 0) {
+			opts->load_other = FALSE;
+		} else if (opts->mode == MODE_CONTEND && strcmp(argv[i], "other") == 0) {
+			opts->load_other = TRUE;
+		} else if (i == 1 && strcmp(argv[i], "repro") == 0) {
+			opts->mode = MODE_REPRO;
+		} else if (opts->mode == MODE_TUNE && strcmp(argv[i], "save") == 0) {
+			opts->save_config = TRUE;
+		} else if (opts->mode == MODE_SOAK && argv[i][0] >= '0' && argv[i][0] <= '9' &&
+		           !opts->report_minutes) {
+			if (!opts->soak_minutes)
+				opts->soak_minutes = strtoul(argv[i], NULL, 10);
+			else
+				opts->report_minutes = strtoul(argv[i], NULL, 10);
+		} else if (opts->mode == MODE_FUZZ && argv[i][0] >= '0' && argv[i][0] <= '9' &&
+		           !opts->fuzz_seed) {
+			// Seed is usually given in hex as printed by a failing case
+			if (!opts->fuzz_cases)
+				opts->fuzz_cases = strtoul(argv[i], NULL, 10);
+			else
+				opts->fuzz_seed = strtoul(argv[i], NULL, 0);
+		} else if (opts->mode == MODE_PATCH && argv[i][0] >= '0' && argv[i][0] <= '9' &&
+		           !opts->patch_threshold) {
+			opts->patch_threshold = strtoul(argv[i], NULL, 0);
+		} else if (opts->mode == MODE_STREAM && argv[i][0] >= '0' && argv[i][0] <= '9' &&
+		           !opts->stream_port) {
+			opts->stream_port = strtoul(argv[i], NULL, 0);
+			if (opts->stream_port & 3) {
+				dbgprintf("ERROR: Stream port 0x%08lx is not longword aligned\n",
+				          opts->stream_port);
+				return -1;
+			}
+		} else if (opts->mode == MODE_REPRO && argv[i][0] >= '0' && argv[i][0] <= '9' &&
+		           opts->repro_nargs < REPRO_MAX_ARGS) {
+			// Burst is printed in hex, the rest in decimal
+			opts->repro_args[opts->repro_nargs++] = strtoul(argv[i], NULL, 0);
+		} else {
+			dbgprintf("ERROR: Unknown argument '%s'\n", argv[i]);
+			return -1;
+		}
+	}
+
+	if (!opts->soak_minutes)
+		opts->soak_minutes = SOAK_DEFAULT_MINUTES;
+	if (!opts->report_minutes)
+		opts->report_minutes = SOAK_REPORT_MINUTES;
+	if (!opts->fuzz_cases)
+		opts->fuzz_cases = FUZZ_DEFAULT_CASES;
+
+	return 0;
+}
+
 int main(int argc, char **argv)
 {
+	struct TestOptions opts;
+
 	dbgprintf("\n%s\n", VERSION_STRING);
 	dbgprintf("==============================\n\n");
+
+	if (parse_options(argc, argv, &opts) < 0) {
+		print_usage();
+		return 1;
+	}
+
 	dbgprintf("This tool tests the NCR 53C710 DMA engine.\n");
 	dbgprintf("WARNING: This requires supervisor access!\n\n");
 
 	/* Call the test main function */
-	TestMain();
+	TestMain(&opts);
 
 	return 0;
 }
@@ -0,0 +1,336 @@
+/*
+ * NCR 53C710 DMA Test Tool - Failure bisection
+ *
+ * A failing transfer in the region sweep says "16384 bytes CHIP -> FAST,
+ * RANDOM pattern" - too coarse to take to a logic analyser. BisectFailure()
+ * reruns the transfer with a fixed fill seed and narrows it: shortest
+ * length that still fails, latest start offset, whether longword alignment
+ * makes it go away and which burst configurations show it. The result is
+ * printed as a "repro" command line that RunRepro() executes on its own.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/memory.h>
+#include <proto/exec.h>
+
+/* One transfer, everything needed to repeat it */
+struct ReproCase {
+	ULONG src_idx;		// g_test_buffers[] index
+	ULONG dst_idx;
+	ULONG src_off;		// Byte offset into the buffer
+	ULONG dst_off;
+	ULONG len;
+	ULONG pattern;		// PATTERN_xxx
+	struct BurstConfig cfg;
+};
+
+static BOOL g_bisect_enabled = TRUE;
+static ULONG g_bisect_count;
+
+/*
+ * Allow or suppress bisection of sweep failures
+ */
+void SetBisectEnabled(BOOL enable)
+{
+	g_bisect_enabled = enable;
+}
+
+/*
+ * Burst configuration packed as printed on the repro line: 0xDDCCTT
+ */
+static ULONG PackBurstConfig(struct BurstConfig *cfg)
+{
+	return ((ULONG)cfg->dmode << 16) | ((ULONG)cfg->dcntl << 8) | cfg->ctest7;
+}
+
+static void UnpackBurstConfig(ULONG packed, struct BurstConfig *cfg)
+{
+	cfg->dmode = (packed >> 16) & 0xFF;
+	cfg->dcntl = (packed >> 8) & 0xFF;
+	cfg->ctest7 = packed & 0xFF;
+	cfg->pad = 0;
+}
+
+/*
+ * Print the command line that reruns a case
+ */
+static void PrintReproLine(struct ReproCase *rc)
+{
+	dbgprintf("  ncr_dmatest repro %ld %ld %ld %ld %ld %ld 0x%06lx\n",
+	          rc->src_idx, rc->dst_idx, rc->src_off, rc->dst_off,
+	          rc->len, rc->pattern, PackBurstConfig(&rc->cfg));
+}
+
+/*
+ * Run a case 'tries' times under its burst configuration
+ * Every run refills the source from BISECT_FILL_SEED so the data is the
+ * same each time. *first_bad gets the lowest failing offset seen
+ * (-1 if none was a verify error).
+ * Returns number of failed runs
+ */
+static ULONG RunCase(volatile struct ncr710 *ncr, struct ReproCase *rc,
+                     ULONG tries, LONG *first_bad, BOOL verbose)
+{
+	UBYTE *src = *g_test_buffers[rc->src_idx].buf + rc->src_off;
+	UBYTE *dst = *g_test_buffers[rc->dst_idx].buf + rc->dst_off;
+	struct TestResult result;
+	ULONG i, failed = 0;
+	LONG status;
+
+	*first_bad = -1;
+	ApplyBurstConfig(ncr, &rc->cfg);
+
+	for (i = 0; i < tries; i++) {
+		SeedRandom(BISECT_FILL_SEED);
+		FillPattern(src, rc->len, rc->pattern);
+		FillPattern(dst, rc->len, PATTERN_ZEROS);
+
+		result.error_offset = 0;
+		status = RunDMAVerified(ncr, src, dst, rc->len, &result);
+		if (status == TEST_SUCCESS)
+			continue;
+		if (status == TEST_ABORTED)
+			break;	// The user stopped it - not a failure
+
+		failed++;
+		if (status == TEST_VERIFY_ERROR &&
+		    (*first_bad < 0 || result.error_offset < (ULONG)*first_bad))
+			*first_bad = result.error_offset;
+
+		if (verbose && failed <= BISECT_TRIES) {
+			if (status == TEST_VERIFY_ERROR)
+				dbgprintf("  Run %4ld: offset 0x%lx expected 0x%02lx got 0x%02lx\n",
+				          i, result.error_offset,
+				          result.expected_value, result.actual_value);
+			else
+				dbgprintf("  Run %4ld: status %ld\n", i, status);
+			// Whole-range picture of the first failure
+			if (failed == 1 && status == TEST_VERIFY_ERROR)
+				AnalyzeErrors(src, dst, rc->len);
+		}
+	}
+
+	return failed;
+}
+
+/*
+ * Narrow a failing sweep transfer down to the smallest case that still
+ * fails and print it as a repro command line. Only the first
+ * BISECT_MAX_PER_RUN failures of a run are bisected.
+ */
+void BisectFailure(volatile struct ncr710 *ncr, UBYTE *src_base, UBYTE *dst_base,
+                   ULONG size, ULONG pattern)
+{
+	struct BurstConfig orig, cfg;
+	struct ReproCase rc, trial;
+	ULONG fails[NUM_TUNE_CONFIGS];
+	ULONG best_fails, lo, hi, mid, i;
+	LONG src_idx, dst_idx, bad;
+
+	if (!g_bisect_enabled || g_bisect_count >= BISECT_MAX_PER_RUN)
+		return;
+
+	src_idx = FindTestBuffer(src_base);
+	dst_idx = FindTestBuffer(dst_base);
+	if (src_idx < 0 || dst_idx < 0)
+		return;
+
+	g_bisect_count++;
+	ReadBurstConfig(ncr, &orig);
+
+	rc.src_idx = src_idx;
+	rc.dst_idx = dst_idx;
+	rc.src_off = 0;
+	rc.dst_off = 0;
+	rc.len = size;
+	rc.pattern = pattern;
+	rc.cfg = orig;
+
+	dbgprintf("\n  --- Bisecting %s -> %s, %ld bytes, pattern %ld ---\n",
+	          g_test_buffers[src_idx].name, g_test_buffers[dst_idx].name,
+	          size, pattern);
+
+	best_fails = RunCase(ncr, &rc, BISECT_TRIES, &bad, FALSE);
+	if (g_user_abort)
+		goto aborted;
+	if (best_fails == 0) {
+		dbgprintf("  Did not fail again in %ld runs with seeded data - intermittent\n",
+		          (ULONG)BISECT_TRIES);
+		dbgprintf("  Rerun the original transfer with:\n");
+		PrintReproLine(&rc);
+		ApplyBurstConfig(ncr, &orig);
+		return;
+	}
+
+	// Length: shortest transfer from the same start that still fails
+	lo = 0;
+	hi = rc.len;
+	if (bad >= 0 && (ULONG)bad + 1 < rc.len) {
+		trial = rc;
+		trial.len = bad + 1;
+		if (RunCase(ncr, &trial, BISECT_TRIES, &bad, FALSE))
+			hi = trial.len;
+		else
+			lo = trial.len;
+		if (g_user_abort)
+			goto aborted;
+	}
+	while (hi - lo > 1) {
+		trial = rc;
+		trial.len = lo + (hi - lo) / 2;
+		if (RunCase(ncr, &trial, BISECT_TRIES, &bad, FALSE))
+			hi = trial.len;
+		else
+			lo = trial.len;
+		if (g_user_abort)
+			goto aborted;
+	}
+	rc.len = hi;
+	dbgprintf("  Length:    fails from %ld bytes\n", rc.len);
+
+	// Offset: latest start that still fails, same end, same relative alignment
+	lo = 0;
+	hi = rc.len;
+	while (hi - lo > 1) {
+		mid = lo + (hi - lo) / 2;
+		trial = rc;
+		trial.src_off += mid;
+		trial.dst_off += mid;
+		trial.len -= mid;
+		if (RunCase(ncr, &trial, BISECT_TRIES, &bad, FALSE))
+			lo = mid;
+		else
+			hi = mid;
+		if (g_user_abort)
+			goto aborted;
+	}
+	rc.src_off += lo;
+	rc.dst_off += lo;
+	rc.len -= lo;
+	dbgprintf("  Offset:    fails from +%ld, %ld bytes\n", rc.src_off, rc.len);
+
+	// Alignment: does the same window fail when both ends start on a longword?
+	if ((rc.src_off & 3) || (rc.dst_off & 3)) {
+		trial = rc;
+		trial.src_off &= ~3;
+		trial.dst_off &= ~3;
+		trial.len += rc.src_off - trial.src_off;
+		if (RunCase(ncr, &trial, BISECT_TRIES, &bad, FALSE)) {
+			dbgprintf("  Alignment: also fails longword aligned - not alignment related\n");
+			rc = trial;
+		} else if (!g_user_abort) {
+			dbgprintf("  Alignment: passes longword aligned - needs src+%ld dst+%ld\n",
+			          rc.src_off & 3, rc.dst_off & 3);
+		}
+		if (g_user_abort)
+			goto aborted;
+	} else {
+		dbgprintf("  Alignment: fails longword aligned\n");
+	}
+
+	// Burst: which configurations show it, keep the most reliable one
+	dbgprintf("  Burst:     ");
+	for (i = 0; i < NUM_TUNE_CONFIGS; i++) {
+		BuildTuneConfig(i, &orig, &cfg);
+		trial = rc;
+		trial.cfg = cfg;
+		fails[i] = RunCase(ncr, &trial, BISECT_TRIES, &bad, FALSE);
+		if (g_user_abort)
+			goto aborted;
+		dbgprintf("%ld%s", fails[i], (i + 1 < NUM_TUNE_CONFIGS) ? "/" : "");
+	}
+	dbgprintf(" of %ld per config\n", (ULONG)BISECT_TRIES);
+
+	best_fails = 0;
+	for (i = 0; i < NUM_TUNE_CONFIGS; i++) {
+		if (fails[i] > best_fails) {
+			best_fails = fails[i];
+			BuildTuneConfig(i, &orig, &rc.cfg);
+		}
+	}
+	if (best_fails == 0) {
+		// Gone under every generated config - only the original shows it
+		rc.cfg = orig;
+	} else {
+		dbgprintf("             using ");
+		PrintTuneConfig(&rc.cfg);
+		dbgprintf("\n");
+	}
+
+	best_fails = RunCase(ncr, &rc, BISECT_CONFIRM_TRIES, &bad, FALSE);
+	ApplyBurstConfig(ncr, &orig);
+	if (g_user_abort)
+		goto stopped;
+
+	dbgprintf("  Minimal reproducer: %ld bytes, fails %ld of %ld runs%s\n",
+	          rc.len, best_fails, (ULONG)BISECT_CONFIRM_TRIES,
+	          (best_fails == BISECT_CONFIRM_TRIES) ? " (deterministic)" : "");
+	PrintReproLine(&rc);
+	dbgprintf("\n");
+	return;
+
+aborted:
+	ApplyBurstConfig(ncr, &orig);
+stopped:
+	dbgprintf("\n  Bisect stopped by user\n");
+}
+
+/*
+ * Rerun one case from a repro command line
+ * args: src dst src_off dst_off len pattern [burst]
+ */
+void RunRepro(volatile struct ncr710 *ncr, ULONG *args, ULONG nargs)
+{
+	struct BurstConfig orig;
+	struct ReproCase rc;
+	ULONG failed;
+	LONG bad;
+
+	dbgprintf("\n=== DMA Failure Reproducer ===\n");
+
+	if (nargs < 6) {
+		dbgprintf("ERROR: repro needs src dst src_off dst_off len pattern [burst]\n");
+		return;
+	}
+
+	rc.src_idx = args[0];
+	rc.dst_idx = args[1];
+	rc.src_off = args[2];
+	rc.dst_off = args[3];
+	rc.len = args[4];
+	rc.pattern = args[5];
+
+	if (rc.src_idx >= (ULONG)g_num_test_buffers || rc.dst_idx >= (ULONG)g_num_test_buffers ||
+	    !*g_test_buffers[rc.src_idx].buf || !*g_test_buffers[rc.dst_idx].buf) {
+		dbgprintf("ERROR: Buffer %ld or %ld not available\n", rc.src_idx, rc.dst_idx);
+		return;
+	}
+	if (rc.len == 0 || rc.len > MAX_TEST_SIZE || rc.pattern >= NUM_TEST_PATTERNS ||
+	    rc.src_off > TEST_BUFFER_SIZE - rc.len || rc.dst_off > TEST_BUFFER_SIZE - rc.len) {
+		dbgprintf("ERROR: Length, offset or pattern out of range\n");
+		return;
+	}
+
+	ReadBurstConfig(ncr, &orig);
+	if (nargs > 6)
+		UnpackBurstConfig(args[6], &rc.cfg);
+	else
+		rc.cfg = orig;
+
+	dbgprintf("%s+%ld -> %s+%ld, %ld bytes, pattern %ld\n",
+	          g_test_buffers[rc.src_idx].name, rc.src_off,
+	          g_test_buffers[rc.dst_idx].name, rc.dst_off, rc.len, rc.pattern);
+	PrintTuneConfig(&rc.cfg);
+	dbgprintf("\n\n");
+
+	failed = RunCase(ncr, &rc, REPRO_ITERATIONS, &bad, TRUE);
+	ApplyBurstConfig(ncr, &orig);
+
+	dbgprintf("\n=== Reproducer: %ld of %ld runs failed", failed, (ULONG)REPRO_ITERATIONS);
+	if (bad >= 0)
+		dbgprintf(", lowest bad offset 0x%lx", (ULONG)bad);
+	dbgprintf(" ===\n\n");
+	dbgflush();
+}
@@ -0,0 +1,341 @@
+/*
+ * NCR 53C710 DMA Test Tool - DMA cache maintenance and address translation
+ *
+ * CacheClearU() pushes and invalidates the entire 68040 data and
+ * instruction caches - even for a 4 byte transfer, and at the expense
+ * of every other task on the machine. The default range mode instead
+ * runs CachePreDMA()/CachePostDMA() over just the script, DSA and data
+ * ranges a transfer touches. The full-flush mode adds the old blanket
+ * CacheClearU() calls back for comparison; both are timed so the cost of
+ * the blanket flushes can be reported.
+ *
+ * CachePreDMA() also returns the physical address of each range and
+ * stops at physical discontinuities, so every address handed to the chip
+ * (memory moves, DSA tables, DSP) goes through DMAMapRange() and is split
+ * into one segment per physically contiguous piece. This keeps the tools
+ * working with an MMU remapping memory.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/execbase.h>
+#include <exec/memory.h>
+#include <proto/exec.h>
+
+static ULONG g_cache_mode = CACHE_MODE_RANGE;
+
+/* Maintenance statistics */
+static ULONG g_full_calls = 0;
+static ULONG g_full_micros = 0;
+static ULONG g_range_calls = 0;
+static ULONG g_range_bytes = 0;
+static ULONG g_range_micros = 0;
+
+/*
+ * Select range (default) or full-flush cache maintenance
+ */
+void SetDMACacheMode(ULONG mode)
+{
+	g_cache_mode = mode;
+}
+
+ULONG GetDMACacheMode(void)
+{
+	return g_cache_mode;
+}
+
+/*
+ * Prepare a range for DMA and record its physical segments
+ * CachePreDMA() shortens the length at a physical discontinuity, so keep
+ * going with DMA_Continue until the whole range is covered. Adjacent
+ * physically contiguous pieces are merged.
+ * Returns the number of segments, 0 if more than max_segs were needed
+ * (the whole range is still prepared and must be finished with
+ * DMACachePost())
+ */
+ULONG DMAMapRange(APTR addr, ULONG len, ULONG dir,
+                  struct DMASegment *segs, ULONG max_segs)
+{
+	struct EClockVal t0, t1;
+	UBYTE *p = addr;
+	ULONG flags, chunk, phys;
+	ULONG nsegs = 0;
+	BOOL overflow = FALSE;
+
+	if (len == 0)
+		return 0;
+
+	flags = (dir & DMA_DIR_READ) ? DMA_ReadFromRAM : 0;
+
+	ReadTimer(&t0);
+	while (len) {
+		chunk = len;
+		phys = (ULONG)CachePreDMA(p, &chunk, flags);
+		if (chunk == 0 || chunk > len)
+			chunk = len;
+
+		if (segs) {
+			if (nsegs && segs[nsegs - 1].phys + segs[nsegs - 1].len == phys) {
+				segs[nsegs - 1].len += chunk;
+			} else if (nsegs < max_segs) {
+				segs[nsegs].phys = phys;
+				segs[nsegs].len = chunk;
+				nsegs++;
+			} else {
+				overflow = TRUE;
+			}
+		}
+
+		p += chunk;
+		len -= chunk;
+		flags |= DMA_Continue;
+	}
+	ReadTimer(&t1);
+
+	g_range_calls++;
+	g_range_bytes += p - (UBYTE *)addr;
+	g_range_micros += ElapsedMicros(&t0, &t1);
+
+	return overflow ? 0 : nsegs;
+}
+
+/*
+ * Prepare a range for DMA (cache maintenance only)
+ */
+void DMACachePre(APTR addr, ULONG len, ULONG dir)
+{
+	DMAMapRange(addr, len, dir, NULL, 0);
+}
+
+/*
+ * Physical address of a single location (translation only - the range
+ * is finished again straight away)
+ */
+ULONG DMAPhysAddr(APTR addr)
+{
+	ULONG len = 1;
+	ULONG phys;
+
+	phys = (ULONG)CachePreDMA(addr, &len, DMA_ReadFromRAM);
+	len = 1;
+	CachePostDMA(addr, &len, DMA_ReadFromRAM);
+
+	return phys;
+}
+
+/*
+ * Physical segments of a range (translation only - the range is finished
+ * again straight away, so the contents can still be written afterwards)
+ */
+ULONG DMATranslateRange(APTR addr, ULONG len, struct DMASegment *segs, ULONG max_segs)
+{
+	ULONG nsegs;
+
+	nsegs = DMAMapRange(addr, len, DMA_DIR_READ, segs, max_segs);
+	DMACachePost(addr, len, DMA_DIR_READ);
+
+	return nsegs;
+}
+
+/*
+ * Finish DMA on a range
+ * A range the chip wrote to (DMA_DIR_WRITE/BOTH) is invalidated so the
+ * CPU sees the new data.
+ */
+void DMACachePost(APTR addr, ULONG len, ULONG dir)
+{
+	struct EClockVal t0, t1;
+	UBYTE *p = addr;
+	ULONG flags, chunk;
+
+	if (len == 0)
+		return;
+
+	flags = (dir & DMA_DIR_WRITE) ? 0 : DMA_ReadFromRAM;
+
+	ReadTimer(&t0);
+	while (len) {
+		chunk = len;
+		CachePostDMA(p, &chunk, flags);
+		if (chunk == 0 || chunk > len)
+			chunk = len;
+		p += chunk;
+		len -= chunk;
+		flags |= DMA_Continue;
+	}
+	ReadTimer(&t1);
+
+	g_range_calls++;
+	g_range_bytes += p - (UBYTE *)addr;
+	g_range_micros += ElapsedMicros(&t0, &t1);
+}
+
+/*
+ * Blanket CacheClearU() - only in full-flush mode
+ * Sits where the tools used to call CacheClearU() directly; the range
+ * maintenance still runs alongside it since it also translates addresses
+ */
+void DMACacheClear(void)
+{
+	struct EClockVal t0, t1;
+
+	if (g_cache_mode != CACHE_MODE_FULL)
+		return;
+
+	ReadTimer(&t0);
+	CacheClearU();
+	ReadTimer(&t1);
+
+	g_full_calls++;
+	g_full_micros += ElapsedMicros(&t0, &t1);
+}
+
+/*
+ * Reset maintenance statistics
+ */
+void ResetCacheStats(void)
+{
+	g_full_calls = 0;
+	g_full_micros = 0;
+	g_range_calls = 0;
+	g_range_bytes = 0;
+	g_range_micros = 0;
+}
+
+/*
+ * Total time spent in cache maintenance since the last reset
+ */
+ULONG GetCacheMicros(void)
+{
+	return g_full_micros + g_range_micros;
+}
+
+/*
+ * Print maintenance statistics
+ */
+void PrintCacheStats(void)
+{
+	dbgprintf("\n=== DMA Cache Maintenance (%s mode) ===\n",
+	          (g_cache_mode == CACHE_MODE_FULL) ? "full-flush" : "range");
+
+	if (g_full_calls) {
+		dbgprintf("  CacheClearU:       %ld calls, %ld us total, %ld us/call\n",
+		          g_full_calls, g_full_micros, g_full_micros / g_full_calls);
+	}
+
+	if (g_range_calls) {
+		dbgprintf("  Pre/PostDMA range: %ld calls, %ld bytes, %ld us total, %ld us/call\n",
+		          g_range_calls, g_range_bytes, g_range_micros,
+		          g_range_micros / g_range_calls);
+	}
+
+	if (!g_full_calls && !g_range_calls)
+		dbgprintf("  No cache maintenance performed\n");
+}
+
+/*
+ * Reserve size bytes inside an address range, at an address aligned to
+ * align (a power of two, at least 8) with lead spare bytes below it
+ * Takes the first free chunk of a memory header in the range that fits,
+ * under Forbid() so it cannot go before AllocAbs(). The allocation covers
+ * the lead bytes too: it starts at result - lead and is
+ * (lead + size + 7) & ~7 bytes long.
+ * Returns the aligned address, NULL if no chunk fits
+ */
+APTR ReserveInRange(ULONG start, ULONG end, ULONG size, ULONG align, ULONG lead)
+{
+	struct MemHeader *mh;
+	struct MemChunk *mc;
+	ULONG p, total = (lead + size + 7) & ~7UL;
+	APTR mem = NULL;
+
+	Forbid();
+	for (mh = (struct MemHeader *)SysBase->MemList.lh_Head; mh->mh_Node.ln_Succ && !mem;
+	     mh = (struct MemHeader *)mh->mh_Node.ln_Succ) {
+		if ((ULONG)mh->mh_Lower < start || (ULONG)mh->mh_Lower > end)
+			continue;
+
+		for (mc = mh->mh_First; mc; mc = mc->mc_Next) {
+			p = ((ULONG)mc + lead + align - 1) & ~(align - 1);
+			if (p - lead - (ULONG)mc + total > mc->mc_Bytes)
+				continue;
+
+			if (AllocAbs(total, (APTR)(p - lead)))
+				mem = (APTR)p;
+			break;
+		}
+	}
+	Permit();
+
+	return mem;
+}
+
+/*
+ * Allocate a buffer that does not cross a DMA_PAGE_SIZE boundary
+ * MMU pages are at least that large, so the buffer is physically
+ * contiguous and can be handed to the chip as one address (SCRIPTS,
+ * DSA). The result is 16-byte aligned. size must be <= DMA_PAGE_SIZE.
+ */
+APTR AllocDMAContig(ULONG size, ULONG flags)
+{
+	ULONG total = 2 * size + 24;
+	UBYTE *raw;
+	ULONG p;
+
+	if (size > DMA_PAGE_SIZE)
+		return NULL;
+
+	raw = AllocMem(total, flags);
+	if (!raw)
+		return NULL;
+
+	p = ((ULONG)raw + 8 + 15) & ~15UL;
+	if ((p & (DMA_PAGE_SIZE - 1)) + size > DMA_PAGE_SIZE)
+		p = (p + DMA_PAGE_SIZE - 1) & ~(ULONG)(DMA_PAGE_SIZE - 1);
+
+	// Remember the real allocation just below the returned block
+	((ULONG *)p)[-2] = (ULONG)raw;
+	((ULONG *)p)[-1] = total;
+
+	return (APTR)p;
+}
+
+/*
+ * AllocDMAContig() within an address range (no attribute picks
+ * MB_FAST over CPU_FASTL). The block is aligned to its size rounded up
+ * to a power of two, so it cannot cross a page, and carries the same
+ * header, so it is freed with FreeDMAContig() like any other.
+ */
+APTR AllocDMAContigIn(ULONG size, ULONG start, ULONG end)
+{
+	ULONG align = 16;
+	ULONG *mem;
+
+	if (size > DMA_PAGE_SIZE)
+		return NULL;
+
+	while (align < size)
+		align <<= 1;
+
+	mem = ReserveInRange(start, end, size, align, 8);
+	if (!mem)
+		return NULL;
+
+	mem[-2] = (ULONG)mem - 8;
+	mem[-1] = (8 + size + 7) & ~7UL;
+	memset(mem, 0, size);
+
+	return mem;
+}
+
+/*
+ * Free a buffer from AllocDMAContig()
+ */
+void FreeDMAContig(APTR mem)
+{
+	if (!mem)
+		return;
+
+	FreeMem((APTR)((ULONG *)mem)[-2], ((ULONG *)mem)[-1]);
+}
@@ -0,0 +1,297 @@
+/*
+ * NCR 53C710 DMA Test Tool - DMA under CPU bus contention
+ *
+ * Every other benchmark runs the chip on an idle bus. Here a load task
+ * streams reads, writes or move16 copies through a memory region while
+ * RunDMATest() moves data between a region pair. The load task runs one
+ * priority below us, so it gets the CPU exactly while we sleep in Wait()
+ * for the chip. DMA MB/s is reported idle and loaded, together with what
+ * the CPU achieved alone and while the chip was running.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/memory.h>
+#include <exec/tasks.h>
+#include <proto/exec.h>
+#include <clib/alib_protos.h>
+
+#define MAX_CONTEND_PAIRS 16
+
+static const char *load_names[] = { "read", "write", "move16" };
+
+/* Shared with the load task */
+static volatile BOOL g_load_stop;
+static volatile ULONG g_load_bytes;
+static ULONG g_load_kind;
+static UBYTE *g_load_buf;
+static struct Task *g_load_parent;
+static ULONG g_load_done_sig;
+
+/*
+ * One pass of CPU load over CONTEND_LOAD_SIZE bytes of buf
+ * buf must be 16-byte aligned for move16
+ */
+static void LoadPass(UBYTE *buf, ULONG kind)
+{
+	volatile ULONG *p = (volatile ULONG *)buf;
+	ULONG n = CONTEND_LOAD_SIZE / sizeof(ULONG);
+	ULONG sum = 0;
+
+	switch (kind) {
+	case LOAD_READ:
+		while (n) {
+			sum += p[0] + p[1] + p[2] + p[3];
+			p += 4;
+			n -= 4;
+		}
+		(void)sum;
+		break;
+
+	case LOAD_WRITE:
+		while (n) {
+			p[0] = n;
+			p[1] = n;
+			p[2] = n;
+			p[3] = n;
+			p += 4;
+			n -= 4;
+		}
+		break;
+
+	case LOAD_MOVE16: {
+		// Copy the first half of the load area over the second half
+		UBYTE *src = buf;
+		UBYTE *dst = buf + CONTEND_LOAD_SIZE / 2;
+		ULONG lines = CONTEND_LOAD_SIZE / 2 / 16;
+
+		__asm__ volatile (
+			"1:	move16	(%0)+,(%1)+\n\t"
+			"	subq.l	#1,%2\n\t"
+			"	bne.s	1b"
+			: "+a" (src), "+a" (dst), "+d" (lines)
+			:
+			: "cc", "memory");
+		break;
+	}
+	}
+}
+
+/*
+ * Load task: run passes until told to stop, then signal the parent
+ * Forbid() keeps the parent from running before the task is gone
+ */
+static void __attribute__((saveds)) LoadTaskEntry(void)
+{
+	while (!g_load_stop) {
+		LoadPass(g_load_buf, g_load_kind);
+		g_load_bytes += CONTEND_LOAD_SIZE;
+	}
+
+	Forbid();
+	Signal(g_load_parent, 1UL << g_load_done_sig);
+}
+
+/*
+ * Start the load task on buf
+ * Returns 0 on success, -1 on failure
+ */
+static LONG StartLoad(UBYTE *buf, ULONG kind)
+{
+	g_load_stop = FALSE;
+	g_load_bytes = 0;
+	g_load_kind = kind;
+	g_load_buf = buf;
+
+	if (!CreateTask("ncr_dmatest load", g_load_parent->tc_Node.ln_Pri - 1,
+	                (APTR)LoadTaskEntry, CONTEND_STACK_SIZE)) {
+		dbgprintf("ERROR: Could not create load task\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Stop the load task and wait until it has gone
+ * Returns bytes it moved
+ */
+static ULONG StopLoad(void)
+{
+	g_load_stop = TRUE;
+	Wait(1UL << g_load_done_sig);
+
+	return g_load_bytes;
+}
+
+/*
+ * Time the load with nothing else running, StatsRuns() runs of
+ * CONTEND_ITERATIONS passes
+ */
+static void IdleLoadRate(UBYTE *buf, ULONG kind, struct SampleStats *st)
+{
+	struct EClockVal t0, t1;
+	ULONG run_us[STATS_MAX_REPS];
+	struct SampleSet set;
+	ULONG i, run;
+
+	StatsBegin(&set, run_us);
+	for (run = 0; run < StatsRuns(); run++) {
+		ReadTimer(&t0);
+		for (i = 0; i < CONTEND_ITERATIONS; i++)
+			LoadPass(buf, kind);
+		ReadTimer(&t1);
+		StatsAdd(&set, ElapsedMicros(&t0, &t1));
+	}
+	StatsCompute(&set, st);
+}
+
+/*
+ * Time CONTEND_ITERATIONS transfers of CONTEND_DMA_SIZE bytes, StatsRuns() runs
+ * Returns median MB/s in hundredths, 0 on error. Over the kept (non
+ * warm-up) runs only, *elapsed gets the wall time and *load_bytes what
+ * the load task moved meanwhile (both 0 on error).
+ */
+static ULONG TimeDMA(volatile struct ncr710 *ncr, UBYTE *src, UBYTE *dst,
+                     ULONG *elapsed, ULONG *load_bytes, ULONG *errors,
+                     struct SampleStats *st)
+{
+	struct EClockVal t0, t1;
+	struct TestResult result;
+	ULONG run_us[STATS_MAX_REPS];
+	struct SampleSet set;
+	ULONG i, run, us, load_start = 0;
+
+	*elapsed = 0;
+	*load_bytes = 0;
+	st->n = 0;
+	FillPattern(src, CONTEND_DMA_SIZE, PATTERN_RANDOM);
+
+	StatsBegin(&set, run_us);
+	for (run = 0; run < StatsRuns(); run++) {
+		if (run == set.warmup)
+			load_start = g_load_bytes;
+		ReadTimer(&t0);
+		for (i = 0; i < CONTEND_ITERATIONS; i++) {
+			if (RunDMATest(ncr, src, dst, CONTEND_DMA_SIZE) != TEST_SUCCESS) {
+				(*errors)++;
+				*elapsed = 0;
+				return 0;
+			}
+		}
+		ReadTimer(&t1);
+		us = ElapsedMicros(&t0, &t1);
+		if (run >= set.warmup)
+			*elapsed += us;
+		StatsAdd(&set, us);
+	}
+	*load_bytes = g_load_bytes - load_start;
+
+	if (VerifyBuffer(src, dst, CONTEND_DMA_SIZE, &result) != TEST_SUCCESS)
+		(*errors)++;
+
+	StatsCompute(&set, st);
+
+	return StatsRate(CONTEND_ITERATIONS * CONTEND_DMA_SIZE, st);
+}
+
+/*
+ * Buffer whose upper half carries the load: the destination's own
+ * buffer, or the first one in a different region
+ */
+static UBYTE *PickLoadBuffer(int dst_idx, BOOL other)
+{
+	UBYTE *buf = NULL;
+	int idx;
+
+	if (!other) {
+		buf = *g_test_buffers[dst_idx].buf;
+	} else {
+		for (idx = 0; idx < g_num_test_buffers && !buf; idx++) {
+			if (*g_test_buffers[idx].buf &&
+			    strcmp(g_test_buffers[idx].name, g_test_buffers[dst_idx].name) != 0)
+				buf = *g_test_buffers[idx].buf;
+		}
+	}
+
+	if (!buf)
+		return NULL;
+
+	// Clear of the DMA area, 16-byte aligned for move16
+	return (UBYTE *)(((ULONG)buf + CONTEND_LOAD_OFFSET + 15) & ~15UL);
+}
+
+/*
+ * Run every region pair idle and under the selected CPU load
+ */
+void TestBusContention(volatile struct ncr710 *ncr, ULONG kind, BOOL other)
+{
+	int src_idx, dst_idx;
+	ULONG pairs = 0, errors = 0;
+	BYTE sig;
+
+	dbgprintf("\n=== DMA Under CPU Bus Contention ===\n");
+	dbgprintf("%ld x %ld byte transfers per run, CPU %s load on %s region\n",
+	          (ULONG)CONTEND_ITERATIONS, (ULONG)CONTEND_DMA_SIZE,
+	          load_names[kind], other ? "another" : "the destination");
+	PrintStatsConfig();
+	dbgprintf("MB/s are min/median/p99; CPU loaded is the load's rate over the kept runs\n");
+
+	g_load_parent = FindTask(NULL);
+	sig = AllocSignal(-1);
+	if (sig < 0) {
+		dbgprintf("ERROR: No free signal\n");
+		return;
+	}
+	g_load_done_sig = sig;
+
+	for (src_idx = 0; src_idx < g_num_test_buffers; src_idx += 2) {
+		for (dst_idx = 1; dst_idx < g_num_test_buffers; dst_idx += 2) {
+			UBYTE *src = *g_test_buffers[src_idx].buf;
+			UBYTE *dst = *g_test_buffers[dst_idx].buf;
+			UBYTE *load = PickLoadBuffer(dst_idx, other);
+			ULONG dma_idle, dma_load, cpu_load, us = 0, bytes = 0;
+			ULONG load_kind = kind;
+			struct SampleStats idle_st, load_st, cpu_st;
+
+			if (pairs >= MAX_CONTEND_PAIRS || !src || !dst || !load)
+				continue;
+			pairs++;
+
+			// move16 needs line bursts, which CHIP RAM does not take
+			if (load_kind == LOAD_MOVE16 && (TypeOfMem(load) & MEMF_CHIP))
+				load_kind = LOAD_WRITE;
+
+			dma_idle = TimeDMA(ncr, src, dst, &us, &bytes, &errors, &idle_st);
+			IdleLoadRate(load, load_kind, &cpu_st);
+
+			if (StartLoad(load, load_kind) < 0)
+				break;
+			dma_load = TimeDMA(ncr, src, dst, &us, &bytes, &errors, &load_st);
+			StopLoad();
+			cpu_load = us ? CalcRate(bytes, us) : 0;
+
+			dbgprintf("\n%-9s -> %-9s  %s load on %s\n",
+			          g_test_buffers[src_idx].name, g_test_buffers[dst_idx].name,
+			          load_names[load_kind], (TypeOfMem(load) & MEMF_CHIP) ? "CHIP" : "FAST");
+			dbgprintf("  DMA idle  ");
+			PrintRateStats(CONTEND_ITERATIONS * CONTEND_DMA_SIZE, &idle_st);
+			dbgprintf("\n  DMA loaded");
+			PrintRateStats(CONTEND_ITERATIONS * CONTEND_DMA_SIZE, &load_st);
+			dbgprintf(" (%ld%%)\n  CPU idle  ", dma_idle ? (dma_load * 100) / dma_idle : 0);
+			PrintRateStats(CONTEND_ITERATIONS * CONTEND_LOAD_SIZE, &cpu_st);
+			dbgprintf("\n  CPU loaded %3ld.%02ld MB/s\n", cpu_load / 100, cpu_load % 100);
+			dbgflush();
+		}
+	}
+
+	FreeSignal(sig);
+
+	if (errors)
+		dbgprintf("\nWARNING: %ld transfers failed - affected rates read 0\n", errors);
+	dbgprintf("\nDMA %% is loaded vs idle throughput. CPU loaded is what the load task\n");
+	dbgprintf("moved while the chip ran (it only runs while we wait for the chip).\n");
+	dbgprintf("\n=== Bus Contention Complete ===\n\n");
+	dbgflush();
+}
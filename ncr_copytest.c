@@ -0,0 +1,265 @@
+/*
+ * NCR 53C710 DMA Test Tool - Asynchronous DMA copy library test
+ *
+ * Exercises ncr_dmacopy.c the way a graphics or audio tool would use it:
+ * a burst of CHIP<->FAST copies submitted back to back (batched while the
+ * chip is busy), cancellation of a request that has not started, and
+ * polling while the CPU is free for other work. Throughput and the CPU
+ * time spent submitting are compared with CopyMem(), over StatsRuns()
+ * bursts per direction.
+ */
+
+#include "ncr_dmacopy.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/memory.h>
+#include <proto/exec.h>
+
+#define COPYTEST_REQUESTS  16                                  // Requests per burst
+#define COPYTEST_CHUNK     (TEST_BUFFER_SIZE / COPYTEST_REQUESTS)
+#define COPYTEST_FILL      0x3C                                // Untouched destination
+
+/*
+ * Find a CHIP and a FAST test buffer
+ */
+static BOOL PickBuffers(UBYTE **chip, UBYTE **fast)
+{
+	int idx;
+
+	*chip = NULL;
+	*fast = NULL;
+
+	for (idx = 0; idx < g_num_test_buffers; idx++) {
+		UBYTE *buf = *g_test_buffers[idx].buf;
+
+		if (!buf)
+			continue;
+		if (TypeOfMem(buf) & MEMF_CHIP) {
+			if (!*chip)
+				*chip = buf;
+		} else if (!*fast) {
+			*fast = buf;
+		}
+	}
+
+	return *chip && *fast;
+}
+
+/*
+ * Submit one burst of copies, wait for all of them and verify, then
+ * copy the same bytes with CopyMem()
+ * Returns number of failed requests; the three times are filled in
+ */
+static ULONG RunBurst(UBYTE *src, UBYTE *dst, const char *name,
+                      ULONG *submit_us, ULONG *total_us, ULONG *cpu_us)
+{
+	struct DMACopyRequest *reqs[COPYTEST_REQUESTS];
+	struct EClockVal t0, t1, t2, t3;
+	ULONG i, failed = 0;
+	LONG status;
+
+	memset(dst, COPYTEST_FILL, TEST_BUFFER_SIZE);
+
+	ReadTimer(&t0);
+	for (i = 0; i < COPYTEST_REQUESTS; i++)
+		reqs[i] = DMACopySubmit(src + i * COPYTEST_CHUNK, dst + i * COPYTEST_CHUNK,
+		                        COPYTEST_CHUNK, 0);
+	ReadTimer(&t1);
+
+	for (i = 0; i < COPYTEST_REQUESTS; i++) {
+		if (!reqs[i]) {
+			failed++;
+			continue;
+		}
+		status = DMACopyWait(reqs[i]);
+		if (status != DMACOPY_DONE) {
+			dbgprintf("  FAILED %s request %ld: status %ld\n", name, i, status);
+			failed++;
+		} else if (memcmp(src + i * COPYTEST_CHUNK, dst + i * COPYTEST_CHUNK,
+		                  COPYTEST_CHUNK) != 0) {
+			dbgprintf("  FAILED %s request %ld: data mismatch\n", name, i);
+			failed++;
+		}
+		DMACopyFree(reqs[i]);
+	}
+	ReadTimer(&t2);
+
+	// Same bytes by the CPU
+	CopyMem(src, dst, TEST_BUFFER_SIZE);
+	ReadTimer(&t3);
+
+	*submit_us = ElapsedMicros(&t0, &t1);
+	*total_us = ElapsedMicros(&t0, &t2);
+	*cpu_us = ElapsedMicros(&t2, &t3);
+
+	return failed;
+}
+
+/*
+ * StatsRuns() bursts in one direction, min/median/p99 of DMA and CopyMem()
+ * Returns number of failed requests
+ */
+static ULONG CopyBurst(UBYTE *src, UBYTE *dst, const char *name)
+{
+	ULONG submit_samples[STATS_MAX_REPS], total_samples[STATS_MAX_REPS];
+	ULONG cpu_samples[STATS_MAX_REPS];
+	struct SampleSet submit_set, total_set, cpu_set;
+	struct SampleStats submit_st, total_st, cpu_st;
+	ULONG run, submit_us, total_us, cpu_us, failed = 0;
+
+	FillPattern(src, TEST_BUFFER_SIZE, PATTERN_RANDOM);
+
+	StatsBegin(&submit_set, submit_samples);
+	StatsBegin(&total_set, total_samples);
+	StatsBegin(&cpu_set, cpu_samples);
+	for (run = 0; run < StatsRuns(); run++) {
+		failed += RunBurst(src, dst, name, &submit_us, &total_us, &cpu_us);
+		StatsAdd(&submit_set, submit_us);
+		StatsAdd(&total_set, total_us);
+		StatsAdd(&cpu_set, cpu_us);
+	}
+	StatsCompute(&submit_set, &submit_st);
+	StatsCompute(&total_set, &total_st);
+	StatsCompute(&cpu_set, &cpu_st);
+
+	dbgprintf("  %-12s %ld x %ld bytes, %ld us median submit\n",
+	          name, (ULONG)COPYTEST_REQUESTS, (ULONG)COPYTEST_CHUNK, submit_st.median_us);
+	dbgprintf("    DMA    ");
+	PrintRateStats(TEST_BUFFER_SIZE, &total_st);
+	dbgprintf("\n    CopyMem");
+	PrintRateStats(TEST_BUFFER_SIZE, &cpu_st);
+	dbgprintf("\n");
+
+	return failed;
+}
+
+/*
+ * Cancel the last of a burst - it should still be queued or batched
+ * Returns number of failures
+ */
+static ULONG CancelTest(UBYTE *src, UBYTE *dst)
+{
+	struct DMACopyRequest *reqs[4];
+	ULONG i, failed = 0;
+	LONG status;
+
+	FillPattern(src, 4 * COPYTEST_CHUNK, PATTERN_RANDOM);
+	memset(dst, COPYTEST_FILL, 4 * COPYTEST_CHUNK);
+
+	for (i = 0; i < 4; i++)
+		reqs[i] = DMACopySubmit(src + i * COPYTEST_CHUNK, dst + i * COPYTEST_CHUNK,
+		                        COPYTEST_CHUNK, 0);
+
+	if (!reqs[3]) {
+		dbgprintf("  FAILED cancel: could not submit\n");
+		failed++;
+		status = DMACOPY_ERROR;
+	} else {
+		status = DMACopyCancel(reqs[3]);
+	}
+
+	for (i = 0; i < 3; i++) {
+		if (reqs[i]) {
+			if (DMACopyWait(reqs[i]) != DMACOPY_DONE)
+				failed++;
+			DMACopyFree(reqs[i]);
+		}
+	}
+	if (reqs[3])
+		DMACopyFree(reqs[3]);
+
+	if (status == DMACOPY_CANCELLED) {
+		for (i = 0; i < COPYTEST_CHUNK; i++) {
+			if (dst[3 * COPYTEST_CHUNK + i] != COPYTEST_FILL) {
+				dbgprintf("  FAILED cancel: cancelled request wrote byte %ld\n", i);
+				failed++;
+				break;
+			}
+		}
+		dbgprintf("  Cancel:      queued request cancelled, destination untouched\n");
+	} else if (status == DMACOPY_PENDING || status == DMACOPY_DONE) {
+		dbgprintf("  Cancel:      request had already started - not cancelled\n");
+	}
+
+	if (memcmp(src, dst, 3 * COPYTEST_CHUNK) != 0) {
+		dbgprintf("  FAILED cancel: requests before the cancelled one corrupted\n");
+		failed++;
+	}
+
+	return failed;
+}
+
+/*
+ * Poll one large copy and count how often the CPU got control back
+ * Returns number of failures
+ */
+static ULONG PollTest(UBYTE *src, UBYTE *dst)
+{
+	struct DMACopyRequest *req;
+	ULONG polls = 0;
+	LONG status;
+
+	FillPattern(src, TEST_BUFFER_SIZE, PATTERN_WALKING);
+
+	req = DMACopySubmit(src, dst, TEST_BUFFER_SIZE, 0);
+	if (!req) {
+		dbgprintf("  FAILED poll: could not submit %ld bytes\n", (ULONG)TEST_BUFFER_SIZE);
+		return 1;
+	}
+
+	while ((status = DMACopyPoll(req)) == DMACOPY_PENDING)
+		polls++;
+	DMACopyFree(req);
+
+	dbgprintf("  Poll:        %ld bytes in one request, %ld polls while the chip copied\n",
+	          (ULONG)TEST_BUFFER_SIZE, polls);
+
+	if (status != DMACOPY_DONE || memcmp(src, dst, TEST_BUFFER_SIZE) != 0) {
+		dbgprintf("  FAILED poll: status %ld\n", status);
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Run the DMA copy library through bursts, cancellation and polling
+ * The library installs its own interrupt server - the caller must have
+ * removed the test one
+ */
+void TestDMACopyLib(volatile struct ncr710 *ncr)
+{
+	struct DMACopyStats stats;
+	UBYTE *chip, *fast;
+	ULONG failed = 0;
+
+	dbgprintf("\n=== Asynchronous DMA Copy Library ===\n");
+
+	if (!PickBuffers(&chip, &fast)) {
+		dbgprintf("ERROR: Need a CHIP and a FAST test buffer\n");
+		return;
+	}
+
+	if (DMACopyInit(ncr) < 0)
+		return;
+
+	dbgprintf("Pool %ld requests, %ld moves per batch, CHIP 0x%08lx, FAST 0x%08lx\n",
+	          (ULONG)DMACOPY_POOL_SIZE, (ULONG)DMACOPY_BATCH_MOVES, (ULONG)chip, (ULONG)fast);
+	PrintStatsConfig();
+	dbgprintf("\n");
+
+	failed += CopyBurst(fast, chip, "FAST->CHIP");
+	failed += CopyBurst(chip, fast, "CHIP->FAST");
+	failed += CancelTest(fast, chip);
+	failed += PollTest(chip, fast);
+
+	DMACopyGetStats(&stats);
+	DMACopyCleanup();
+
+	dbgprintf("\n  %ld requests in %ld batches (largest %ld), %ld cancelled, %ld errors, %ld timeouts\n",
+	          stats.requests, stats.batches, stats.max_batch, stats.cancelled, stats.errors,
+	          stats.timeouts);
+	dbgprintf("\n=== DMA Copy Library %s (%ld failures) ===\n\n",
+	          failed ? "FAILED" : "PASSED", failed);
+	dbgflush();
+}
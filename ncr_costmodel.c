@@ -0,0 +1,202 @@
+/*
+ * NCR 53C710 DMA Test Tool - Linear transfer cost model
+ *
+ * MB/s at one size mixes two costs: a fixed one per transfer (script
+ * build, address translation and cache maintenance, the DSP write, the
+ * interrupt and the task switch back) and a per-byte one (the engine and
+ * the bus). This mode times single RunDMATest() calls at COSTMODEL_SIZES
+ * evenly spaced sizes per region pair and fits
+ *
+ *     time = overhead + bytes / bandwidth
+ *
+ * by least squares, with 95% confidence intervals for both terms. Integer
+ * arithmetic only: times in ns, the slope in ps per byte.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <exec/memory.h>
+#include <proto/exec.h>
+
+#define COSTMODEL_SAMPLES (COSTMODEL_SIZES * COSTMODEL_REPEATS)
+#define COSTMODEL_T95     197   // Student t (x100) for 95%, n - 2 > 100
+
+static ULONG g_sample_size[COSTMODEL_SAMPLES];
+static ULONG g_sample_us[COSTMODEL_SAMPLES];
+
+/* Fit result */
+struct CostModel {
+	LONG overhead_ns;	// Fixed cost per transfer
+	ULONG overhead_ci_ns;	// 95% half-width
+	ULONG ps_per_byte;	// Per-byte cost
+	ULONG ps_ci;		// 95% half-width
+	ULONG r2;		// Coefficient of determination x1000
+};
+
+/*
+ * Least-squares fit of us = a + b * bytes over n samples
+ * Returns 0 on success, -1 if the fit is degenerate
+ */
+static LONG FitCostModel(ULONG n, struct CostModel *m)
+{
+	long long sx = 0, sy = 0, sxx = 0, sxy = 0, syy = 0;
+	unsigned long long sse = 0, s2, mx2, var_a;
+	long long dx, dy, r;
+	LONG mean_x, mean_y_ns;
+	ULONG i;
+
+	if (n < 3)
+		return -1;
+
+	for (i = 0; i < n; i++) {
+		sx += g_sample_size[i];
+		sy += g_sample_us[i];
+	}
+	mean_x = sx / n;
+	mean_y_ns = (sy * 1000) / n;
+
+	// Centred sums keep the products inside 64 bits
+	for (i = 0; i < n; i++) {
+		dx = (long long)g_sample_size[i] - mean_x;
+		dy = (long long)g_sample_us[i] * 1000 - mean_y_ns;
+		sxx += dx * dx;
+		sxy += dx * dy;
+		syy += dy * dy;
+	}
+	if (sxx <= 0 || sxy <= 0)
+		return -1;
+
+	// sxy is in ns*bytes, so ns/byte * 1000 = ps/byte
+	m->ps_per_byte = (sxy * 1000) / sxx;
+	m->overhead_ns = mean_y_ns - ((long long)m->ps_per_byte * mean_x) / 1000;
+
+	for (i = 0; i < n; i++) {
+		r = (long long)g_sample_us[i] * 1000 - m->overhead_ns -
+		    ((long long)m->ps_per_byte * g_sample_size[i]) / 1000;
+		sse += r * r;
+	}
+
+	s2 = sse / (n - 2);
+	m->ps_ci = (ISqrt64((s2 * 1000000) / sxx) * COSTMODEL_T95) / 100;
+
+	// var(a) = s2 * (1/n + mean_x^2 / sxx); divide last unless s2 * mean_x^2
+	// would not fit in 64 bits
+	mx2 = (unsigned long long)mean_x * mean_x;
+	if (mx2 && s2 > ~0ULL / mx2)
+		var_a = (s2 / sxx) * mx2;
+	else
+		var_a = (s2 * mx2) / sxx;
+	m->overhead_ci_ns = (ISqrt64(s2 / n + var_a) * COSTMODEL_T95) / 100;
+	m->r2 = (syy && sse <= (unsigned long long)syy) ? 1000 - (ULONG)((sse * 1000) / syy) : 0;
+
+	return 0;
+}
+
+/*
+ * Bytes per us (= MB/s) in hundredths for a cost in ps per byte
+ */
+static ULONG PsToRate(ULONG ps)
+{
+	return ps ? 100000000UL / ps : 0;
+}
+
+/*
+ * Time single transfers for one region pair
+ * Sizes are interleaved so slow drift spreads over all of them
+ * Returns number of samples, 0 on failure; *cache_us gets the average
+ * cache maintenance time per transfer
+ */
+static ULONG SamplePair(volatile struct ncr710 *ncr, UBYTE *src, UBYTE *dst,
+                        ULONG *cache_us)
+{
+	struct EClockVal t0, t1;
+	ULONG rep, i, size, n = 0;
+
+	FillPattern(src, MAX_TEST_SIZE, PATTERN_RANDOM);
+
+	// Warm up code paths and the interrupt server
+	if (RunDMATest(ncr, src, dst, MIN_TEST_SIZE) != TEST_SUCCESS)
+		return 0;
+
+	ResetCacheStats();
+	for (rep = 0; rep < COSTMODEL_REPEATS; rep++) {
+		for (i = 0; i < COSTMODEL_SIZES; i++) {
+			size = MIN_TEST_SIZE +
+			       (i * (MAX_TEST_SIZE - MIN_TEST_SIZE)) / (COSTMODEL_SIZES - 1);
+
+			ReadTimer(&t0);
+			if (RunDMATest(ncr, src, dst, size) != TEST_SUCCESS)
+				return 0;
+			ReadTimer(&t1);
+
+			g_sample_size[n] = size;
+			g_sample_us[n] = ElapsedMicros(&t0, &t1);
+			n++;
+		}
+	}
+	*cache_us = GetCacheMicros() / n;
+
+	return n;
+}
+
+/*
+ * Fit the cost model for every region pair
+ */
+void TestCostModel(volatile struct ncr710 *ncr)
+{
+	struct CostModel m;
+	int src_idx, dst_idx;
+	ULONG n, cache_us, rate, rate_lo, rate_hi, share, abs_ns;
+	char overhead[16];
+
+	dbgprintf("\n=== DMA Transfer Cost Model ===\n");
+	dbgprintf("time = overhead + bytes / bandwidth, least squares over %ld sizes\n",
+	          (ULONG)COSTMODEL_SIZES);
+	dbgprintf("%ld-%ld bytes, %ld runs each; +/- is the 95%% confidence interval\n\n",
+	          (ULONG)MIN_TEST_SIZE, (ULONG)MAX_TEST_SIZE, (ULONG)COSTMODEL_REPEATS);
+
+	for (src_idx = 0; src_idx < g_num_test_buffers; src_idx += 2) {
+		for (dst_idx = 1; dst_idx < g_num_test_buffers; dst_idx += 2) {
+			UBYTE *src = *g_test_buffers[src_idx].buf;
+			UBYTE *dst = *g_test_buffers[dst_idx].buf;
+
+			if (!src || !dst)
+				continue;
+
+			dbgprintf("%-9s -> %-9s ", g_test_buffers[src_idx].name,
+			          g_test_buffers[dst_idx].name);
+
+			n = SamplePair(ncr, src, dst, &cache_us);
+			if (!n || FitCostModel(n, &m) < 0) {
+				dbgprintf("FAILED\n");
+				continue;
+			}
+
+			rate = PsToRate(m.ps_per_byte);
+			rate_lo = PsToRate(m.ps_per_byte + m.ps_ci);
+			rate_hi = (m.ps_ci < m.ps_per_byte) ? PsToRate(m.ps_per_byte - m.ps_ci) : 0;
+			share = (m.overhead_ns > 0) ?
+			        (ULONG)(((long long)m.overhead_ns * 100) /
+			                (m.overhead_ns + ((long long)m.ps_per_byte * 4096) / 1000)) : 0;
+
+			// Sign apart: a fit just below zero must not print as positive
+			abs_ns = (m.overhead_ns < 0) ? -m.overhead_ns : m.overhead_ns;
+			sprintf(overhead, "%s%ld.%01ld", (m.overhead_ns < 0) ? "-" : "",
+			        abs_ns / 1000, (abs_ns % 1000) / 100);
+
+			dbgprintf("overhead %6s +/- %ld.%01ld us (cache %ld us), "
+			          "%ld.%02ld MB/s (%ld.%02ld-%ld.%02ld), R2 %ld.%03ld, "
+			          "%ld%% of a 4 KB transfer\n",
+			          overhead,
+			          m.overhead_ci_ns / 1000, (m.overhead_ci_ns % 1000) / 100, cache_us,
+			          rate / 100, rate % 100, rate_lo / 100, rate_lo % 100,
+			          rate_hi / 100, rate_hi % 100, m.r2 / 1000, m.r2 % 1000, share);
+			dbgflush();
+		}
+	}
+
+	dbgprintf("\nA large overhead share means the setup path (script, cache,\n");
+	dbgprintf("interrupt) is the place to optimise; a low MB/s means the engine or bus.\n");
+	dbgprintf("\n=== Cost Model Complete ===\n\n");
+	dbgflush();
+}
@@ -0,0 +1,266 @@
+/*
+ * NCR 53C710 DMA Test Tool - DMA vs CPU copy crossover
+ *
+ * For every source/destination pair of the region sweep, times CopyMem(),
+ * CopyMemQuick() and a move16 loop against RunDMATest() across sizes.
+ * The DMA figure is the whole call: script build, address translation,
+ * cache maintenance, the interrupt and the task switch back. The crossover
+ * is the smallest size from which DMA beats the best CPU method at every
+ * larger size too - the point where offloading a copy starts to pay.
+ * Every figure is the median of StatsRuns() timings.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/memory.h>
+#include <proto/exec.h>
+
+#define MAX_CROSSOVER_PAIRS 64
+#define CROSSOVER_NEVER     0xFFFFFFFF
+
+/* CPU copy methods */
+#define CPU_COPYMEM       0
+#define CPU_COPYMEMQUICK  1
+#define CPU_MOVE16        2
+#define NUM_CPU_METHODS   3
+
+static const char *cpu_method_names[NUM_CPU_METHODS] = {
+	"CopyMem", "Quick", "move16"
+};
+
+/*
+ * Copy with move16 - src, dst 16-byte aligned, size a multiple of 16
+ */
+static void Move16Copy(UBYTE *src, UBYTE *dst, ULONG size)
+{
+	ULONG lines = size / 16;
+
+	__asm__ volatile (
+		"1:	move16	(%0)+,(%1)+\n\t"
+		"	subq.l	#1,%2\n\t"
+		"	bne.s	1b"
+		: "+a" (src), "+a" (dst), "+d" (lines)
+		:
+		: "cc", "memory");
+}
+
+/*
+ * Time 'iter' copies by one CPU method
+ * Returns microseconds
+ */
+static ULONG TimeCPUCopy(ULONG method, UBYTE *src, UBYTE *dst, ULONG size, ULONG iter)
+{
+	struct EClockVal t0, t1;
+	ULONG i;
+
+	ReadTimer(&t0);
+	for (i = 0; i < iter; i++) {
+		switch (method) {
+		case CPU_COPYMEM:
+			CopyMem(src, dst, size);
+			break;
+		case CPU_COPYMEMQUICK:
+			CopyMemQuick(src, dst, size);
+			break;
+		case CPU_MOVE16:
+			Move16Copy(src, dst, size);
+			break;
+		}
+	}
+	ReadTimer(&t1);
+
+	return ElapsedMicros(&t0, &t1);
+}
+
+/*
+ * Time 'iter' DMA transfers and verify the last one
+ * Returns microseconds, 0 on failure; *cache_us gets the part spent on
+ * cache maintenance
+ */
+static ULONG TimeDMACopy(volatile struct ncr710 *ncr, UBYTE *src, UBYTE *dst,
+                         ULONG size, ULONG iter, ULONG *cache_us)
+{
+	struct EClockVal t0, t1;
+	struct TestResult result;
+	ULONG i;
+
+	FillPattern(dst, size, PATTERN_ZEROS);
+	ResetCacheStats();
+
+	ReadTimer(&t0);
+	for (i = 0; i < iter; i++) {
+		if (RunDMATest(ncr, src, dst, size) != TEST_SUCCESS)
+			return 0;
+	}
+	ReadTimer(&t1);
+	*cache_us = GetCacheMicros();
+
+	if (VerifyBuffer(src, dst, size, &result) != TEST_SUCCESS)
+		return 0;
+
+	return ElapsedMicros(&t0, &t1);
+}
+
+/*
+ * StatsRuns() timings of 'iter' copies by one CPU method
+ * Returns the median run time
+ */
+static ULONG MedianCPUCopy(ULONG method, UBYTE *src, UBYTE *dst, ULONG size,
+                           ULONG iter, struct SampleStats *st)
+{
+	ULONG run_us[STATS_MAX_REPS];
+	struct SampleSet set;
+	ULONG run;
+
+	StatsBegin(&set, run_us);
+	for (run = 0; run < StatsRuns(); run++)
+		StatsAdd(&set, TimeCPUCopy(method, src, dst, size, iter));
+	StatsCompute(&set, st);
+
+	return st->median_us;
+}
+
+/*
+ * StatsRuns() timings of 'iter' DMA transfers
+ * Returns the median run time, 0 if any run failed; *cache_us gets the
+ * mean cache maintenance time of the kept (non warm-up) runs
+ */
+static ULONG MedianDMACopy(volatile struct ncr710 *ncr, UBYTE *src, UBYTE *dst,
+                           ULONG size, ULONG iter, ULONG *cache_us,
+                           struct SampleStats *st)
+{
+	ULONG run_us[STATS_MAX_REPS];
+	struct SampleSet set;
+	ULONG run, us, cache = 0, cache_sum = 0;
+
+	StatsBegin(&set, run_us);
+	for (run = 0; run < StatsRuns(); run++) {
+		us = TimeDMACopy(ncr, src, dst, size, iter, &cache);
+		if (!us)
+			return 0;
+		StatsAdd(&set, us);
+		if (run >= set.warmup)
+			cache_sum += cache;
+	}
+	StatsCompute(&set, st);
+
+	*cache_us = st->n ? cache_sum / st->n : 0;
+	return st->median_us;
+}
+
+/*
+ * Measure one region pair across sizes
+ * Returns the crossover size, CROSSOVER_NEVER if DMA never wins for good
+ */
+static ULONG MeasurePair(volatile struct ncr710 *ncr, int src_idx, int dst_idx)
+{
+	// 16-byte aligned for move16, all methods use the same addresses
+	UBYTE *src = (UBYTE *)(((ULONG)*g_test_buffers[src_idx].buf + 15) & ~15UL);
+	UBYTE *dst = (UBYTE *)(((ULONG)*g_test_buffers[dst_idx].buf + 15) & ~15UL);
+	BOOL chip = ((TypeOfMem(src) | TypeOfMem(dst)) & MEMF_CHIP) != 0;
+	ULONG crossover = CROSSOVER_NEVER;
+	ULONG size, iter, m, dma_us, cache_us, best_us;
+	struct SampleStats st;
+
+	dbgprintf("\n%s -> %s (min/median/p99)\n", g_test_buffers[src_idx].name,
+	          g_test_buffers[dst_idx].name);
+
+	for (size = CROSSOVER_MIN_SIZE; size <= MAX_TEST_SIZE; size *= 2) {
+		iter = CROSSOVER_BYTES / size;
+		if (iter < CROSSOVER_MIN_ITERATIONS)
+			iter = CROSSOVER_MIN_ITERATIONS;
+
+		FillPattern(src, size, PATTERN_RANDOM);
+
+		dbgprintf("  %5ld bytes:\n", size);
+		best_us = 0;
+		for (m = 0; m < NUM_CPU_METHODS; m++) {
+			ULONG us;
+
+			// move16 needs line bursts, which CHIP RAM does not take
+			if (m == CPU_MOVE16 && chip)
+				continue;
+			us = MedianCPUCopy(m, src, dst, size, iter, &st);
+			dbgprintf("    %-8s", cpu_method_names[m]);
+			PrintRateStats(size * iter, &st);
+			dbgprintf("\n");
+			if (!best_us || us < best_us)
+				best_us = us;
+		}
+
+		dma_us = MedianDMACopy(ncr, src, dst, size, iter, &cache_us, &st);
+		if (!dma_us) {
+			dbgprintf("    DMA      FAILED\n");
+			crossover = CROSSOVER_NEVER;
+			continue;
+		}
+
+		dbgprintf("    %-8s", "DMA");
+		PrintRateStats(size * iter, &st);
+		dbgprintf(" cache %ld%% - %s wins\n", (cache_us * 100) / dma_us,
+		          (dma_us < best_us) ? "DMA" : "CPU");
+
+		// DMA must win at every larger size too
+		if (dma_us < best_us) {
+			if (crossover == CROSSOVER_NEVER)
+				crossover = size;
+		} else {
+			crossover = CROSSOVER_NEVER;
+		}
+	}
+	dbgflush();
+
+	return crossover;
+}
+
+/*
+ * Run every source/destination pair of the region sweep
+ */
+void TestCopyCrossover(volatile struct ncr710 *ncr)
+{
+	ULONG crossover[MAX_CROSSOVER_PAIRS];
+	int src_idx, dst_idx;
+	ULONG pair = 0;
+
+	dbgprintf("\n=== DMA vs CPU Copy Crossover ===\n");
+	dbgprintf("%ld bytes (at least %ld copies) per size and method, MB/s.\n",
+	          (ULONG)CROSSOVER_BYTES, (ULONG)CROSSOVER_MIN_ITERATIONS);
+	dbgprintf("DMA includes script setup, cache maintenance and the interrupt;\n");
+	dbgprintf("cache%% is the part of the DMA time spent in cache maintenance.\n");
+	PrintStatsConfig();
+
+	for (src_idx = 0; src_idx < g_num_test_buffers; src_idx++) {
+		for (dst_idx = 0; dst_idx < g_num_test_buffers; dst_idx++) {
+			if (src_idx == dst_idx || pair >= MAX_CROSSOVER_PAIRS)
+				continue;
+
+			if (!*g_test_buffers[src_idx].buf || !*g_test_buffers[dst_idx].buf)
+				crossover[pair] = 0;
+			else
+				crossover[pair] = MeasurePair(ncr, src_idx, dst_idx);
+			pair++;
+		}
+	}
+
+	dbgprintf("\n=== Crossover Summary ===\n");
+	pair = 0;
+	for (src_idx = 0; src_idx < g_num_test_buffers; src_idx++) {
+		for (dst_idx = 0; dst_idx < g_num_test_buffers; dst_idx++) {
+			if (src_idx == dst_idx || pair >= MAX_CROSSOVER_PAIRS)
+				continue;
+
+			dbgprintf("  %-9s(%ld) -> %-9s(%ld): ", g_test_buffers[src_idx].name, (ULONG)src_idx,
+			          g_test_buffers[dst_idx].name, (ULONG)dst_idx);
+			if (crossover[pair] == 0)
+				dbgprintf("not tested\n");
+			else if (crossover[pair] == CROSSOVER_NEVER)
+				dbgprintf("CPU at every size up to %ld\n", (ULONG)MAX_TEST_SIZE);
+			else
+				dbgprintf("DMA from %ld bytes\n", crossover[pair]);
+			pair++;
+		}
+	}
+	dbgprintf("\n");
+	dbgflush();
+}
@@ -0,0 +1,686 @@
+/*
+ * NCR 53C710 DMA Test Tool - Asynchronous DMA copy library
+ *
+ * Tools that spend CPU time on large CHIP<->FAST copies can hand them to
+ * the otherwise idle memory-move engine. Requests come from a fixed pool.
+ * Each is mapped (DMAMapRange) and turned into memory moves when it is
+ * submitted. Requests are then batched: one SCRIPTS buffer runs while
+ * the other collects the requests submitted meanwhile. The interrupt
+ * server completes the running batch, signals its owners and starts the
+ * collected batch straight away, so the chip stays busy without the
+ * submitting task.
+ *
+ * The SCRIPTS instruction builders shared by all the tools live here too.
+ */
+
+#include "ncr_dmacopy.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/memory.h>
+#include <exec/interrupts.h>
+#include <hardware/intbits.h>
+#include <devices/timer.h>
+#include <proto/exec.h>
+#include <clib/alib_protos.h>
+
+/* One SCRIPTS buffer and the requests it carries */
+struct DMACopyBatch {
+	struct memmove_inst *script;
+	ULONG phys;
+	ULONG nmoves;
+	ULONG nreqs;
+	ULONG bytes;			// Sum of the requests' lengths
+	struct DMACopyRequest *reqs[DMACOPY_POOL_SIZE];
+};
+
+static volatile struct ncr710 *g_dc_ncr = NULL;
+static struct DMACopyRequest g_dc_pool[DMACOPY_POOL_SIZE];
+static struct DMACopyBatch g_dc_batch[2];
+static struct DMACopyBatch *volatile g_dc_running = NULL;	// NULL = chip idle
+static struct DMACopyBatch *g_dc_open = NULL;			// Starts next
+static struct DMACopyRequest *g_dc_queue = NULL;		// Waiting for a batch
+static struct DMACopyStats g_dc_stats;
+static struct Interrupt g_dc_int;
+static struct Task *g_dc_task = NULL;
+static ULONG g_dc_sigmask = 0;
+static LONG g_dc_sigbit = -1;
+static volatile BOOL g_dc_closing = FALSE;
+static volatile BOOL g_dc_aborting = FALSE;	// Running batch is being aborted
+static struct timerequest g_dc_timer;		// Template for bounded waits
+static BOOL g_dc_timer_open = FALSE;
+
+/*
+ * Fill in a memory-to-memory move instruction
+ */
+void BuildMemMove(struct memmove_inst *inst, ULONG src, ULONG dst, ULONG len)
+{
+	inst->op = 0xC0;  // Memory move opcode
+	inst->len[0] = (len >> 16) & 0xFF;
+	inst->len[1] = (len >> 8) & 0xFF;
+	inst->len[2] = len & 0xFF;
+	inst->source = src;
+	inst->dest = dst;
+}
+
+/*
+ * Fill in an INT instruction (interrupt always, magic ends up in DSPS)
+ */
+void BuildIntInst(struct jump_inst *inst, ULONG magic)
+{
+	inst->op = 0x98;       // Interrupt opcode
+	inst->control = 0x08;  // Interrupt always
+	inst->mask = 0x00;
+	inst->data = 0x00;
+	inst->addr = magic;
+}
+
+/*
+ * Fill in an unconditional JUMP to a physical address
+ */
+void BuildJumpInst(struct jump_inst *inst, ULONG addr)
+{
+	inst->op = 0x80;       // Jump opcode
+	inst->control = 0x08;  // Jump if true, no compare - always
+	inst->mask = 0x00;
+	inst->data = 0x00;
+	inst->addr = addr;
+}
+
+/*
+ * Emit memory moves for one transfer whose source and destination may
+ * each be split into several physical segments - a new move starts
+ * wherever either side crosses a discontinuity
+ * Returns number of moves written, 0 if max_moves was not enough
+ */
+ULONG EmitMemMoves(struct memmove_inst *moves, ULONG max_moves,
+                   struct DMASegment *src, ULONG nsrc,
+                   struct DMASegment *dst, ULONG ndst)
+{
+	ULONG n = 0, si = 0, di = 0, soff = 0, doff = 0;
+	ULONG len;
+
+	while (si < nsrc && di < ndst) {
+		len = src[si].len - soff;
+		if (dst[di].len - doff < len)
+			len = dst[di].len - doff;
+		if (len > MAX_MOVE_SIZE)
+			len = MAX_MOVE_SIZE;
+
+		if (n >= max_moves)
+			return 0;
+
+		BuildMemMove(&moves[n++], src[si].phys + soff, dst[di].phys + doff, len);
+
+		soff += len;
+		doff += len;
+		if (soff == src[si].len) {
+			si++;
+			soff = 0;
+		}
+		if (doff == dst[di].len) {
+			di++;
+			doff = 0;
+		}
+	}
+
+	return n;
+}
+
+/*
+ * Start a batch - called with interrupts disabled, from a task or from
+ * the interrupt server. The other buffer becomes the open batch.
+ */
+static void StartBatch(struct DMACopyBatch *b)
+{
+	ULONG i;
+
+	for (i = 0; i < b->nreqs; i++)
+		b->reqs[i]->state = DMACOPY_RUNNING;
+
+	g_dc_stats.batches++;
+	if (b->nreqs > g_dc_stats.max_batch)
+		g_dc_stats.max_batch = b->nreqs;
+
+	g_dc_running = b;
+	g_dc_open = (b == &g_dc_batch[0]) ? &g_dc_batch[1] : &g_dc_batch[0];
+	g_dc_open->nmoves = 0;
+	g_dc_open->nreqs = 0;
+	g_dc_open->bytes = 0;
+
+	WRITE_LONG(g_dc_ncr, dsp, b->phys);
+}
+
+/*
+ * Complete the running batch with status, signal its owners and start the
+ * open batch unless an abort is being drained - called with interrupts
+ * disabled
+ */
+static void CompleteRunning(LONG status)
+{
+	struct DMACopyBatch *b = g_dc_running;
+	struct DMACopyRequest *r;
+	ULONG i;
+
+	for (i = 0; i < b->nreqs; i++) {
+		r = b->reqs[i];
+		r->status = status;
+		r->state = DMACOPY_COMPLETE;
+		Signal(r->task, r->signal_mask);
+	}
+
+	g_dc_running = NULL;
+	if (g_dc_open->nreqs && !g_dc_aborting)
+		StartBatch(g_dc_open);
+
+	// Queued owners have to move their requests into the new open batch
+	for (r = g_dc_queue; r; r = r->next)
+		Signal(r->task, r->signal_mask);
+
+	if (g_dc_closing)
+		Signal(g_dc_task, g_dc_sigmask);
+}
+
+/*
+ * Interrupt server - completes the running batch and starts the open one
+ */
+static ULONG __attribute__((saveds))
+DMACopyInterrupt(void)
+{
+	volatile struct ncr710 *ncr = g_dc_ncr;
+	UBYTE istat, dstat;
+	ULONG dsps;
+	LONG status;
+
+	istat = ncr->istat;
+	if (!(istat & ISTATF_DIP))
+		return 0;  // Not our interrupt
+
+	dstat = ncr->dstat;
+	dsps = ncr->dsps;
+
+	if (!g_dc_running)
+		return 1;
+
+	if (g_dc_aborting)
+		status = DMACOPY_TIMEOUT;
+	else if ((dstat & DSTATF_SIR) && dsps == DMACOPY_MAGIC)
+		status = DMACOPY_DONE;
+	else
+		status = DMACOPY_ERROR;
+	if (status == DMACOPY_ERROR)
+		g_dc_stats.errors++;
+
+	CompleteRunning(status);
+
+	return 1;
+}
+
+/*
+ * Append a request to the open batch and push the new instructions to RAM
+ * Called with interrupts disabled. Returns FALSE if the batch is full.
+ */
+static BOOL AppendToBatch(struct DMACopyBatch *b, struct DMACopyRequest *req)
+{
+	ULONG start = b->nmoves;
+
+	if (b->nmoves + req->nmoves > DMACOPY_BATCH_MOVES)
+		return FALSE;
+
+	// Buffer ran before - finish that use first
+	if (start == 0)
+		DMACachePost(b->script, DMACOPY_SCRIPT_SIZE, DMA_DIR_READ);
+
+	memcpy(&b->script[start], req->moves, req->nmoves * sizeof(struct memmove_inst));
+	b->nmoves += req->nmoves;
+	BuildIntInst((struct jump_inst *)&b->script[b->nmoves], DMACOPY_MAGIC);
+
+	b->reqs[b->nreqs++] = req;
+	b->bytes += req->len;
+	req->state = DMACOPY_BATCHED;
+
+	DMACachePre(&b->script[start],
+	            req->nmoves * sizeof(struct memmove_inst) + sizeof(struct jump_inst),
+	            DMA_DIR_READ);
+
+	return TRUE;
+}
+
+/*
+ * Move queued requests into the open batch and start it if the chip is idle
+ */
+static void Kick(void)
+{
+	struct DMACopyRequest *r;
+
+	Disable();
+
+	while ((r = g_dc_queue) != NULL && AppendToBatch(g_dc_open, r))
+		g_dc_queue = r->next;
+
+	if (!g_dc_running && g_dc_open->nreqs && !g_dc_aborting)
+		StartBatch(g_dc_open);
+
+	Enable();
+}
+
+/*
+ * Cache maintenance once a request is complete (task context)
+ */
+static void FinishRequest(struct DMACopyRequest *req)
+{
+	if (req->finished)
+		return;
+
+	DMACachePost(req->dst, req->len, DMA_DIR_WRITE);
+	DMACachePost(req->src, req->len, DMA_DIR_READ);
+	req->finished = 1;
+}
+
+/*
+ * The running batch missed its deadline: abort the chip, and fail the
+ * batch ourselves if the abort interrupt never comes. Nothing new is
+ * started until the abort has been drained.
+ */
+static void AbortRunning(void)
+{
+	volatile struct ncr710 *ncr = g_dc_ncr;
+	struct DMACopyBatch *aborted;
+
+	Disable();
+	aborted = g_dc_running;
+	if (!aborted) {
+		Enable();
+		return;
+	}
+	g_dc_stats.timeouts++;
+	g_dc_aborting = TRUE;
+	ncr->istat |= ISTATF_ABRT;
+	Enable();
+
+	poll_cia(DMACOPY_ABORT_US);
+
+	Disable();
+	ncr->istat = 0;
+	(void)ncr->dstat;
+	if (g_dc_running == aborted)
+		CompleteRunning(DMACOPY_TIMEOUT);
+	g_dc_aborting = FALSE;
+	Enable();
+
+	Kick();
+}
+
+/*
+ * Deadline for everything submitted so far: DMACOPY_TIMEOUT_MS plus the
+ * time its bytes take at DMACOPY_MIN_RATE
+ */
+static ULONG DeadlineMs(void)
+{
+	struct DMACopyRequest *r;
+	ULONG bytes;
+
+	Disable();
+	bytes = g_dc_open->bytes;
+	if (g_dc_running)
+		bytes += g_dc_running->bytes;
+	for (r = g_dc_queue; r; r = r->next)
+		bytes += r->len;
+	Enable();
+
+	return DMACOPY_TIMEOUT_MS + bytes / DMACOPY_MIN_RATE;
+}
+
+static BOOL RequestComplete(APTR req)
+{
+	return ((struct DMACopyRequest *)req)->state == DMACOPY_COMPLETE;
+}
+
+static BOOL ChipIdle(APTR unused)
+{
+	return g_dc_running == NULL;
+}
+
+/*
+ * Wait until done(arg), for at most DeadlineMs(); sigbit is the signal
+ * the interrupt server sends the calling task. On expiry the running
+ * batch is aborted.
+ * Returns TRUE if done(arg) came true in time
+ */
+static BOOL WaitBounded(BOOL (*done)(APTR), APTR arg, ULONG sigbit)
+{
+	struct MsgPort port;
+	struct timerequest tr;
+	ULONG ms;
+
+	Kick();
+	if (done(arg))
+		return TRUE;
+
+	// The timer replies on the same signal, so no extra signal is needed
+	// in a task that may not have one to spare (the CopyMem patch)
+	memset(&port, 0, sizeof(port));
+	port.mp_Node.ln_Type = NT_MSGPORT;
+	port.mp_Flags = PA_SIGNAL;
+	port.mp_SigBit = sigbit;
+	port.mp_SigTask = FindTask(NULL);
+	NewList(&port.mp_MsgList);
+
+	tr = g_dc_timer;
+	tr.tr_node.io_Message.mn_ReplyPort = &port;
+	tr.tr_node.io_Command = TR_ADDREQUEST;
+	ms = DeadlineMs();
+	tr.tr_time.tv_secs = ms / 1000;
+	tr.tr_time.tv_micro = (ms % 1000) * 1000;
+	SendIO(&tr.tr_node);
+
+	while (!done(arg) && !CheckIO(&tr.tr_node)) {
+		Wait(1UL << sigbit);
+		Kick();
+	}
+
+	if (!CheckIO(&tr.tr_node))
+		AbortIO(&tr.tr_node);
+	WaitIO(&tr.tr_node);
+
+	if (done(arg))
+		return TRUE;
+
+	AbortRunning();
+	return FALSE;
+}
+
+/*
+ * Bit number of the lowest signal in a mask
+ */
+static ULONG SignalBit(ULONG mask)
+{
+	ULONG bit = 0;
+
+	while (bit < 31 && !(mask & (1UL << bit)))
+		bit++;
+
+	return bit;
+}
+
+/*
+ * Install the interrupt server and allocate the batch buffers
+ * Returns 0 on success, -1 on failure
+ */
+LONG DMACopyInit(volatile struct ncr710 *ncr)
+{
+	ULONG i;
+
+	if (g_dc_ncr)
+		return 0;
+
+	for (i = 0; i < 2; i++) {
+		g_dc_batch[i].script = AllocScriptMem(DMACOPY_SCRIPT_SIZE);
+		if (!g_dc_batch[i].script) {
+			dbgprintf("ERROR: Could not allocate DMA copy SCRIPTS buffer\n");
+			DMACopyCleanup();
+			return -1;
+		}
+		g_dc_batch[i].phys = DMAPhysAddr(g_dc_batch[i].script);
+		g_dc_batch[i].nmoves = 0;
+		g_dc_batch[i].nreqs = 0;
+		g_dc_batch[i].bytes = 0;
+	}
+
+	g_dc_sigbit = AllocSignal(-1);
+	if (g_dc_sigbit == -1) {
+		dbgprintf("ERROR: Could not allocate signal\n");
+		DMACopyCleanup();
+		return -1;
+	}
+
+	// Every wait is bounded by a copy of this request
+	memset(&g_dc_timer, 0, sizeof(g_dc_timer));
+	if (OpenDevice(TIMERNAME, UNIT_MICROHZ, &g_dc_timer.tr_node, 0) != 0) {
+		dbgprintf("ERROR: Could not open %s\n", TIMERNAME);
+		DMACopyCleanup();
+		return -1;
+	}
+	g_dc_timer_open = TRUE;
+
+	memset(g_dc_pool, 0, sizeof(g_dc_pool));
+	memset(&g_dc_stats, 0, sizeof(g_dc_stats));
+	g_dc_task = FindTask(NULL);
+	g_dc_sigmask = 1L << g_dc_sigbit;
+	g_dc_open = &g_dc_batch[0];
+	g_dc_running = NULL;
+	g_dc_queue = NULL;
+	g_dc_closing = FALSE;
+	g_dc_aborting = FALSE;
+	g_dc_ncr = ncr;
+
+	g_dc_int.is_Node.ln_Type = NT_INTERRUPT;
+	g_dc_int.is_Node.ln_Pri = 127;
+	g_dc_int.is_Node.ln_Name = "NCR 53C710 DMA Copy";
+	g_dc_int.is_Data = NULL;
+	g_dc_int.is_Code = (VOID (*)())DMACopyInterrupt;
+
+	Disable();
+	(void)ncr->istat;
+	(void)ncr->dstat;
+	(void)ncr->sstat0;
+	AddIntServer(INTB_PORTS, &g_dc_int);
+	ncr->dien = DIENF_SIR | DIENF_IID | DIENF_ABRT;
+	Enable();
+
+	return 0;
+}
+
+/*
+ * Cancel everything not yet started, wait for the running batch (aborted
+ * once its deadline passes) and remove the interrupt server
+ */
+void DMACopyCleanup(void)
+{
+	ULONG i;
+
+	if (g_dc_ncr) {
+		for (i = 0; i < DMACOPY_POOL_SIZE; i++) {
+			if (g_dc_pool[i].state != DMACOPY_FREE)
+				DMACopyCancel(&g_dc_pool[i]);
+		}
+
+		g_dc_closing = TRUE;
+		while (!WaitBounded(ChipIdle, NULL, g_dc_sigbit))
+			;
+
+		g_dc_ncr->dien = 0;
+		RemIntServer(INTB_PORTS, &g_dc_int);
+
+		for (i = 0; i < DMACOPY_POOL_SIZE; i++) {
+			if (g_dc_pool[i].state == DMACOPY_COMPLETE)
+				FinishRequest(&g_dc_pool[i]);
+			g_dc_pool[i].state = DMACOPY_FREE;
+		}
+		g_dc_ncr = NULL;
+	}
+
+	if (g_dc_timer_open) {
+		CloseDevice(&g_dc_timer.tr_node);
+		g_dc_timer_open = FALSE;
+	}
+
+	if (g_dc_sigbit != -1) {
+		FreeSignal(g_dc_sigbit);
+		g_dc_sigbit = -1;
+	}
+
+	for (i = 0; i < 2; i++) {
+		if (g_dc_batch[i].script) {
+			FreeScriptMem(g_dc_batch[i].script, DMACOPY_SCRIPT_SIZE);
+			g_dc_batch[i].script = NULL;
+		}
+	}
+}
+
+/*
+ * Submit a copy request
+ * Returns the request, NULL if the pool is empty or the ranges need more
+ * than DMACOPY_MAX_MOVES memory moves
+ */
+struct DMACopyRequest *DMACopySubmit(APTR src, APTR dst, ULONG len, ULONG signal_mask)
+{
+	struct DMASegment src_segs[MAX_DMA_SEGMENTS], dst_segs[MAX_DMA_SEGMENTS];
+	struct DMACopyRequest *req = NULL, **tail;
+	ULONG nsrc, ndst, i;
+
+	if (!g_dc_ncr || len == 0)
+		return NULL;
+
+	Disable();
+	for (i = 0; i < DMACOPY_POOL_SIZE; i++) {
+		if (g_dc_pool[i].state == DMACOPY_FREE) {
+			req = &g_dc_pool[i];
+			req->state = DMACOPY_QUEUED;
+			break;
+		}
+	}
+	Enable();
+
+	if (!req)
+		return NULL;
+
+	req->next = NULL;
+	req->finished = 0;
+	req->status = DMACOPY_PENDING;
+	req->src = src;
+	req->dst = dst;
+	req->len = len;
+	req->task = FindTask(NULL);
+	req->signal_mask = signal_mask ? signal_mask : g_dc_sigmask;
+
+	nsrc = DMAMapRange(src, len, DMA_DIR_READ, src_segs, MAX_DMA_SEGMENTS);
+	ndst = DMAMapRange(dst, len, DMA_DIR_WRITE, dst_segs, MAX_DMA_SEGMENTS);
+	req->nmoves = (nsrc && ndst) ?
+	              EmitMemMoves(req->moves, DMACOPY_MAX_MOVES, src_segs, nsrc, dst_segs, ndst) : 0;
+
+	if (!req->nmoves) {
+		DMACachePost(dst, len, DMA_DIR_WRITE);
+		DMACachePost(src, len, DMA_DIR_READ);
+		req->state = DMACOPY_FREE;
+		return NULL;
+	}
+
+	Disable();
+	for (tail = &g_dc_queue; *tail; tail = &(*tail)->next)
+		;
+	*tail = req;
+	g_dc_stats.requests++;
+	Enable();
+
+	Kick();
+
+	return req;
+}
+
+/*
+ * Status of a request without waiting
+ */
+LONG DMACopyPoll(struct DMACopyRequest *req)
+{
+	Kick();
+
+	if (req->state != DMACOPY_COMPLETE)
+		return DMACOPY_PENDING;
+
+	FinishRequest(req);
+	return req->status;
+}
+
+/*
+ * Wait for a request to complete
+ * A batch that misses its deadline is aborted; a request queued behind
+ * it gets a fresh deadline once its own batch starts
+ */
+LONG DMACopyWait(struct DMACopyRequest *req)
+{
+	ULONG sigbit = SignalBit(req->signal_mask);
+
+	while (!WaitBounded(RequestComplete, req, sigbit))
+		;
+
+	FinishRequest(req);
+	return req->status;
+}
+
+/*
+ * Cancel a request that the chip has not started
+ * Returns DMACOPY_CANCELLED, DMACOPY_PENDING if it is already running, or
+ * the final status if it has completed
+ */
+LONG DMACopyCancel(struct DMACopyRequest *req)
+{
+	struct DMACopyRequest *keep[DMACOPY_POOL_SIZE];
+	struct DMACopyRequest **link;
+	ULONG i, n = 0;
+	LONG status;
+
+	Disable();
+
+	switch (req->state) {
+	case DMACOPY_QUEUED:
+		for (link = &g_dc_queue; *link && *link != req; link = &(*link)->next)
+			;
+		if (*link)
+			*link = req->next;
+		break;
+
+	case DMACOPY_BATCHED:
+		// Rebuild the open batch without it
+		for (i = 0; i < g_dc_open->nreqs; i++) {
+			if (g_dc_open->reqs[i] != req)
+				keep[n++] = g_dc_open->reqs[i];
+		}
+		g_dc_open->nmoves = 0;
+		g_dc_open->nreqs = 0;
+		g_dc_open->bytes = 0;
+		for (i = 0; i < n; i++)
+			AppendToBatch(g_dc_open, keep[i]);
+		break;
+
+	case DMACOPY_RUNNING:
+		Enable();
+		return DMACOPY_PENDING;
+
+	default:
+		Enable();
+		return req->status;
+	}
+
+	req->status = DMACOPY_CANCELLED;
+	req->state = DMACOPY_COMPLETE;
+	g_dc_stats.cancelled++;
+
+	Enable();
+
+	FinishRequest(req);
+	status = req->status;
+
+	return status;
+}
+
+/*
+ * Return a request to the pool (waits for it if the chip has started it)
+ */
+void DMACopyFree(struct DMACopyRequest *req)
+{
+	if (req->state != DMACOPY_COMPLETE && DMACopyCancel(req) == DMACOPY_PENDING)
+		DMACopyWait(req);
+
+	FinishRequest(req);
+	req->state = DMACOPY_FREE;
+}
+
+/*
+ * Counters since DMACopyInit()
+ */
+void DMACopyGetStats(struct DMACopyStats *stats)
+{
+	Disable();
+	*stats = g_dc_stats;
+	Enable();
+}
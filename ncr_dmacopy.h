@@ -0,0 +1,88 @@
+/*
+ * ncr_dmacopy.h - Asynchronous DMA copy library
+ *
+ * Lets other tools hand memory copies to the 53C710 memory-move engine.
+ * Every wait has a deadline of DMACOPY_TIMEOUT_MS plus the time the
+ * pending bytes take at DMACOPY_MIN_RATE: a batch that has not finished
+ * by then is aborted and its requests complete with DMACOPY_TIMEOUT.
+ * Link with ncr_dmacopy.c, ncr_cache.c and ncr_timer.c.
+ */
+
+#ifndef NCR_DMACOPY_H
+#define NCR_DMACOPY_H
+
+#include <exec/types.h>
+#include "ncr_dmatest.h"  // For ncr710 structure and SCRIPTS formats
+
+/* Library limits */
+#define DMACOPY_POOL_SIZE	32		// Request descriptors
+#define DMACOPY_MAX_MOVES	(2 * MAX_DMA_SEGMENTS)	// Memory moves per request
+#define DMACOPY_SCRIPT_SIZE	2048		// Per batch, never crosses a page
+#define DMACOPY_BATCH_MOVES	((DMACOPY_SCRIPT_SIZE - sizeof(struct jump_inst)) / \
+				 sizeof(struct memmove_inst))
+#define DMACOPY_MAGIC		0xC0B1E5ED	// DSPS value of a batch's final INT
+#define DMACOPY_TIMEOUT_MS	1000		// Fixed part of a wait's deadline
+#define DMACOPY_MIN_RATE	1024		// Bytes per ms (~1 MB/s) a batch is allowed
+#define DMACOPY_ABORT_US	1000		// Time the abort interrupt is given
+
+/* Request status (DMACopyPoll/DMACopyWait/DMACopyCancel) */
+#define DMACOPY_DONE		0
+#define DMACOPY_PENDING		1
+#define DMACOPY_ERROR		2
+#define DMACOPY_CANCELLED	3
+#define DMACOPY_TIMEOUT		4	// Batch aborted at its deadline
+
+/* Request states */
+#define DMACOPY_FREE		0	// In the pool
+#define DMACOPY_QUEUED		1	// Submitted, not yet in a batch
+#define DMACOPY_BATCHED		2	// In the batch that starts next
+#define DMACOPY_RUNNING		3	// In the batch the chip is executing
+#define DMACOPY_COMPLETE	4	// Batch finished (status says how)
+
+/* One copy request - from the pool, owned by the submitting task */
+struct DMACopyRequest {
+	struct DMACopyRequest *next;	// Queue link
+	UBYTE state;			// DMACOPY_FREE..COMPLETE
+	UBYTE finished;			// Cache maintenance done after completion
+	UWORD nmoves;
+	LONG status;			// DMACOPY_DONE/ERROR/CANCELLED/TIMEOUT once complete
+	APTR src;
+	APTR dst;
+	ULONG len;
+	struct Task *task;		// Signalled when the batch completes
+	ULONG signal_mask;
+	struct memmove_inst moves[DMACOPY_MAX_MOVES];
+};
+
+/* Counters since DMACopyInit() */
+struct DMACopyStats {
+	ULONG requests;			// Submitted
+	ULONG batches;			// Scripts started
+	ULONG cancelled;
+	ULONG errors;
+	ULONG timeouts;			// Batches aborted by a bounded wait
+	ULONG max_batch;		// Most requests in one batch
+};
+
+/*
+ * Setup and teardown - installs its own interrupt server, so nothing else
+ * may have one on the chip at the same time
+ */
+LONG DMACopyInit(volatile struct ncr710 *ncr);
+void DMACopyCleanup(void);
+
+/*
+ * Submit a copy of len bytes. Both ranges belong to the chip until the
+ * request completes. signal_mask 0 uses the library signal (valid for the
+ * task that called DMACopyInit()). Returns NULL if the pool is empty or
+ * the ranges are too fragmented.
+ */
+struct DMACopyRequest *DMACopySubmit(APTR src, APTR dst, ULONG len, ULONG signal_mask);
+
+LONG DMACopyPoll(struct DMACopyRequest *req);
+LONG DMACopyWait(struct DMACopyRequest *req);
+LONG DMACopyCancel(struct DMACopyRequest *req);
+void DMACopyFree(struct DMACopyRequest *req);
+void DMACopyGetStats(struct DMACopyStats *stats);
+
+#endif /* NCR_DMACOPY_H */
@@ -5,6 +5,7 @@
 #include "ncr_dmatest.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <exec/execbase.h>
 #include <exec/memory.h>
 #include <proto/exec.h>
@@ -40,46 +41,44 @@ static UBYTE *g_cpufastl_buf2 = NULL;
 static UBYTE *g_cpufastu_buf1 = NULL;
 static UBYTE *g_cpufastu_buf2 = NULL;
 static BOOL g_cleanup_done = FALSE;
+BOOL g_user_abort = FALSE;
 
-/* SCRIPTS buffer - allocated in FAST memory */
+/* SCRIPTS buffer - allocated where PlaceScripts() found fetches fastest */
 static UBYTE *g_scripts_buf = NULL;
 
-/* Memory region definitions */
-#define MB_FAST_START    0x07000000UL
-#define MB_FAST_END      0x07FFFFFFUL
-#define CPU_FASTL_START  0x08000000UL
-#define CPU_FASTL_END    0x0FFFFFFFUL
-#define CPU_FASTU_START  0x10000000UL
-#define CPU_FASTU_END    0x18000000UL
-#define ALLOC_STEP       (64*1024)  // 64KB increment
+/* CHIP destinations are read back into FAST RAM by DMA for verify */
+static UBYTE *g_readback_buf = NULL;
+static BOOL g_readback_verify = TRUE;
+static ULONG g_chip_verify_count = 0;
+static ULONG g_chip_verify_micros = 0;
+
+/* All test buffers, buf1/buf2 of each region in pairs */
+struct MemoryBuffer g_test_buffers[] = {
+	{ &g_chip_buf1,     "CHIP"     },
+	{ &g_chip_buf2,     "CHIP"     },
+	{ &g_mbfast_buf1,   "MB_FAST"  },
+	{ &g_mbfast_buf2,   "MB_FAST"  },
+	{ &g_cpufastl_buf1, "CPU_FASTL"},
+	{ &g_cpufastl_buf2, "CPU_FASTL"}
+//	{ &g_cpufastu_buf1, "CPU_FASTU"},
+//	{ &g_cpufastu_buf2, "CPU_FASTU"}
+};
+int g_num_test_buffers = sizeof(g_test_buffers) / sizeof(g_test_buffers[0]);
 
 /* Simple pseudo-random number generator for test patterns */
 static ULONG random_seed = 0x12345678;
 
 /*
- * Allocate memory in a specific address range using AllocAbs()
- * Searches the range in 64KB increments until successful
- * Returns NULL if no memory available in range
+ * Cleared TEST_BUFFER_SIZE buffer from a region's pool
  */
-static UBYTE *AllocInRange(ULONG start, ULONG end, ULONG size, const char *region_name)
+static UBYTE *AllocTestBuffer(ULONG pool)
 {
-	UBYTE *mem;
-	ULONG addr;
-	
-	dbgprintf("  Searching for %ld bytes in %s region (0x%08lx-0x%08lx)...\n",
-	       size, region_name, start, end);
+	UBYTE *mem = PoolAlloc(pool, TEST_BUFFER_SIZE);
 
-	// Search the range in ALLOC_STEP increments
-	for (addr = start; addr <= (end - size); addr += ALLOC_STEP) {
-		mem = (UBYTE *)AllocAbs(size, (APTR)addr);
-		if (mem) {
-			dbgprintf("    Allocated at 0x%08lx\n", (ULONG)mem);
-			return mem;
-		}
-	}
+	if (mem)
+		memset(mem, 0, TEST_BUFFER_SIZE);
 
-	dbgprintf("    Failed to allocate in %s region\n", region_name);
-	return NULL;
+	return mem;
 }
 
 /*
@@ -93,41 +92,46 @@ static void CleanupBuffers(void)
 	dbgprintf("\nCleaning up buffers...\n");
 
 	if (g_chip_buf1) {
-		FreeMem(g_chip_buf1, TEST_BUFFER_SIZE);
+		PoolFree(g_chip_buf1, TEST_BUFFER_SIZE);
 		g_chip_buf1 = NULL;
 	}
 	if (g_chip_buf2) {
-		FreeMem(g_chip_buf2, TEST_BUFFER_SIZE);
+		PoolFree(g_chip_buf2, TEST_BUFFER_SIZE);
 		g_chip_buf2 = NULL;
 	}
 	if (g_mbfast_buf1) {
-		FreeMem(g_mbfast_buf1, TEST_BUFFER_SIZE);
+		PoolFree(g_mbfast_buf1, TEST_BUFFER_SIZE);
 		g_mbfast_buf1 = NULL;
 	}
 	if (g_mbfast_buf2) {
-		FreeMem(g_mbfast_buf2, TEST_BUFFER_SIZE);
+		PoolFree(g_mbfast_buf2, TEST_BUFFER_SIZE);
 		g_mbfast_buf2 = NULL;
 	}
 	if (g_cpufastl_buf1) {
-		FreeMem(g_cpufastl_buf1, TEST_BUFFER_SIZE);
+		PoolFree(g_cpufastl_buf1, TEST_BUFFER_SIZE);
 		g_cpufastl_buf1 = NULL;
 	}
 	if (g_cpufastl_buf2) {
-		FreeMem(g_cpufastl_buf2, TEST_BUFFER_SIZE);
+		PoolFree(g_cpufastl_buf2, TEST_BUFFER_SIZE);
 		g_cpufastl_buf2 = NULL;
 	}
 	if (g_cpufastu_buf1) {
-		FreeMem(g_cpufastu_buf1, TEST_BUFFER_SIZE);
+		PoolFree(g_cpufastu_buf1, TEST_BUFFER_SIZE);
 		g_cpufastu_buf1 = NULL;
 	}
 	if (g_cpufastu_buf2) {
-		FreeMem(g_cpufastu_buf2, TEST_BUFFER_SIZE);
+		PoolFree(g_cpufastu_buf2, TEST_BUFFER_SIZE);
 		g_cpufastu_buf2 = NULL;
 	}
 	if (g_scripts_buf) {
-		FreeMem(g_scripts_buf, 256);  // Small buffer for SCRIPTS
+		FreeScriptMem(g_scripts_buf, SCRIPTS_BUF_SIZE);
 		g_scripts_buf = NULL;
 	}
+	if (g_readback_buf) {
+		PoolFree(g_readback_buf, MAX_TEST_SIZE);
+		g_readback_buf = NULL;
+	}
+	PoolCleanup();
 
 	g_cleanup_done = TRUE;
 }
@@ -138,6 +142,14 @@ static ULONG GetRandom(void)
 	return random_seed;
 }
 
+/*
+ * Restart the PATTERN_RANDOM sequence from a known seed
+ */
+void SeedRandom(ULONG seed)
+{
+	random_seed = seed;
+}
+
 /*
  * NCR 53C710 Interrupt Handler for DMA Tests
  * Called when the NCR chip generates an interrupt
@@ -295,7 +307,7 @@ void FillPattern(UBYTE *buffer, ULONG size, ULONG pattern_type)
 		break;
 	}
 
-	CacheClearU();
+	DMACacheClear();
 }
 
 /*
@@ -305,7 +317,7 @@ LONG VerifyBuffer(UBYTE *src, UBYTE *dst, ULONG size, struct TestResult *result)
 {
 	ULONG i;
 
-	CacheClearU();
+	DMACacheClear();
 
 	for (i = 0; i < size; i++) {
 		if (src[i] != dst[i]) {
@@ -320,52 +332,61 @@ LONG VerifyBuffer(UBYTE *src, UBYTE *dst, ULONG size, struct TestResult *result)
 }
 
 /*
- * Build a simple SCRIPTS program to perform memory-to-memory DMA
- * Returns the address of the script
- * NOTE: Uses pre-allocated FAST memory buffer (g_scripts_buf)
+ * Build a SCRIPTS program to perform memory-to-memory DMA
+ * One memory move per physically contiguous piece of the transfer
+ * If rb is given the destination is then copied on to rb in the same
+ * program (readback verify)
+ * Returns the address of the script, *script_size is its length
+ * NOTE: Uses pre-allocated SCRIPTS buffer (g_scripts_buf)
  */
-static ULONG* BuildDMAScript(UBYTE *src, UBYTE *dst, ULONG size)
+static ULONG* BuildDMAScript(struct DMASegment *src, ULONG nsrc,
+                             struct DMASegment *dst, ULONG ndst,
+                             struct DMASegment *rb, ULONG nrb,
+                             ULONG *script_size)
 {
-	struct {
-		struct memmove_inst move;
-		struct jump_inst    done;
-	} *script = (void *)g_scripts_buf;
+	struct memmove_inst *moves = (struct memmove_inst *)g_scripts_buf;
+	ULONG n, m = 1;
 
 	if (!g_scripts_buf) {
 		dbgprintf("ERROR: SCRIPTS buffer not allocated!\n");
 		return NULL;
 	}
 
-	// Memory-to-memory move instruction
-	script->move.op = 0xC0;  // Memory move opcode
-	script->move.len[0] = (size >> 16) & 0xFF;
-	script->move.len[1] = (size >> 8) & 0xFF;
-	script->move.len[2] = size & 0xFF;
-	script->move.source = (ULONG)src;
-	script->move.dest = (ULONG)dst;
+	n = EmitMemMoves(moves, MAX_SCRIPT_MOVES, src, nsrc, dst, ndst);
+	if (n && rb) {
+		m = EmitMemMoves(&moves[n], MAX_SCRIPT_MOVES - n, dst, ndst, rb, nrb);
+		n += m;
+	}
+	if (!n || !m) {
+		dbgprintf("ERROR: Transfer too fragmented for SCRIPTS buffer\n");
+		return NULL;
+	}
+
+	// INT instruction to signal completion
+	BuildIntInst((struct jump_inst *)&moves[n], 0xDEADBEEF);
 
-	// INT instruction to signal completion (opcode 0x98, interrupt on the fly)
-	script->done.op = 0x98;
-	script->done.control = 0x08;  // Interrupt always
-	script->done.mask = 0x00;
-	script->done.data = 0x00;
-	script->done.addr = 0xDEADBEEF;  // Value that will be in DSPS
+	*script_size = n * sizeof(struct memmove_inst) + sizeof(struct jump_inst);
 
-	return (ULONG*)script;
+	return (ULONG*)moves;
 }
 
 /*
  * Build a scatter-gather SCRIPTS program with multiple Memory Move instructions
  * Gathers data from multiple source buffers into one contiguous destination
- * Returns the address of the script
+ * Each source and destination piece is prepared for DMA (DMAMapRange) as
+ * it is emitted, so the caller only has to finish them with DMACachePost()
+ * Returns the address of the script, *script_size is its length
  */
 static ULONG* BuildScatterGatherScript(UBYTE **sources, UBYTE *dest,
-                                        ULONG *sizes, ULONG num_segments)
+                                        ULONG *sizes, ULONG num_segments,
+                                        ULONG *script_size)
 {
+	struct DMASegment src_segs[MAX_DMA_SEGMENTS], dst_segs[MAX_DMA_SEGMENTS];
 	struct memmove_inst *moves;
-	struct jump_inst *done;
+	ULONG nsrc, ndst, n = 0, emitted;
 	ULONG i;
 	ULONG dest_offset = 0;
+	BOOL failed = FALSE;
 
 	if (!g_scripts_buf) {
 		dbgprintf("ERROR: SCRIPTS buffer not allocated!\n");
@@ -382,59 +403,78 @@ static ULONG* BuildScatterGatherScript(UBYTE **sources, UBYTE *dest,
 	moves = (struct memmove_inst *)g_scripts_buf;
 
 	for (i = 0; i < num_segments; i++) {
-		moves[i].op = 0xC0;  // Memory move opcode
-		moves[i].len[0] = (sizes[i] >> 16) & 0xFF;
-		moves[i].len[1] = (sizes[i] >> 8) & 0xFF;
-		moves[i].len[2] = sizes[i] & 0xFF;
-		moves[i].source = (ULONG)sources[i];
-		moves[i].dest = (ULONG)(dest + dest_offset);
-
+		nsrc = DMAMapRange(sources[i], sizes[i], DMA_DIR_READ,
+		                   src_segs, MAX_DMA_SEGMENTS);
+		ndst = DMAMapRange(dest + dest_offset, sizes[i], DMA_DIR_WRITE,
+		                   dst_segs, MAX_DMA_SEGMENTS);
 		dest_offset += sizes[i];
+
+		if (failed || !nsrc || !ndst) {
+			failed = TRUE;
+			continue;
+		}
+
+		emitted = EmitMemMoves(&moves[n], MAX_SCRIPT_MOVES - n,
+		                       src_segs, nsrc, dst_segs, ndst);
+		if (!emitted)
+			failed = TRUE;
+		n += emitted;
+	}
+
+	if (failed) {
+		dbgprintf("ERROR: Scatter-gather list too fragmented for SCRIPTS buffer\n");
+		return NULL;
 	}
 
 	// Add interrupt instruction after all moves
-	done = (struct jump_inst *)&moves[num_segments];
-	done->op = 0x98;           // Interrupt opcode
-	done->control = 0x08;      // Interrupt always
-	done->mask = 0x00;
-	done->data = 0x00;
-	done->addr = 0xCAFEBABE;   // Different magic value for SG
+	BuildIntInst((struct jump_inst *)&moves[n], 0xCAFEBABE);  // Different magic value for SG
+
+	*script_size = n * sizeof(struct memmove_inst) + sizeof(struct jump_inst);
 
 	return (ULONG*)moves;
 }
 
 /*
- * Execute a DMA transfer using the NCR chip
- * Returns: TEST_SUCCESS on success, error code on failure
+ * Stop a script the user gave up on, the way ResetNCR() does, so the chip
+ * no longer fetches from a script or buffers that are about to be freed.
+ * The abort interrupt is drained here, not left for the next wait.
  */
-LONG RunDMATest(volatile struct ncr710 *ncr, UBYTE *src, UBYTE *dst, ULONG size)
+static void AbortScript(volatile struct ncr710 *ncr)
 {
-	ULONG *script;
-	UBYTE istat, dstat;
-
-	// Build the SCRIPTS program
-	script = BuildDMAScript(src, dst, size);
-
-	// Flush caches before DMA to ensure data/script visibility
-	CacheClearU();
+	ULONG waited = 0;
 
-	// Clear any pending interrupts
-	(void)ncr->istat;
+	Disable();
+	ncr->istat |= ISTATF_ABRT;
+	while (!(ncr->istat & ISTATF_DIP) && waited < SCRIPT_ABORT_US) {
+		poll_cia(100);
+		waited += 100;
+	}
+	ncr->istat = 0;
 	(void)ncr->dstat;
-	(void)ncr->sstat0;
-
-	// Clear interrupt received flag
 	g_int_state.int_received = 0;
+	Enable();
+
+	SetSignal(0, g_int_state.signal_mask);
+}
 
-	// Load the script address into DSP to start execution
-	WRITE_LONG(ncr, dsp, (ULONG)script);
+/*
+ * Wait for the completion interrupt of a running script
+ * magic is the value the final INT instruction leaves in DSPS
+ * Returns: TEST_SUCCESS on success, error code on failure
+ */
+static LONG WaitDMACompletion(volatile struct ncr710 *ncr, ULONG magic,
+                              const char *context)
+{
+	UBYTE istat, dstat;
 
 	// Wait for interrupt (with Ctrl-C break)
 	ULONG sigs = Wait(g_int_state.signal_mask | SIGBREAKF_CTRL_C);
 
 	if (sigs & SIGBREAKF_CTRL_C) {
 		dbgprintf("ERROR: Interrupted by user (Ctrl-C)\n");
-		return TEST_FAILED;
+		AbortScript(ncr);
+		g_user_abort = TRUE;
+		return TEST_ABORTED;
 	}
 
 	if (!g_int_state.int_received) {
@@ -452,18 +492,18 @@ LONG RunDMATest(volatile struct ncr710 *ncr, UBYTE *src, UBYTE *dst, ULONG size)
 		// Check for script interrupt (our completion signal)
 		if (dstat & DSTATF_SIR) {
 			// Success - script completed
-			if (g_int_state.dsps == 0xDEADBEEF) {
+			if (g_int_state.dsps == magic) {
 				return TEST_SUCCESS;
 			}
 		}
 
 		// Check for errors
-		if (CheckNCRStatus(ncr, "DMA") < 0) {
+		if (CheckNCRStatus(ncr, context) < 0) {
 			return TEST_DMA_ERROR;
 		}
 	}
 
-	dbgprintf("ERROR: DMA interrupt but no completion\n");
+	dbgprintf("ERROR: %s interrupt but no completion\n", context);
 	dbgprintf("  ISTAT: 0x%02lx\n", (ULONG)istat);
 	dbgprintf("  DSTAT: 0x%02lx\n", (ULONG)dstat);
 	dbgprintf("  DSPS:  0x%08lx\n", g_int_state.dsps);
@@ -472,24 +512,24 @@ LONG RunDMATest(volatile struct ncr710 *ncr, UBYTE *src, UBYTE *dst, ULONG size)
 }
 
 /*
- * Execute a scatter-gather DMA transfer using the NCR chip
- * Multiple source buffers are gathered into one destination buffer
+ * Start a script already pushed to RAM and wait for its final INT
  * Returns: TEST_SUCCESS on success, error code on failure
  */
-static LONG RunScatterGatherTest(volatile struct ncr710 *ncr, UBYTE **sources,
-                                  UBYTE *dest, ULONG *sizes, ULONG num_segments)
+LONG ExecuteScript(volatile struct ncr710 *ncr, ULONG script_phys, ULONG magic,
+                   const char *context)
 {
-	ULONG *script;
-	UBYTE istat, dstat;
+	StartScript(ncr, script_phys);
 
-	// Build the scatter-gather SCRIPTS program
-	script = BuildScatterGatherScript(sources, dest, sizes, num_segments);
-	if (!script)
-		return TEST_DMA_ERROR;
-
-	// Flush caches before DMA
-	CacheClearU();
+	// Wait for interrupt (with Ctrl-C break)
+	return WaitDMACompletion(ncr, magic, context);
+}
 
+/*
+ * Start a script already pushed to RAM without waiting for it
+ * Poll ScriptFinished() meanwhile, then collect it with FinishScript()
+ */
+void StartScript(volatile struct ncr710 *ncr, ULONG script_phys)
+{
 	// Clear any pending interrupts
 	(void)ncr->istat;
 	(void)ncr->dstat;
@@ -498,49 +538,181 @@ static LONG RunScatterGatherTest(volatile struct ncr710 *ncr, UBYTE **sources,
 	// Clear interrupt received flag
 	g_int_state.int_received = 0;
 
-	// Load the script address into DSP to start execution
-	WRITE_LONG(ncr, dsp, (ULONG)script);
+	// Load the script's physical address into DSP to start execution
+	WRITE_LONG(ncr, dsp, script_phys);
+}
 
-	// Wait for interrupt (with Ctrl-C break)
-	ULONG sigs = Wait(g_int_state.signal_mask | SIGBREAKF_CTRL_C);
+/*
+ * Has the interrupt handler seen the script's interrupt yet?
+ */
+BOOL ScriptFinished(void)
+{
+	return g_int_state.int_received != 0;
+}
 
-	if (sigs & SIGBREAKF_CTRL_C) {
-		dbgprintf("ERROR: Interrupted by user (Ctrl-C)\n");
-		return TEST_FAILED;
+/*
+ * Wait for a script from StartScript() to reach its final INT
+ * Returns: TEST_SUCCESS on success, error code on failure
+ */
+LONG FinishScript(volatile struct ncr710 *ncr, ULONG magic, const char *context)
+{
+	return WaitDMACompletion(ncr, magic, context);
+}
+
+/*
+ * Prepare a script in g_scripts_buf for DMA, run it and wait for completion
+ * The caller finishes the script range with DMACachePost()
+ * Returns: TEST_SUCCESS on success, error code on failure
+ */
+static LONG RunMappedScript(volatile struct ncr710 *ncr, ULONG *script,
+                            ULONG script_size, ULONG magic, const char *context)
+{
+	struct DMASegment seg;
+
+	// g_scripts_buf never crosses a page, so this is always one segment
+	if (DMAMapRange(script, script_size, DMA_DIR_READ, &seg, 1) != 1) {
+		dbgprintf("ERROR: SCRIPTS buffer is not physically contiguous\n");
+		return TEST_DMA_ERROR;
 	}
 
-	if (!g_int_state.int_received) {
-		dbgprintf("ERROR: Spurious signal\n");
-		return TEST_FAILED;
+	return ExecuteScript(ncr, seg.phys, magic, context);
+}
+
+/*
+ * Execute a DMA transfer using the NCR chip, optionally copying the
+ * destination on to readback in the same script
+ * Returns: TEST_SUCCESS on success, error code on failure
+ */
+static LONG RunDMATransfer(volatile struct ncr710 *ncr, UBYTE *src, UBYTE *dst,
+                           UBYTE *readback, ULONG size)
+{
+	struct DMASegment src_segs[MAX_DMA_SEGMENTS], dst_segs[MAX_DMA_SEGMENTS];
+	struct DMASegment rb_segs[MAX_DMA_SEGMENTS];
+	ULONG nsrc, ndst, nrb = 1;
+	ULONG *script = NULL;
+	ULONG script_size = 0;
+	LONG status;
+
+	// Cache maintenance and physical translation before DMA
+	DMACacheClear();
+	nsrc = DMAMapRange(src, size, DMA_DIR_READ, src_segs, MAX_DMA_SEGMENTS);
+	ndst = DMAMapRange(dst, size, readback ? DMA_DIR_BOTH : DMA_DIR_WRITE,
+	                   dst_segs, MAX_DMA_SEGMENTS);
+	if (readback)
+		nrb = DMAMapRange(readback, size, DMA_DIR_WRITE, rb_segs, MAX_DMA_SEGMENTS);
+
+	// Build the SCRIPTS program
+	if (nsrc && ndst && nrb)
+		script = BuildDMAScript(src_segs, nsrc, dst_segs, ndst,
+		                        readback ? rb_segs : NULL, nrb, &script_size);
+	else
+		dbgprintf("ERROR: Transfer spans more than %ld physical segments\n",
+		          (ULONG)MAX_DMA_SEGMENTS);
+
+	status = script ? RunMappedScript(ncr, script, script_size, 0xDEADBEEF, "DMA")
+	                : TEST_DMA_ERROR;
+
+	// Cache maintenance after DMA so the CPU sees the new data
+	DMACachePost(dst, size, DMA_DIR_WRITE);
+	DMACachePost(src, size, DMA_DIR_READ);
+	if (readback)
+		DMACachePost(readback, size, DMA_DIR_WRITE);
+	if (script)
+		DMACachePost(script, script_size, DMA_DIR_READ);
+
+	return status;
+}
+
+/*
+ * Execute a DMA transfer using the NCR chip
+ * Returns: TEST_SUCCESS on success, error code on failure
+ */
+LONG RunDMATest(volatile struct ncr710 *ncr, UBYTE *src, UBYTE *dst, ULONG size)
+{
+	return RunDMATransfer(ncr, src, dst, NULL, size);
+}
+
+/*
+ * Select DMA readback (default) or direct CPU verify of CHIP destinations
+ */
+void SetReadbackVerify(BOOL enable)
+{
+	g_readback_verify = enable;
+}
+
+/*
+ * Run a DMA transfer and verify it
+ * A CHIP RAM destination is copied back into FAST RAM by the same script
+ * and compared there, so the CPU never reads CHIP RAM (slow, and it
+ * competes with custom chip DMA). Direct CPU verify is used when readback
+ * is off or the buffer is missing. CHIP destination cycles are timed.
+ * Returns: TEST_SUCCESS on success, error code on failure
+ */
+LONG RunDMAVerified(volatile struct ncr710 *ncr, UBYTE *src, UBYTE *dst,
+                    ULONG size, struct TestResult *result)
+{
+	struct EClockVal t0, t1;
+	BOOL chip = (TypeOfMem(dst) & MEMF_CHIP) != 0;
+	BOOL readback = chip && g_readback_verify && g_readback_buf && size <= MAX_TEST_SIZE;
+	LONG status;
+
+	ReadTimer(&t0);
+
+	if (readback) {
+		// Stale readback data must not be able to pass
+		memset(g_readback_buf, MATRIX_GUARD_BYTE, size);
+		status = RunDMATransfer(ncr, src, dst, g_readback_buf, size);
+		if (status == TEST_SUCCESS)
+			status = VerifyBuffer(src, g_readback_buf, size, result);
+	} else {
+		status = RunDMATransfer(ncr, src, dst, NULL, size);
+		if (status == TEST_SUCCESS)
+			status = VerifyBuffer(src, dst, size, result);
 	}
 
-	// Check interrupt status from handler
-	istat = g_int_state.istat;
-	dstat = g_int_state.dstat;
+	if (chip) {
+		ReadTimer(&t1);
+		g_chip_verify_count++;
+		g_chip_verify_micros += ElapsedMicros(&t0, &t1);
+	}
 
-	// Check for DMA interrupt
-	if (istat & ISTATF_DIP) {
+	return status;
+}
 
-		// Check for script interrupt (our completion signal)
-		if (dstat & DSTATF_SIR) {
-			// Success - script completed
-			if (g_int_state.dsps == 0xCAFEBABE) {
-				return TEST_SUCCESS;
-			}
-		}
+/*
+ * Execute a scatter-gather DMA transfer using the NCR chip
+ * Multiple source buffers are gathered into one destination buffer
+ * Returns: TEST_SUCCESS on success, error code on failure
+ */
+LONG RunScatterGatherTest(volatile struct ncr710 *ncr, UBYTE **sources,
+                          UBYTE *dest, ULONG *sizes, ULONG num_segments)
+{
+	ULONG *script;
+	ULONG script_size = 0;
+	ULONG total = 0;
+	ULONG i;
+	LONG status;
 
-		// Check for errors
-		if (CheckNCRStatus(ncr, "SG DMA") < 0) {
-			return TEST_DMA_ERROR;
+	// Build the scatter-gather SCRIPTS program (maps sources and dest)
+	DMACacheClear();
+	script = BuildScatterGatherScript(sources, dest, sizes, num_segments,
+	                                  &script_size);
+
+	status = script ? RunMappedScript(ncr, script, script_size, 0xCAFEBABE, "SG DMA")
+	                : TEST_DMA_ERROR;
+
+	// Cache maintenance after DMA
+	if (num_segments <= MAX_SG_SEGMENTS) {
+		for (i = 0; i < num_segments; i++) {
+			DMACachePost(sources[i], sizes[i], DMA_DIR_READ);
+			total += sizes[i];
 		}
+		DMACachePost(dest, total, DMA_DIR_WRITE);
 	}
+	if (script)
+		DMACachePost(script, script_size, DMA_DIR_READ);
 
-	dbgprintf("ERROR: Scatter-gather DMA interrupt but no completion\n");
-	dbgprintf("  ISTAT: 0x%02lx\n", (ULONG)istat);
-	dbgprintf("  DSTAT: 0x%02lx\n", (ULONG)dstat);
-	dbgprintf("  DSPS:  0x%08lx\n", g_int_state.dsps);
-
-	return TEST_FAILED;
+	return status;
 }
 
 /*
@@ -561,7 +733,8 @@ void PrintTestResults(struct TestResult *result)
 		"FAILED",
 		"TIMEOUT",
 		"DMA_ERROR",
-		"VERIFY_ERROR"
+		"VERIFY_ERROR",
+		"ABORTED"
 	};
 
 	// Only print if test failed
@@ -582,8 +755,75 @@ void PrintTestResults(struct TestResult *result)
 	}
 }
 
+/*
+ * Run one cell of the region sweep: fill, transfer, verify
+ * Returns: TEST_SUCCESS on success, error code on failure
+ */
+LONG RunSweepCell(volatile struct ncr710 *ncr, UBYTE *src_base, UBYTE *dst_base,
+                  ULONG size, ULONG pattern, ULONG test_num,
+                  struct TestResult *result)
+{
+	// Initialize result structure
+	result->test_number = test_num;
+	result->pattern_type = pattern;
+	result->size = size;
+	result->status = TEST_FAILED;
+	result->error_offset = 0;
+	result->expected_value = 0;
+	result->actual_value = 0;
+
+	// Fill source buffer with pattern
+	FillPattern(src_base, size, pattern);
+
+	// Clear destination buffer
+	FillPattern(dst_base, size, PATTERN_ZEROS);
+
+	// Run DMA transfer and verify it
+	result->status = RunDMAVerified(ncr, src_base, dst_base, size, result);
+
+	return result->status;
+}
+
+/*
+ * Find the g_test_buffers[] index of a buffer
+ * Returns -1 if it is not a test buffer
+ */
+LONG FindTestBuffer(UBYTE *buf)
+{
+	int idx;
+
+	for (idx = 0; idx < g_num_test_buffers; idx++)
+		if (buf && *g_test_buffers[idx].buf == buf)
+			return idx;
+
+	return -1;
+}
+
+/*
+ * Map a verify failure over the whole transfer (first few per run)
+ * The CPU reads the destination itself; if that is clean, the readback
+ * copy that failed the compare is mapped instead
+ */
+static void AnalyzeFailure(UBYTE *src, UBYTE *dst, ULONG size)
+{
+	static ULONG analyzed = 0;
+
+	if (analyzed >= ERRMAP_MAX_PER_RUN)
+		return;
+	analyzed++;
+
+	dbgprintf("\n");
+	DMACacheClear();
+	if (AnalyzeErrors(src, dst, size) == 0 && g_readback_verify && g_readback_buf &&
+	    (TypeOfMem(dst) & MEMF_CHIP) && size <= MAX_TEST_SIZE) {
+		dbgprintf("    CPU reads the destination correctly - readback copy:\n");
+		AnalyzeErrors(src, g_readback_buf, size);
+	}
+}
+
 /*
  * Run a comprehensive DMA test between two memory regions
+ * Returns TEST_SUCCESS, TEST_FAILED or TEST_ABORTED (Ctrl-C, sweep stopped)
  */
 LONG RunComprehensiveTest(volatile struct ncr710 *ncr,
                           UBYTE *src_base, UBYTE *dst_base,
@@ -604,30 +844,28 @@ LONG RunComprehensiveTest(volatile struct ncr710 *ncr,
 
 			test_num++;
 
-			// Initialize result structure
-			result.test_number = test_num;
-			result.pattern_type = pattern;
-			result.size = size;
-			result.status = TEST_FAILED;
-			result.error_offset = 0;
-			result.expected_value = 0;
-			result.actual_value = 0;
-
-			// Fill source buffer with pattern
-			FillPattern(src_base, size, pattern);
-
-			// Clear destination buffer
-			FillPattern(dst_base, size, PATTERN_ZEROS);
-
-			// Run DMA transfer
-			status = RunDMATest(ncr, src_base, dst_base, size);
-
-			if (status == TEST_SUCCESS) {
-				// Verify the transfer
-				status = VerifyBuffer(src_base, dst_base, size, &result);
+			// Finished by an earlier run of a resumed campaign
+			status = JournalLookupCell(src_base, dst_base, size, pattern);
+			if (status >= 0) {
+				// Recorded in the history when it ran - don't count it twice
+				if (status == TEST_SUCCESS) {
+					passed++;
+				} else {
+					dbgprintf("\n  Test %ld (%ld bytes, pattern %ld): status %ld in an earlier run",
+					          test_num, size, pattern, status);
+					failed++;
+				}
+				continue;
 			}
 
-			result.status = status;
+			status = RunSweepCell(ncr, src_base, dst_base, size, pattern,
+			                      test_num, &result);
+			RecordHistory(src_base, dst_base, size, pattern, status);
+			JournalRecordCell(src_base, dst_base, size, pattern, status);
+
+			// The user stopped the run - nothing failed, so don't analyse
+			if (status == TEST_ABORTED)
+				return TEST_ABORTED;
 
 			// Print progress indicator (dot for success)
 			if (status == TEST_SUCCESS) {
@@ -636,6 +874,11 @@ LONG RunComprehensiveTest(volatile struct ncr710 *ncr,
 				// Print newline before error details
 				PrintTestResults(&result);
 				failed++;
+				if (status == TEST_VERIFY_ERROR)
+					AnalyzeFailure(src_base, dst_base, size);
+				BisectFailure(ncr, src_base, dst_base, size, pattern);
+				if (g_user_abort)
+					return TEST_ABORTED;
 				// For now, continue with other tests even if one fails
 			}
 		}
@@ -649,40 +892,173 @@ LONG RunComprehensiveTest(volatile struct ncr710 *ncr,
 		dbgprintf("Failed:      %ld\n", failed);
 	}
 
-	return (failed == 0) ? 0 : -1;
+	return (failed == 0) ? TEST_SUCCESS : TEST_FAILED;
+}
+
+/*
+ * Compare full-flush and range cache maintenance
+ * Runs the fill/DMA/verify cycle of RunComprehensiveTest() in both modes
+ * and reports the time per cycle and the part spent on cache maintenance
+ */
+void TestCacheOverhead(volatile struct ncr710 *ncr)
+{
+	UBYTE *src = g_cpufastl_buf1 ? g_cpufastl_buf1 : g_chip_buf1;
+	UBYTE *dst = g_cpufastl_buf2 ? g_cpufastl_buf2 : g_chip_buf2;
+	ULONG saved_mode = GetDMACacheMode();
+	ULONG cycle_us[2], cache_us[2];
+	ULONG size, mode, iter;
+	ULONG failed = 0;
+	struct EClockVal t0, t1;
+	struct TestResult result;
+
+	dbgprintf("\n=== DMA Cache Maintenance Overhead ===\n");
+	dbgprintf("%ld fill/DMA/verify cycles per size and mode, 0x%08lx -> 0x%08lx\n\n",
+	          (ULONG)CACHE_BENCH_ITERATIONS, (ULONG)src, (ULONG)dst);
+	dbgprintf("   size |  full: cycle us  cache us | range: cycle us  cache us | saved us\n");
+
+	for (size = MIN_TEST_SIZE; size <= MAX_TEST_SIZE; size *= 2) {
+		for (mode = CACHE_MODE_RANGE; mode <= CACHE_MODE_FULL; mode++) {
+			SetDMACacheMode(mode);
+			ResetCacheStats();
+
+			ReadTimer(&t0);
+			for (iter = 0; iter < CACHE_BENCH_ITERATIONS; iter++) {
+				FillPattern(src, size, PATTERN_RANDOM);
+				FillPattern(dst, size, PATTERN_ZEROS);
+
+				if (RunDMATest(ncr, src, dst, size) != TEST_SUCCESS ||
+				    VerifyBuffer(src, dst, size, &result) != TEST_SUCCESS)
+					failed++;
+			}
+			ReadTimer(&t1);
+
+			cycle_us[mode] = ElapsedMicros(&t0, &t1) / CACHE_BENCH_ITERATIONS;
+			cache_us[mode] = GetCacheMicros() / CACHE_BENCH_ITERATIONS;
+		}
+
+		dbgprintf("  %5ld |      %9ld %9ld |      %9ld %9ld | %8ld\n",
+		          size,
+		          cycle_us[CACHE_MODE_FULL], cache_us[CACHE_MODE_FULL],
+		          cycle_us[CACHE_MODE_RANGE], cache_us[CACHE_MODE_RANGE],
+		          (cycle_us[CACHE_MODE_FULL] > cycle_us[CACHE_MODE_RANGE]) ?
+		          cycle_us[CACHE_MODE_FULL] - cycle_us[CACHE_MODE_RANGE] : 0);
+		dbgflush();
+	}
+
+	if (failed)
+		dbgprintf("\nWARNING: %ld cycles failed - timings include error paths\n", failed);
+
+	dbgprintf("\nNote: full-flush times exclude the refill cost every other task\n");
+	dbgprintf("pays after each CacheClearU().\n\n");
+
+	SetDMACacheMode(saved_mode);
+	ResetCacheStats();
+}
+
+/*
+ * Time DMA + verify into CHIP RAM with CPU verify and with DMA readback,
+ * and estimate what readback saved over the sweep just run
+ */
+static void ReportReadbackSaving(volatile struct ncr710 *ncr)
+{
+	UBYTE *src = g_cpufastl_buf1 ? g_cpufastl_buf1 : g_chip_buf2;
+	UBYTE *dst = g_chip_buf1;
+	ULONG sweep_count = g_chip_verify_count;
+	ULONG sweep_micros = g_chip_verify_micros;
+	ULONG cpu_us, rb_us, size, iter, num_sizes = 0;
+	LONG saved = 0;
+	ULONG failed = 0;
+	BOOL readback = g_readback_verify;
+	struct EClockVal t0, t1;
+	struct TestResult result;
+
+	if (!dst || !src || !g_readback_buf)
+		return;
+
+	for (size = MIN_TEST_SIZE; size <= MAX_TEST_SIZE; size *= 2)
+		num_sizes++;
+
+	dbgprintf("\n=== CHIP Destination Verify: CPU vs DMA Readback ===\n");
+	dbgprintf("%ld DMA+verify cycles per size, 0x%08lx -> 0x%08lx\n\n",
+	          (ULONG)VERIFY_BENCH_ITERATIONS, (ULONG)src, (ULONG)dst);
+	dbgprintf("   size |   cpu us  readback us | saved us\n");
+
+	for (size = MIN_TEST_SIZE; size <= MAX_TEST_SIZE; size *= 2) {
+		FillPattern(src, size, PATTERN_RANDOM);
+
+		SetReadbackVerify(FALSE);
+		ReadTimer(&t0);
+		for (iter = 0; iter < VERIFY_BENCH_ITERATIONS; iter++) {
+			if (RunDMAVerified(ncr, src, dst, size, &result) != TEST_SUCCESS)
+				failed++;
+		}
+		ReadTimer(&t1);
+		cpu_us = ElapsedMicros(&t0, &t1) / VERIFY_BENCH_ITERATIONS;
+
+		SetReadbackVerify(TRUE);
+		ReadTimer(&t0);
+		for (iter = 0; iter < VERIFY_BENCH_ITERATIONS; iter++) {
+			if (RunDMAVerified(ncr, src, dst, size, &result) != TEST_SUCCESS)
+				failed++;
+		}
+		ReadTimer(&t1);
+		rb_us = ElapsedMicros(&t0, &t1) / VERIFY_BENCH_ITERATIONS;
+
+		dbgprintf("  %5ld | %8ld %12ld | %8ld\n", size, cpu_us, rb_us,
+		          (LONG)cpu_us - (LONG)rb_us);
+
+		// Every CHIP destination pair of the sweep ran each size equally often
+		saved += ((LONG)cpu_us - (LONG)rb_us) * (LONG)(sweep_count / num_sizes);
+	}
+
+	SetReadbackVerify(readback);
+
+	if (failed)
+		dbgprintf("\nWARNING: %ld cycles failed - timings include error paths\n", failed);
+
+	dbgprintf("\nSweep: %ld CHIP destination cycles, %ld ms DMA+verify with %s\n",
+	          sweep_count, sweep_micros / 1000,
+	          readback ? "readback" : "CPU verify");
+	if (readback)
+		dbgprintf("Estimated wall time saved by readback: %ld ms\n\n", saved / 1000);
+	else
+		dbgprintf("Estimated wall time readback would save: %ld ms\n\n", saved / 1000);
+	dbgflush();
 }
 
 /*
  * Test DMA transfer from one buffer to another
+ * Returns the RunComprehensiveTest() status, TEST_SUCCESS when skipped
  */
-static void TestDMATransfer(volatile struct ncr710 *ncr,
-                             UBYTE *src_buf, const char *src_name,
-                             UBYTE *dst_buf, const char *dst_name)
+static LONG TestDMATransfer(volatile struct ncr710 *ncr,
+                            UBYTE *src_buf, const char *src_name,
+                            UBYTE *dst_buf, const char *dst_name)
 {
+	LONG status;
+
 	if (!src_buf || !dst_buf) {
 		dbgprintf("*** Skipping: %s -> %s (buffer not available) ***\n",
 		       src_name, dst_name);
-		return;
+		return TEST_SUCCESS;
 	}
 
 	dbgprintf("*** Test: %s -> %s ***", src_name, dst_name);
-	if (RunComprehensiveTest(ncr, src_buf, dst_buf, TEST_BUFFER_SIZE) == 0)
+	status = RunComprehensiveTest(ncr, src_buf, dst_buf, TEST_BUFFER_SIZE);
+	if (status == TEST_SUCCESS)
 	{
 		dbgprintf(" PASSED ***\n");
 	}
+	else if (status == TEST_ABORTED)
+	{
+		dbgprintf(" ABORTED ***\n");
+	}
 	else
 	{
 		dbgprintf(" FAILED ***\n");
 	}
-}
 
-/*
- * Memory buffer descriptor
- */
-struct MemoryBuffer {
-	UBYTE **buf;
-	const char *name;
-};
+	return status;
+}
 
 /*
  * Test scatter-gather DMA operations
@@ -704,7 +1080,7 @@ static void TestScatterGather(volatile struct ncr710 *ncr, int verbosity)
 	if (verbosity > 1) dbgprintf("\n=== Scatter-Gather DMA Tests ===\n"); 
 
 	// Allocate destination buffer for gathered data (in CPU_FASTL)
-	gather_dest = AllocMem(MAX_SG_SEGMENTS * SG_SEGMENT_SIZE, MEMF_FAST | MEMF_CLEAR);
+	gather_dest = PoolAlloc(POOL_FAST, MAX_SG_SEGMENTS * SG_SEGMENT_SIZE);
 	if (!gather_dest) {
 		dbgprintf("ERROR: Could not allocate gather destination buffer\n");
 		return;
@@ -712,12 +1088,14 @@ static void TestScatterGather(volatile struct ncr710 *ncr, int verbosity)
 	if (verbosity > 1) dbgprintf("Gather destination: 0x%08lx\n", (ULONG)gather_dest);
 
 	// Allocate verification buffer
-	verify_buf = AllocMem(MAX_SG_SEGMENTS * SG_SEGMENT_SIZE, MEMF_FAST | MEMF_CLEAR);
+	verify_buf = PoolAlloc(POOL_FAST, MAX_SG_SEGMENTS * SG_SEGMENT_SIZE);
 	if (!verify_buf) {
 		dbgprintf("ERROR: Could not allocate verification buffer\n");
-		FreeMem(gather_dest, MAX_SG_SEGMENTS * SG_SEGMENT_SIZE);
+		PoolFree(gather_dest, MAX_SG_SEGMENTS * SG_SEGMENT_SIZE);
 		return;
 	}
+	memset(gather_dest, 0, MAX_SG_SEGMENTS * SG_SEGMENT_SIZE);
+	memset(verify_buf, 0, MAX_SG_SEGMENTS * SG_SEGMENT_SIZE);
 
 	// Test 1: Gather from different memory regions
 	if (verbosity > 1) dbgprintf("\n*** Test 1: Gather from multiple memory regions ***\n");
@@ -839,55 +1217,44 @@ static void TestScatterGather(volatile struct ncr710 *ncr, int verbosity)
 	}
 
 cleanup:
-	if (gather_dest)
-		FreeMem(gather_dest, MAX_SG_SEGMENTS * SG_SEGMENT_SIZE);
-	if (verify_buf)
-		FreeMem(verify_buf, MAX_SG_SEGMENTS * SG_SEGMENT_SIZE);
+	PoolFree(gather_dest, MAX_SG_SEGMENTS * SG_SEGMENT_SIZE);
+	PoolFree(verify_buf, MAX_SG_SEGMENTS * SG_SEGMENT_SIZE);
 }
 
 
 /*
- * Test DMA between different memory types
+ * Allocate the SCRIPTS buffer and the per-region test buffers
+ * Returns 0 on success, -1 if the minimum set (SCRIPTS + CHIP) failed
  */
-void TestMemoryTypes(volatile struct ncr710 *ncr)
+static LONG AllocateTestBuffers(void)
 {
-	int src_idx, dst_idx;
-
-	// Define all memory buffers
-	struct MemoryBuffer buffers[] = {
-		{ &g_chip_buf1,     "CHIP"     },
-		{ &g_chip_buf2,     "CHIP"     },
-		{ &g_mbfast_buf1,   "MB_FAST"  },
-		{ &g_mbfast_buf2,   "MB_FAST"  },
-		{ &g_cpufastl_buf1, "CPU_FASTL"},
-		{ &g_cpufastl_buf2, "CPU_FASTL"}
-//		{ &g_cpufastu_buf1, "CPU_FASTU"},
-//		{ &g_cpufastu_buf2, "CPU_FASTU"}
-	};
-	int num_buffers = sizeof(buffers) / sizeof(buffers[0]);
-
 	atexit(CleanupBuffers);
 
-	dbgprintf("\n=== NCR 53C710 DMA Memory Test Tool ===\n\n");
-
-	// Allocate SCRIPTS buffer in FAST memory
-	dbgprintf("Allocating SCRIPTS buffer in FAST memory...\n");
-	g_scripts_buf = AllocMem(256, MEMF_FAST | MEMF_CLEAR);
+	// Allocate SCRIPTS buffer in the fastest region for instruction fetch
+	dbgprintf("Allocating SCRIPTS buffer in %s memory...\n", ScriptMemName());
+	// Must not cross a page so DSP can be given one physical address
+	g_scripts_buf = AllocScriptMem(SCRIPTS_BUF_SIZE);
 	if (!g_scripts_buf) {
 		dbgprintf("ERROR: Could not allocate SCRIPTS buffer\n");
-		goto cleanup;
+		return -1;
 	}
-	dbgprintf("  scripts_buf: 0x%08lx %s\n\n", (ULONG)g_scripts_buf,
+	dbgprintf("  scripts_buf: 0x%08lx (phys 0x%08lx) %s\n\n", (ULONG)g_scripts_buf,
+	       DMAPhysAddr(g_scripts_buf),
 	       ((ULONG)g_scripts_buf & 3) ? "WARNING: NOT LONGWORD ALIGNED!" : "(aligned)");
 
+	// FAST scratch for CHIP destination readback - optional
+	g_readback_buf = PoolAlloc(POOL_FAST, MAX_TEST_SIZE);
+	if (!g_readback_buf)
+		dbgprintf("WARNING: No readback buffer - CHIP destinations verified by CPU\n\n");
+
 	// Allocate chip memory buffers
 	dbgprintf("Allocating chip memory buffers...\n");
-	g_chip_buf1 = AllocMem(TEST_BUFFER_SIZE, MEMF_CHIP | MEMF_CLEAR);
-	g_chip_buf2 = AllocMem(TEST_BUFFER_SIZE, MEMF_CHIP | MEMF_CLEAR);
+	g_chip_buf1 = AllocTestBuffer(POOL_CHIP);
+	g_chip_buf2 = AllocTestBuffer(POOL_CHIP);
 
 	if (!g_chip_buf1 || !g_chip_buf2) {
 		dbgprintf("ERROR: Could not allocate chip memory buffers\n");
-		goto cleanup;
+		return -1;
 	}
 
 	dbgprintf("  chip_buf1: 0x%08lx %s\n", (ULONG)g_chip_buf1,
@@ -897,8 +1264,8 @@ void TestMemoryTypes(volatile struct ncr710 *ncr)
 
 	// Allocate MB_FAST buffers
 	dbgprintf("Allocating MB_FAST buffers...\n");
-	g_mbfast_buf1 = AllocInRange(MB_FAST_START, MB_FAST_END, TEST_BUFFER_SIZE+4, "MB_FAST");
-	g_mbfast_buf2 = AllocInRange(MB_FAST_START, MB_FAST_END, TEST_BUFFER_SIZE+4, "MB_FAST"); 
+	g_mbfast_buf1 = AllocTestBuffer(POOL_MB_FAST);
+	g_mbfast_buf2 = AllocTestBuffer(POOL_MB_FAST);
 	if (g_mbfast_buf1 && g_mbfast_buf2) {
 		dbgprintf("  mbfast_buf1: 0x%08lx %s\n", (ULONG)g_mbfast_buf1,
 		       ((ULONG)g_mbfast_buf1 & 3) ? "WARNING: NOT LONGWORD ALIGNED!" : "(aligned)");
@@ -908,8 +1275,8 @@ void TestMemoryTypes(volatile struct ncr710 *ncr)
 
 	// Allocate CPU_FASTL buffers
 	dbgprintf("\nAllocating CPU_FASTL buffers...\n");
-	g_cpufastl_buf1 = AllocInRange(CPU_FASTL_START, CPU_FASTL_END, TEST_BUFFER_SIZE, "CPU_FASTL");
-	g_cpufastl_buf2 = AllocInRange(CPU_FASTL_START, CPU_FASTL_END, TEST_BUFFER_SIZE, "CPU_FASTL");
+	g_cpufastl_buf1 = AllocTestBuffer(POOL_CPU_FASTL);
+	g_cpufastl_buf2 = AllocTestBuffer(POOL_CPU_FASTL);
 	if (g_cpufastl_buf1 && g_cpufastl_buf2) {
 		dbgprintf("  cpufastl_buf1: 0x%08lx %s\n", (ULONG)g_cpufastl_buf1,
 		       ((ULONG)g_cpufastl_buf1 & 3) ? "WARNING: NOT LONGWORD ALIGNED!" : "(aligned)");
@@ -919,8 +1286,8 @@ void TestMemoryTypes(volatile struct ncr710 *ncr)
 
 	// Allocate CPU_FASTU buffers
 	dbgprintf("\nAllocating CPU_FASTU buffers...\n");
-	g_cpufastu_buf1 = AllocInRange(CPU_FASTU_START, CPU_FASTU_END, TEST_BUFFER_SIZE, "CPU_FASTU");
-	g_cpufastu_buf2 = AllocInRange(CPU_FASTU_START, CPU_FASTU_END, TEST_BUFFER_SIZE, "CPU_FASTU");
+	g_cpufastu_buf1 = AllocTestBuffer(POOL_CPU_FASTU);
+	g_cpufastu_buf2 = AllocTestBuffer(POOL_CPU_FASTU);
 	if (g_cpufastu_buf1 && g_cpufastu_buf2) {
 		dbgprintf("  cpufastu_buf1: 0x%08lx %s\n", (ULONG)g_cpufastu_buf1,
 		       ((ULONG)g_cpufastu_buf1 & 3) ? "WARNING: NOT LONGWORD ALIGNED!" : "(aligned)");
@@ -928,45 +1295,102 @@ void TestMemoryTypes(volatile struct ncr710 *ncr)
 		       ((ULONG)g_cpufastu_buf2 & 3) ? "WARNING: NOT LONGWORD ALIGNED!" : "(aligned)");
 	}
 
+	return 0;
+}
+
+/*
+ * Test DMA between different memory types
+ * A phase is journalled as done only if Ctrl-C did not cut it short;
+ * after an abort the run ends and --resume picks it up again
+ */
+void TestMemoryTypes(volatile struct ncr710 *ncr)
+{
+	int src_idx, dst_idx;
+	LONG status = TEST_SUCCESS;
+	BOOL resumed;
+
 	dbgprintf("\n=== Starting DMA Tests ===\n");
 
-	// Test all permutations: every buffer to every other buffer
-	for (src_idx = 0; src_idx < num_buffers; src_idx++) {
-		for (dst_idx = 0; dst_idx < num_buffers; dst_idx++) {
-			// Skip if source and destination are the same buffer
-			if (src_idx == dst_idx)
-				continue;
+	resumed = JournalStart();
+	if (resumed && JournalPhaseDone(JPHASE_DONE)) {
+		dbgprintf("Journal campaign is complete - run without --resume to start over\n");
+		return;
+	}
+
+	// Cells that failed on earlier runs go first
+	LoadHistory();
+	if (!JournalPhaseDone(JPHASE_HISTORY)) {
+		if (RunHistoryCells(ncr, FALSE))
+			dbgprintf("\n");
+		if (g_user_abort)
+			goto aborted;
+		JournalPhase(JPHASE_HISTORY);
+	}
 
-			TestDMATransfer(ncr,
-			                *buffers[src_idx].buf, buffers[src_idx].name,
-			                *buffers[dst_idx].buf, buffers[dst_idx].name);
+	if (!JournalPhaseDone(JPHASE_SWEEP)) {
+		// Test all permutations: every buffer to every other buffer
+		for (src_idx = 0; src_idx < g_num_test_buffers && status != TEST_ABORTED; src_idx++) {
+			for (dst_idx = 0; dst_idx < g_num_test_buffers && status != TEST_ABORTED; dst_idx++) {
+				// Skip if source and destination are the same buffer
+				if (src_idx == dst_idx)
+					continue;
+
+				status = TestDMATransfer(ncr,
+				                         *g_test_buffers[src_idx].buf, g_test_buffers[src_idx].name,
+				                         *g_test_buffers[dst_idx].buf, g_test_buffers[dst_idx].name);
+				dbgflush();
+			}
 		}
+
+		SaveHistory();
+		if (g_user_abort)
+			goto aborted;
+
+		dbgprintf("\n=== Basic Tests Complete ===\n\n");
+		JournalPhase(JPHASE_SWEEP);
+	} else {
+		dbgprintf("Region sweep finished in an earlier run\n");
 	}
 
-	dbgprintf("\n=== Basic Tests Complete ===\n\n");
+	if (!JournalPhaseDone(JPHASE_READBACK)) {
+		ReportReadbackSaving(ncr);
+		if (g_user_abort)
+			goto aborted;
+		JournalPhase(JPHASE_READBACK);
+	}
 
 	dbgprintf("\n=== Scatter Gather Testing ===\n\n");
 
 	// Run scatter-gather tests
-	TestScatterGather(ncr, 1);
+	if (!JournalPhaseDone(JPHASE_SG)) {
+		TestScatterGather(ncr, 1);
+		if (g_user_abort)
+			goto aborted;
+		JournalPhase(JPHASE_SG);
+	}
 
-	for (int i = 0; i < 1000; i++)
-	{
-		// Run scatter-gather tests
-		TestScatterGather(ncr, 0);		
+	// Stress run on preallocated buffers, resumes at the journalled iteration
+	if (!JournalPhaseDone(JPHASE_STRESS)) {
+		SoakScatterGather(ncr, 0, SG_STRESS_ITERATIONS, 0);
+		if (g_user_abort)
+			goto aborted;
+		JournalPhase(JPHASE_STRESS);
 	}
 
 	dbgprintf("\n=== Scatter Gather Tests Complete ===\n\n");
+	JournalFinish();
+	dbgflush();
+	return;
 
-
-cleanup:
-	CleanupBuffers();
+aborted:
+	dbgprintf("\n=== DMA Tests Stopped by User ===\n\n");
+	dbgflush();
 }
 
 /*
  * Main test entry point
  */
-void TestMain(void)
+void TestMain(struct TestOptions *opts)
 {
 	volatile struct ncr710 *ncr;
 
@@ -986,8 +1410,124 @@ void TestMain(void)
 		return;
 	}
 
-	// Run the tests
-	TestMemoryTypes(ncr);
+	// Timer is optional - throughput figures read 0 without it
+	InitTimer();
+
+	SetDMACacheMode(opts->full_flush ? CACHE_MODE_FULL : CACHE_MODE_RANGE);
+	SetReadbackVerify(!opts->cpu_verify);
+	SetBisectEnabled(!opts->no_bisect);
+	SetStatsConfig(opts->stats_reps, opts->stats_warmup);
+	SetJournal(opts->journal_path, opts->resume);
+
+	dbgprintf("\n=== NCR 53C710 DMA Memory Test Tool ===\n\n");
+
+	// One arena per region for every DMA buffer from here on
+	if (PoolInit(POOL_ARENA_SIZE) != 0)
+		dbgprintf("WARNING: No CHIP pool - tests needing CHIP buffers will fail\n\n");
+
+	// Scripts go where the chip fetches them fastest
+	PlaceScripts(ncr, ExecuteScript);
+
+	// Hold output in the log ring while tests run, flushed between phases
+	if (!opts->direct_log)
+		dbgdefer(1);
+
+	if (AllocateTestBuffers() == 0) {
+		dbgflush();
+
+		// Run the selected tests
+		switch (opts->mode) {
+		case MODE_MATRIX:
+			TestAlignmentMatrix(ncr);
+			break;
+
+		case MODE_TUNE:
+			TestBurstTuning(ncr, opts->save_config);
+			break;
+
+		case MODE_CACHE:
+			TestCacheOverhead(ncr);
+			break;
+
+		case MODE_SOAK:
+			SoakScatterGather(ncr, opts->soak_minutes * 60, 0,
+			                  opts->report_minutes * 60);
+			break;
+
+		case MODE_FUZZ:
+			FuzzScatterGather(ncr, opts->fuzz_cases, opts->fuzz_seed);
+			break;
+
+		case MODE_INDIRECT:
+			TestTableIndirect(ncr);
+			break;
+
+		case MODE_COPY:
+			// The library brings its own interrupt server
+			CleanupDMATestInterrupts(ncr);
+			TestDMACopyLib(ncr);
+			SetupDMATestInterrupts(ncr);
+			break;
+
+		case MODE_PATCH:
+			CleanupDMATestInterrupts(ncr);
+			RunCopyMemPatch(ncr, opts->patch_threshold);
+			SetupDMATestInterrupts(ncr);
+			break;
+
+		case MODE_QUICK:
+			QuickSweep(ncr);
+			break;
+
+		case MODE_CONTEND:
+			TestBusContention(ncr, opts->load_kind, opts->load_other);
+			break;
+
+		case MODE_CROSSOVER:
+			TestCopyCrossover(ncr);
+			break;
+
+		case MODE_SCALE:
+			TestLargeTransfers(ncr);
+			break;
+
+		case MODE_COSTMODEL:
+			TestCostModel(ncr);
+			break;
+
+		case MODE_PLACEMENT:
+			TestScriptPlacement(ncr, ExecuteScript);
+			break;
+
+		case MODE_MICROOPS:
+			TestMicroOps(ncr);
+			break;
+
+		case MODE_FIFO:
+			TestFifoTimeline(ncr);
+			break;
+
+		case MODE_STREAM:
+			TestFixedStream(ncr, opts->stream_port);
+			break;
+
+		case MODE_REPRO:
+			RunRepro(ncr, opts->repro_args, opts->repro_nargs);
+			break;
+
+		default:
+			TestMemoryTypes(ncr);
+			break;
+		}
+	}
+
+	if (opts->mode != MODE_CACHE)
+		PrintCacheStats();
+	PrintPoolStats();
+	dbgflush();
+
+	CleanupBuffers();
+	CleanupTimer();
 
 	// Cleanup interrupts
 	CleanupDMATestInterrupts(ncr);
@@ -10,6 +10,8 @@
 #include <exec/types.h>
 #include <exec/resident.h>
 #include <exec/memory.h>
+#include <devices/timer.h>
+#include "dprintf.h"
 
 /* Version information - BUILD_DATE is set by Makefile */
 #ifndef BUILD_DATE
@@ -182,23 +184,215 @@ struct rw_reg_inst {
 	*((volatile ULONG *) (((ULONG) (base)) + NCR_WRITE_OFFSET + \
 			      ((ULONG)&((struct ncr710 *)0)->reg))) = (val)
 
+/* Memory region definitions */
+#define MB_FAST_START    0x07000000UL
+#define MB_FAST_END      0x07FFFFFFUL
+#define CPU_FASTL_START  0x08000000UL
+#define CPU_FASTL_END    0x0FFFFFFFUL
+#define CPU_FASTU_START  0x10000000UL
+#define CPU_FASTU_END    0x18000000UL
+
 /* Test parameters */
 #define TEST_BUFFER_SIZE  (128*1024)   // 64KB test buffer
 #define MAX_TEST_SIZE     (16*1024)   // Max DMA transfer size per test
 #define MIN_TEST_SIZE     4           // Minimum DMA transfer size
 #define NUM_TEST_PATTERNS 5           // Number of test patterns
+#define SCRIPT_ABORT_US   50000       // Longest wait for the abort interrupt (Ctrl-C)
 
 /* Scatter-gather test parameters */
 #define MAX_SG_SEGMENTS   8           // Maximum scatter-gather segments
 #define SG_SEGMENT_SIZE   (4*1024)    // Size of each scatter-gather segment
 #define SG_STRESS_ITERATIONS 1000     // Stress test iteration count
 
+/* Scatter-gather soak */
+#define SOAK_DEFAULT_MINUTES 60       // Run time if none given
+#define SOAK_REPORT_MINUTES  5        // Report interval if none given
+#define SOAK_PATTERN_ITERATIONS 16    // Iterations per seed/pattern/offset
+
+/* Scatter-gather fuzzer */
+#define FUZZ_DEFAULT_CASES 1000       // Cases per run if none given
+#define FUZZ_MAX_SEGMENTS  512        // Segments per chain
+#define FUZZ_MAX_SEG_LEN   4096       // Longest single segment
+#define FUZZ_DEST_SIZE     (256*1024) // Gather destination
+#define FUZZ_MAX_FAILED    32         // Failing seeds listed in the summary
+
+/* Table-indirect scatter/gather */
+#define INDIRECT_ITERATIONS     32        // Transfers timed per layout
+#define INDIRECT_SCATTER_OFFSET (64*1024) // Scatter destinations within each buffer
+
+/* Alignment matrix parameters */
+#define MATRIX_MAX_ALIGN  16          // Source/destination misalignment 0-15
+#define MATRIX_GUARD      16          // Guard bytes checked around each destination
+#define MATRIX_GUARD_BYTE 0xA5        // Guard fill value
+
+/* DMA cache maintenance modes */
+#define CACHE_MODE_RANGE  0           // CachePreDMA/CachePostDMA on the ranges involved
+#define CACHE_MODE_FULL   1           // CacheClearU() around every DMA (old behaviour)
+
+/* Address translation */
+#define DMA_PAGE_SIZE     4096        // Smallest MMU page - split granularity
+#define MAX_DMA_SEGMENTS  16          // Physical segments per mapped range
+#define MAX_MOVE_SIZE     0x00FFFFFF  // 24-bit memory-move byte count
+
+/* SCRIPTS buffer */
+#define SCRIPTS_BUF_SIZE  512         // Shared buffer for generated SCRIPTS
+#define MAX_SCRIPT_MOVES  ((SCRIPTS_BUF_SIZE - sizeof(struct jump_inst)) / \
+                           sizeof(struct memmove_inst))
+
+/* DMA directions for cache maintenance */
+#define DMA_DIR_READ      1           // Chip reads RAM (sources, SCRIPTS)
+#define DMA_DIR_WRITE     2           // Chip writes RAM (destinations)
+#define DMA_DIR_BOTH      3           // Chip reads and writes (DSA)
+
+/* Cache overhead benchmark */
+#define CACHE_BENCH_ITERATIONS 32     // Transfers per size and mode
+
+/* CopyMem()/CopyMemQuick() offload patch */
+#define PATCH_CAL_MIN        256      // Smallest size calibrated
+#define PATCH_CAL_MAX        (256*1024) // Largest size calibrated (own buffers)
+#define PATCH_CAL_ITERATIONS 8        // Copies per size and method
+#define PATCH_SETTLE_TICKS   10       // Quiet ticks before unloading the patch
+
+/* DMA under CPU bus contention */
+#define CONTEND_ITERATIONS  64        // DMA transfers / CPU passes per measurement
+#define CONTEND_DMA_SIZE    (16*1024) // Bytes per DMA transfer
+#define CONTEND_LOAD_OFFSET (64*1024) // CPU load area within a test buffer
+#define CONTEND_LOAD_SIZE   (32*1024) // Bytes per CPU load pass
+#define CONTEND_STACK_SIZE  4096      // Load task stack
+
+/* CPU load kinds */
+#define LOAD_READ         0
+#define LOAD_WRITE        1
+#define LOAD_MOVE16       2
+
+/* DMA vs CPU copy crossover */
+#define CROSSOVER_MIN_SIZE       16         // Smallest size timed
+#define CROSSOVER_BYTES          (64*1024)  // Bytes copied per size and method
+#define CROSSOVER_MIN_ITERATIONS 8          // Copies per size and method at least
+
+/* Large-transfer scaling */
+#define SCALE_MIN_SIZE        (16*1024)    // Smallest size timed
+#define SCALE_MAX_SIZE        (MAX_MOVE_SIZE & ~(DMA_PAGE_SIZE - 1))  // One move
+#define SCALE_RESERVE         (512*1024)   // Left free in each region
+#define SCALE_BYTES           (4*1024*1024)  // Bytes moved per size
+#define SCALE_MIN_ITERATIONS  2            // Transfers per size at least
+#define SCALE_PLATEAU_PCT     95           // Plateau: within this % of peak
+
+/* Transfer cost model */
+#define COSTMODEL_SIZES   32          // Evenly spaced sizes MIN_TEST_SIZE..MAX_TEST_SIZE
+#define COSTMODEL_REPEATS 8           // Timed transfers per size
+
+/* DMA buffer pools */
+#define POOL_CHIP         0
+#define POOL_MB_FAST      1
+#define POOL_CPU_FASTL    2
+#define POOL_CPU_FASTU    3
+#define NUM_POOLS         4
+#define POOL_FAST         NUM_POOLS   // First FAST pool with room
+#define POOL_ARENA_SIZE   (512*1024)  // Reserved per region by ncr_dmatest
+#define POOL_SCSI_ARENA   (32*1024)   // Reserved per region by ncr_scsi
+#define POOL_MIN_ARENA    (32*1024)   // Smallest arena worth having
+#define POOL_MIN_BLOCK    16          // Smallest block - one cache line
+#define POOL_CLASSES      15          // Size classes, 16 bytes to 256 KB
+
+/* SCRIPTS placement */
+#define PLACE_INSTRUCTIONS 256        // NOPs/moves per timed script (NOP_256 in ncr_placement.c)
+#define PLACE_LOOPS        8          // Scripts run per timed run
+#define PLACE_SCRIPT_SIZE  (PLACE_INSTRUCTIONS * sizeof(struct memmove_inst) + \
+                            sizeof(struct jump_inst))
+#define PLACE_MAGIC        0x5C1A7E00 // INT value that ends a placement script
+
+/* SCRIPTS micro-op costs */
+#define MICRO_CHAIN        250        // Instructions per timed chain
+#define MICRO_SCRIPT_SIZE  (MICRO_CHAIN * sizeof(struct memmove_inst) + \
+                            sizeof(struct jump_inst))
+
+/* DMA FIFO occupancy timeline */
+#define FIFO_MOVE_SIZE     (64*1024)  // Bytes per sampled transfer
+#define FIFO_MAX_SAMPLES   8192       // Register samples kept per transfer
+#define FIFO_STAMP_EVERY   64         // Samples per EClock stamp
+#define FIFO_BINS          16         // Timeline rows per transfer
+#define FIFO_DEPTH         64         // Bytes the DMA FIFO holds
+#define FIFO_SCRIPT_SIZE   (2 * MAX_DMA_SEGMENTS * sizeof(struct memmove_inst) + \
+                            sizeof(struct jump_inst))
+
+/* Fixed-address (DMODE FAM) streaming */
+#define STREAM_BUF_SIZE    (64*1024)  // RAM side of each move
+#define STREAM_MOVES       16         // Moves per run, 1 MB in all
+#define STREAM_SCRIPT_SIZE (STREAM_MOVES * sizeof(struct memmove_inst) + \
+                            sizeof(struct jump_inst))
+
+/* Repeated measurements */
+#define STATS_DEFAULT_REPS   5        // Runs kept per measurement
+#define STATS_DEFAULT_WARMUP 1        // Runs discarded before them
+#define STATS_MAX_REPS       64       // Largest --reps
+#define STATS_NOISY_CV       50       // CV (0.1%) above which a figure is flagged
+
+/* Result journal of the standard sweep */
+#define JOURNAL_DEFAULT_PATH "S:ncrtest.journal"
+#define JOURNAL_MAX_PATH     128
+#define JOURNAL_BUF_SIZE     1024     // Records held before a write
+#define JOURNAL_SYNC_CELLS   16       // Sweep cells per write to disk
+#define JOURNAL_STRESS_SYNC  100      // Stress iterations per progress record
+#define JOURNAL_HANG_RETRIES 2        // Resumes stuck at one cell before it is skipped
+#define JOURNAL_MAX_BUFFERS  8        // g_test_buffers[] entries a key can hold
+
+/* Journal phases */
+#define JPHASE_HISTORY    0           // Reruns of remembered failures
+#define JPHASE_SWEEP      1           // Region sweep
+#define JPHASE_READBACK   2           // Readback benchmark
+#define JPHASE_SG         3           // Scatter-gather test
+#define JPHASE_STRESS     4           // Scatter-gather stress
+#define JPHASE_DONE       5           // Whole campaign
+
+/* CHIP destination verify benchmark */
+#define VERIFY_BENCH_ITERATIONS 16    // DMA+verify cycles per size and method
+
+/* Burst tuning parameters */
+#define BURST_ENV_NAME    "ncrtest.burst"  // ENV:/ENVARC: variable for tuned config
+#define NUM_TUNE_CONFIGS  16          // 4 burst lengths x CDIS on/off x FA on/off
+
+/* Failure history and quick sweep */
+#define HISTORY_ENV_NAME  "ncrtest.history"  // ENV:/ENVARC: variable for failed cells
+#define HISTORY_MAX_CELLS 32          // Cells remembered
+#define HISTORY_MAX_FAILS 9999        // Count limit, keeps the variable short
+
+/* Failure bisection */
+#define BISECT_MAX_PER_RUN   4        // Sweep failures bisected per run
+#define BISECT_TRIES         8        // Runs per candidate case
+#define BISECT_CONFIRM_TRIES 64       // Runs of the final case
+#define BISECT_FILL_SEED     0xB15EC7ED  // PATTERN_RANDOM seed of every run
+#define REPRO_ITERATIONS     256      // Runs in repro mode
+#define REPRO_MAX_ARGS       7        // src dst src_off dst_off len pattern burst
+
+/* Test modes selected on the command line */
+#define MODE_STANDARD     0           // Full region sweep + scatter-gather
+#define MODE_MATRIX       1           // Alignment / odd-length matrix
+#define MODE_TUNE         2           // DMODE/CTEST7/DCNTL burst tuner
+#define MODE_CACHE        3           // Full-flush vs range cache maintenance cost
+#define MODE_SOAK         4           // Time-bounded scatter-gather soak
+#define MODE_FUZZ         5           // Seeded scatter-gather fuzzer
+#define MODE_INDIRECT     6           // Table-indirect scatter/gather vs inline
+#define MODE_COPY         7           // Asynchronous DMA copy library
+#define MODE_PATCH        8           // Resident CopyMem()/CopyMemQuick() offload
+#define MODE_REPRO        9           // Rerun one transfer printed by the bisector
+#define MODE_QUICK        10          // History cells + sparse region sweep
+#define MODE_CONTEND      11          // DMA throughput under CPU load
+#define MODE_CROSSOVER    12          // DMA vs CPU copy crossover per region pair
+#define MODE_SCALE        13          // 16 KB to 16 MB single-move scaling
+#define MODE_COSTMODEL    14          // Fixed vs per-byte cost fit per region pair
+#define MODE_PLACEMENT    15          // SCRIPTS fetch time per memory region
+#define MODE_MICROOPS     16          // ns per SCRIPTS instruction by type
+#define MODE_FIFO         17          // DMA FIFO occupancy timeline of one long move
+#define MODE_STREAM       18          // Fixed-address (FAM) port streaming
+
 /* Test status codes */
 #define TEST_SUCCESS      0
 #define TEST_FAILED       1
 #define TEST_TIMEOUT      2
 #define TEST_DMA_ERROR    3
 #define TEST_VERIFY_ERROR 4
+#define TEST_ABORTED      5           // Ctrl-C while waiting for the chip
 
 /* Test pattern types */
 #define PATTERN_ZEROS     0
@@ -207,6 +401,36 @@ struct rw_reg_inst {
 #define PATTERN_ALTERNATING 3
 #define PATTERN_RANDOM    4
 
+/* Verify failure analysis */
+#define ERRMAP_BUCKETS       64       // Characters in the where-map
+#define ERRMAP_SHIFT_WINDOW  32       // Bytes compared for shift/repeat
+#define ERRMAP_MAX_SHIFT     32       // Largest shift looked for
+#define ERRMAP_STUCK_MIN     8        // One-way flips before a line looks stuck
+#define ERRMAP_MAX_PER_RUN   4        // Sweep failures analysed per run
+#define ERRMAP_NONE          0xFFFFFFFF
+
+/* Whole-range verify failure statistics (ncr_errmap.c) */
+struct ErrorMap {
+	ULONG size;			// Bytes in the range
+	ULONG bucket_bytes;		// Range bytes per buckets[] entry
+	ULONG bad_bytes;
+	ULONG bad_longs;		// Destination longwords with any bad bit
+	ULONG single_bit_longs;		// ... with exactly one bad bit
+	ULONG first_bad;		// Offset, ERRMAP_NONE if clean
+	ULONG last_bad;
+	UBYTE first_expected;
+	UBYTE first_actual;
+	UWORD pad;
+	ULONG set_flips[32];		// Per data line: read 1, wrote 0
+	ULONG clear_flips[32];		// Per data line: read 0, wrote 1
+	ULONG line_pos[16];		// Bad bytes by address & 15
+	ULONG buckets[ERRMAP_BUCKETS];	// Bad bytes per slice of the range
+	ULONG read_zero;		// Bad bytes that read 0x00
+	ULONG read_ones;		// Bad bytes that read 0xFF
+	LONG shift;			// Data late (>0) / early (<0) at first error
+	ULONG repeat;			// Destination repeats this many bytes
+};
+
 /* Test results structure */
 struct TestResult {
 	ULONG test_number;
@@ -219,20 +443,223 @@ struct TestResult {
 	ULONG duration_ticks;
 };
 
+/* One physically contiguous piece of a DMA range */
+struct DMASegment {
+	ULONG phys;	// Physical (bus) address
+	ULONG len;	// Length in bytes
+};
+
+/* Memory buffer descriptor */
+struct MemoryBuffer {
+	UBYTE **buf;
+	const char *name;
+};
+
+/* DMA bus configuration (registers the burst tuner sweeps) */
+struct BurstConfig {
+	UBYTE dmode;		// Burst length (BL1/BL0) + function code
+	UBYTE dcntl;		// EA|COM plus optional FA
+	UBYTE ctest7;		// CDIS on/off
+	UBYTE pad;
+};
+
+/* Timed runs of one measurement (ncr_stats.c) */
+struct SampleSet {
+	ULONG *us;		// Caller's sample array
+	ULONG max;		// Its size
+	ULONG n;		// Samples kept
+	ULONG seen;		// Runs added, warm-up included
+	ULONG warmup;		// Runs discarded first
+};
+
+struct SampleStats {
+	ULONG n;
+	ULONG min_us;
+	ULONG median_us;
+	ULONG p99_us;
+	ULONG mean_us;
+	ULONG cv;		// Coefficient of variation in 0.1%
+	BOOL noisy;		// cv > STATS_NOISY_CV
+};
+
+/* Command line options */
+struct TestOptions {
+	ULONG mode;		// MODE_xxx
+	BOOL save_config;	// tune: save the recommended configuration
+	BOOL full_flush;	// --fullflush: CacheClearU() instead of range maintenance
+	BOOL direct_log;	// --direct: print immediately instead of between phases
+	BOOL cpu_verify;	// --cpuverify: CPU reads CHIP destinations directly
+	BOOL no_bisect;		// --nobisect: report sweep failures without narrowing
+	ULONG soak_minutes;	// soak: run time
+	ULONG report_minutes;	// soak: statistics interval
+	ULONG fuzz_cases;	// fuzz: number of chains
+	ULONG fuzz_seed;	// fuzz: seed of the first chain (0 = from EClock)
+	ULONG patch_threshold;	// patch: DMA from this size (0 = calibrate)
+	ULONG stream_port;	// stream: physical port address (0 = RAM stand-in)
+	ULONG load_kind;	// contend: LOAD_xxx
+	BOOL load_other;	// contend: load a region other than the destination
+	ULONG repro_args[REPRO_MAX_ARGS];	// repro: case from a bisect report
+	ULONG repro_nargs;
+	ULONG stats_reps;	// --reps: runs kept per measurement
+	ULONG stats_warmup;	// --warmup: runs discarded first
+	BOOL resume;		// --resume: skip what the journal has done
+	const char *journal_path;	// --journal: file (NULL = default)
+};
+
 /* Global SysBase pointer - defined in romstart.asm */
 extern struct ExecBase *SysBase;
 
 /* Function prototypes */
 void kprintf(char *,...);
-void dbgprintf(const char *format, ...);
 void poll_cia(ULONG microseconds);
-void TestMain(void);
+void TestMain(struct TestOptions *opts);
 LONG DetectNCR(volatile struct ncr710 *ncr);
 LONG InitNCR(volatile struct ncr710 *ncr);
 LONG ResetNCR(volatile struct ncr710 *ncr);
+void ReadBurstConfig(volatile struct ncr710 *ncr, struct BurstConfig *cfg);
+void ApplyBurstConfig(volatile struct ncr710 *ncr, struct BurstConfig *cfg);
+LONG LoadBurstConfig(struct BurstConfig *cfg);
+LONG SaveBurstConfig(struct BurstConfig *cfg);
 LONG RunDMATest(volatile struct ncr710 *ncr, UBYTE *src, UBYTE *dst, ULONG size);
+LONG RunDMAVerified(volatile struct ncr710 *ncr, UBYTE *src, UBYTE *dst,
+                    ULONG size, struct TestResult *result);
+void SetReadbackVerify(BOOL enable);
 void FillPattern(UBYTE *buffer, ULONG size, ULONG pattern_type);
+void SeedRandom(ULONG seed);
 LONG VerifyBuffer(UBYTE *src, UBYTE *dst, ULONG size, struct TestResult *result);
 void PrintTestResults(struct TestResult *result);
+void TestAlignmentMatrix(volatile struct ncr710 *ncr);
+LONG RunMatrixCell(volatile struct ncr710 *ncr, UBYTE *src_base, UBYTE *dst_base,
+                   ULONG src_align, ULONG dst_align, ULONG size,
+                   ULONG *micros, LONG *error_offset);
+void TestBurstTuning(volatile struct ncr710 *ncr, BOOL save);
+void BuildTuneConfig(ULONG index, struct BurstConfig *base, struct BurstConfig *cfg);
+void PrintTuneConfig(struct BurstConfig *cfg);
+LONG RunSweepCell(volatile struct ncr710 *ncr, UBYTE *src_base, UBYTE *dst_base,
+                  ULONG size, ULONG pattern, ULONG test_num,
+                  struct TestResult *result);
+LONG FindTestBuffer(UBYTE *buf);
+void LoadHistory(void);
+void SaveHistory(void);
+void RecordHistory(UBYTE *src_base, UBYTE *dst_base, ULONG size, ULONG pattern,
+                   LONG status);
+ULONG RunHistoryCells(volatile struct ncr710 *ncr, BOOL quick);
+void QuickSweep(volatile struct ncr710 *ncr);
+void TestBusContention(volatile struct ncr710 *ncr, ULONG kind, BOOL other);
+void TestCopyCrossover(volatile struct ncr710 *ncr);
+void TestLargeTransfers(volatile struct ncr710 *ncr);
+void TestCostModel(volatile struct ncr710 *ncr);
+void TestMicroOps(volatile struct ncr710 *ncr);
+void TestFifoTimeline(volatile struct ncr710 *ncr);
+void TestFixedStream(volatile struct ncr710 *ncr, ULONG port);
+void SetBisectEnabled(BOOL enable);
+void BisectFailure(volatile struct ncr710 *ncr, UBYTE *src_base, UBYTE *dst_base,
+                   ULONG size, ULONG pattern);
+void RunRepro(volatile struct ncr710 *ncr, ULONG *args, ULONG nargs);
+void TestCacheOverhead(volatile struct ncr710 *ncr);
+LONG ExecuteScript(volatile struct ncr710 *ncr, ULONG script_phys, ULONG magic,
+                   const char *context);
+void StartScript(volatile struct ncr710 *ncr, ULONG script_phys);
+BOOL ScriptFinished(void);
+LONG FinishScript(volatile struct ncr710 *ncr, ULONG magic, const char *context);
+LONG RunScatterGatherTest(volatile struct ncr710 *ncr, UBYTE **sources,
+                          UBYTE *dest, ULONG *sizes, ULONG num_segments);
+void SoakScatterGather(volatile struct ncr710 *ncr, ULONG seconds,
+                       ULONG max_iterations, ULONG report_seconds);
+void FuzzScatterGather(volatile struct ncr710 *ncr, ULONG cases, ULONG seed);
+void TestTableIndirect(volatile struct ncr710 *ncr);
+void TestDMACopyLib(volatile struct ncr710 *ncr);
+void RunCopyMemPatch(volatile struct ncr710 *ncr, ULONG threshold);
+
+/* DMA cache maintenance (ncr_cache.c) */
+void SetDMACacheMode(ULONG mode);
+ULONG GetDMACacheMode(void);
+ULONG DMAMapRange(APTR addr, ULONG len, ULONG dir,
+                  struct DMASegment *segs, ULONG max_segs);
+ULONG DMAPhysAddr(APTR addr);
+ULONG DMATranslateRange(APTR addr, ULONG len, struct DMASegment *segs, ULONG max_segs);
+APTR ReserveInRange(ULONG start, ULONG end, ULONG size, ULONG align, ULONG lead);
+APTR AllocDMAContig(ULONG size, ULONG flags);
+APTR AllocDMAContigIn(ULONG size, ULONG start, ULONG end);
+void FreeDMAContig(APTR mem);
+void DMACachePre(APTR addr, ULONG len, ULONG dir);
+void DMACachePost(APTR addr, ULONG len, ULONG dir);
+void DMACacheClear(void);
+void ResetCacheStats(void);
+ULONG GetCacheMicros(void);
+void PrintCacheStats(void);
+
+/* Verify failure analysis (ncr_errmap.c) */
+void ErrorMapInit(struct ErrorMap *map, ULONG size);
+void ErrorMapAdd(struct ErrorMap *map, ULONG offset, const UBYTE *expected,
+                 const UBYTE *actual, ULONG len);
+void PrintErrorMap(struct ErrorMap *map);
+ULONG AnalyzeErrors(const UBYTE *expected, const UBYTE *actual, ULONG size);
+
+/* SCRIPTS instruction builders (ncr_dmacopy.c) */
+void BuildMemMove(struct memmove_inst *inst, ULONG src, ULONG dst, ULONG len);
+void BuildIntInst(struct jump_inst *inst, ULONG magic);
+void BuildJumpInst(struct jump_inst *inst, ULONG addr);
+ULONG EmitMemMoves(struct memmove_inst *moves, ULONG max_moves,
+                   struct DMASegment *src, ULONG nsrc,
+                   struct DMASegment *dst, ULONG ndst);
+
+/* Test buffer table (ncr_dmatest.c), buf1/buf2 of each region in pairs */
+extern struct MemoryBuffer g_test_buffers[];
+extern int g_num_test_buffers;
+
+/* Set once Ctrl-C has stopped a test - a phase that sees it is incomplete */
+extern BOOL g_user_abort;
+
+/* Runs a script to its final INT magic, 0 on success (ExecuteScript()) */
+typedef LONG (*ScriptRunner)(volatile struct ncr710 *ncr, ULONG script_phys,
+                             ULONG magic, const char *context);
+
+/* DMA buffer pools (ncr_pool.c) */
+LONG PoolInit(ULONG arena_size);
+void PoolCleanup(void);
+APTR PoolAlloc(ULONG pool, ULONG size);
+BOOL PoolFree(APTR mem, ULONG size);
+void PrintPoolStats(void);
+
+/* SCRIPTS placement (ncr_placement.c) */
+void PlaceScripts(volatile struct ncr710 *ncr, ScriptRunner run);
+APTR AllocScriptMem(ULONG size);
+void FreeScriptMem(APTR mem, ULONG size);
+const char *ScriptMemName(void);
+void TestScriptPlacement(volatile struct ncr710 *ncr, ScriptRunner run);
+
+/* Result journal (ncr_journal.c) */
+void SetJournal(const char *path, BOOL resume);
+BOOL JournalStart(void);
+BOOL JournalPhaseDone(ULONG phase);
+void JournalPhase(ULONG phase);
+LONG JournalLookupCell(UBYTE *src_base, UBYTE *dst_base, ULONG size, ULONG pattern);
+void JournalRecordCell(UBYTE *src_base, UBYTE *dst_base, ULONG size, ULONG pattern,
+                       LONG status);
+ULONG JournalStressResume(ULONG *failures);
+void JournalStressProgress(ULONG iterations, ULONG failures);
+void JournalFinish(void);
+
+/* Repeated measurement statistics (ncr_stats.c) */
+void SetStatsConfig(ULONG reps, ULONG warmup);
+ULONG StatsRuns(void);
+ULONG StatsWarmup(void);
+void PrintStatsConfig(void);
+void StatsInit(struct SampleSet *set, ULONG *samples, ULONG max, ULONG warmup);
+void StatsBegin(struct SampleSet *set, ULONG *samples);
+void StatsAdd(struct SampleSet *set, ULONG us);
+LONG StatsCompute(struct SampleSet *set, struct SampleStats *st);
+ULONG StatsRate(ULONG bytes, struct SampleStats *st);
+void PrintRateStats(ULONG bytes, struct SampleStats *st);
+ULONG ISqrt64(unsigned long long v);
+
+/* EClock timing (ncr_timer.c) */
+LONG InitTimer(void);
+void CleanupTimer(void);
+void ReadTimer(struct EClockVal *ev);
+ULONG ElapsedMicros(struct EClockVal *start, struct EClockVal *end);
+ULONG ElapsedSeconds(struct EClockVal *start, struct EClockVal *end);
+ULONG CalcRate(ULONG bytes, ULONG micros);
 
 #endif /* NCR_DMATEST_H */
@@ -0,0 +1,275 @@
+/*
+ * NCR 53C710 DMA Test Tool - Verify failure analysis
+ *
+ * VerifyBuffer() stops at the first bad byte, which does not say whether
+ * the fault is one flipped bit, a stuck data line or a burst that landed
+ * in the wrong place. The error map takes one pass over the whole range,
+ * XORing expected against actual a longword at a time, and collects:
+ * - a coarse map of where in the range the bad bytes are
+ * - bad bytes by destination address within a 16-byte line (bursts)
+ * - 0->1 and 1->0 flips per data line D0-D31 (by destination address)
+ * - whether the data at the first error is shifted or repeats earlier data
+ *
+ * Ranges can be fed in pieces (ErrorMapAdd), so the SCSI tool can check a
+ * 32 MB read against its PRNG stream without a second 32 MB buffer.
+ * Shared by ncr_dmatest and ncr_scsi.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Start a map over size bytes
+ */
+void ErrorMapInit(struct ErrorMap *map, ULONG size)
+{
+	memset(map, 0, sizeof(*map));
+	map->size = size;
+	map->first_bad = ERRMAP_NONE;
+	map->bucket_bytes = (size + ERRMAP_BUCKETS - 1) / ERRMAP_BUCKETS;
+	if (!map->bucket_bytes)
+		map->bucket_bytes = 1;
+}
+
+/*
+ * Count one bad byte at 'offset' of the range, destination address 'addr'
+ */
+static void AddBadByte(struct ErrorMap *map, ULONG offset, ULONG addr,
+                       UBYTE expected, UBYTE actual)
+{
+	UBYTE x = expected ^ actual;
+	ULONG lane = addr & 3;
+	ULONG bit, line;
+
+	map->bad_bytes++;
+	if (map->first_bad == ERRMAP_NONE) {
+		map->first_bad = offset;
+		map->first_expected = expected;
+		map->first_actual = actual;
+	}
+	map->last_bad = offset;
+	map->line_pos[addr & 15]++;
+	map->buckets[offset / map->bucket_bytes]++;
+	if (actual == 0x00)
+		map->read_zero++;
+	else if (actual == 0xFF)
+		map->read_ones++;
+
+	// Lane 0 (address & 3 == 0) is D31-D24 on the big-endian bus
+	for (bit = 0; bit < 8; bit++) {
+		if (!(x & (1 << bit)))
+			continue;
+		line = (3 - lane) * 8 + bit;
+		if (actual & (1 << bit))
+			map->set_flips[line]++;
+		else
+			map->clear_flips[line]++;
+	}
+}
+
+/*
+ * Does actual[i] == ref[i + k] over the window, and is the reference
+ * not simply the same when shifted (constant patterns)?
+ */
+static BOOL WindowMatches(const UBYTE *actual, const UBYTE *ref, LONG k, ULONG len)
+{
+	ULONG i;
+	BOOL differs = FALSE;
+
+	for (i = 0; i < len; i++) {
+		if (actual[i] != ref[i + k])
+			return FALSE;
+		if (ref[i + k] != ref[i])
+			differs = TRUE;
+	}
+
+	return differs;
+}
+
+/*
+ * Does the destination repeat itself k bytes back over the window, where
+ * the expected data does not (a constant pattern always repeats)?
+ */
+static BOOL WindowRepeats(const UBYTE *expected, const UBYTE *actual, ULONG k, ULONG len)
+{
+	ULONG i;
+	BOOL differs = FALSE;
+
+	for (i = 0; i < len; i++) {
+		if (actual[i] != actual[i - k])
+			return FALSE;
+		if (expected[i] != expected[i - k])
+			differs = TRUE;
+	}
+
+	return differs;
+}
+
+/*
+ * Look for shifted or repeated data at the first error
+ * f is the index of the first bad byte within this piece of len bytes
+ */
+static void CheckShift(struct ErrorMap *map, const UBYTE *expected, const UBYTE *actual,
+                       ULONG f, ULONG len)
+{
+	ULONG win = len - f;
+	LONG k;
+
+	if (win > ERRMAP_SHIFT_WINDOW)
+		win = ERRMAP_SHIFT_WINDOW;
+	if (win < 4)
+		return;
+
+	for (k = 1; k <= ERRMAP_MAX_SHIFT; k++) {
+		// Late: expected data from k bytes earlier (k bytes written twice)
+		if ((ULONG)k <= f && WindowMatches(actual + f, expected + f, -k, win)) {
+			map->shift = k;
+			return;
+		}
+		// Early: expected data from k bytes later (k bytes lost)
+		if (f + win + k <= len && WindowMatches(actual + f, expected + f, k, win)) {
+			map->shift = -k;
+			return;
+		}
+	}
+
+	// A block of the destination repeated
+	for (k = 4; k <= ERRMAP_MAX_SHIFT; k *= 2) {
+		if ((ULONG)k <= f && WindowRepeats(expected + f, actual + f, k, win)) {
+			map->repeat = k;
+			return;
+		}
+	}
+}
+
+/*
+ * Add 'len' bytes at 'offset' of the range to the map
+ * Longwords of the destination are compared whole; only bad ones are
+ * looked at byte by byte
+ */
+void ErrorMapAdd(struct ErrorMap *map, ULONG offset, const UBYTE *expected,
+                 const UBYTE *actual, ULONG len)
+{
+	ULONG i = 0, j, x;
+	BOOL had_error = (map->first_bad != ERRMAP_NONE);
+
+	if (offset + len > map->size)
+		return;
+
+	// Head bytes up to a longword-aligned destination
+	while (i < len && ((ULONG)(actual + i) & 3)) {
+		if (expected[i] != actual[i])
+			AddBadByte(map, offset + i, (ULONG)(actual + i), expected[i], actual[i]);
+		i++;
+	}
+
+	for (; i + 4 <= len; i += 4) {
+		x = *(const ULONG *)(expected + i) ^ *(const ULONG *)(actual + i);
+		if (!x)
+			continue;
+
+		map->bad_longs++;
+		if (!(x & (x - 1)))
+			map->single_bit_longs++;
+		for (j = 0; j < 4; j++) {
+			if (expected[i + j] != actual[i + j])
+				AddBadByte(map, offset + i + j, (ULONG)(actual + i + j),
+				           expected[i + j], actual[i + j]);
+		}
+	}
+
+	for (; i < len; i++) {
+		if (expected[i] != actual[i])
+			AddBadByte(map, offset + i, (ULONG)(actual + i), expected[i], actual[i]);
+	}
+
+	if (!had_error && map->first_bad != ERRMAP_NONE)
+		CheckShift(map, expected, actual, map->first_bad - offset, len);
+}
+
+/*
+ * Print the analysis
+ */
+void PrintErrorMap(struct ErrorMap *map)
+{
+	char row[ERRMAP_BUCKETS + 1];
+	ULONG i, lines = 0;
+
+	if (map->first_bad == ERRMAP_NONE) {
+		dbgprintf("    Error map: no mismatches in %ld bytes\n", map->size);
+		return;
+	}
+
+	dbgprintf("    Error map: %ld bad bytes in %ld longwords (%ld single-bit), "
+	          "0x%lx-0x%lx of %ld\n",
+	          map->bad_bytes, map->bad_longs, map->single_bit_longs,
+	          map->first_bad, map->last_bad, map->size);
+
+	// '.' clean, 'o' up to 1/16 of the bucket bad, 'X' more
+	for (i = 0; i < ERRMAP_BUCKETS; i++) {
+		if (!map->buckets[i])
+			row[i] = '.';
+		else if (map->buckets[i] * 16 <= map->bucket_bytes)
+			row[i] = 'o';
+		else
+			row[i] = 'X';
+	}
+	row[ERRMAP_BUCKETS] = '\0';
+	dbgprintf("    Where:     [%s] %ld bytes/char\n", row, map->bucket_bytes);
+
+	dbgprintf("    Line pos:  ");
+	for (i = 0; i < 16; i++)
+		dbgprintf("%ld%s", map->line_pos[i], (i < 15) ? " " : "\n");
+
+	dbgprintf("    Flips 0->1/1->0:");
+	for (i = 32; i-- > 0; ) {
+		if (!map->set_flips[i] && !map->clear_flips[i])
+			continue;
+		if (lines && (lines % 8) == 0)
+			dbgprintf("\n                   ");
+		dbgprintf(" D%ld:%ld/%ld", i, map->set_flips[i], map->clear_flips[i]);
+		lines++;
+	}
+	dbgprintf("\n");
+
+	// One line that only ever flips one way in many bytes looks stuck
+	for (i = 0; i < 32; i++) {
+		if (map->set_flips[i] >= ERRMAP_STUCK_MIN && !map->clear_flips[i])
+			dbgprintf("    D%ld only reads 1 where 0 was written - stuck high?\n", i);
+		else if (map->clear_flips[i] >= ERRMAP_STUCK_MIN && !map->set_flips[i])
+			dbgprintf("    D%ld only reads 0 where 1 was written - stuck low?\n", i);
+	}
+
+	if (map->read_zero || map->read_ones)
+		dbgprintf("    Bad bytes reading 0x00: %ld, 0xFF: %ld\n",
+		          map->read_zero, map->read_ones);
+
+	if (map->shift > 0)
+		dbgprintf("    At 0x%lx: data is %ld bytes late (repeated)\n",
+		          map->first_bad, map->shift);
+	else if (map->shift < 0)
+		dbgprintf("    At 0x%lx: data is %ld bytes early (dropped)\n",
+		          map->first_bad, -map->shift);
+	else if (map->repeat)
+		dbgprintf("    At 0x%lx: destination repeats the previous %ld bytes\n",
+		          map->first_bad, map->repeat);
+	else
+		dbgprintf("    At 0x%lx: no shift or repeat within %ld bytes\n",
+		          map->first_bad, (ULONG)ERRMAP_MAX_SHIFT);
+}
+
+/*
+ * Map and print the whole of one range
+ * Returns the number of bad bytes
+ */
+ULONG AnalyzeErrors(const UBYTE *expected, const UBYTE *actual, ULONG size)
+{
+	struct ErrorMap map;
+
+	ErrorMapInit(&map, size);
+	ErrorMapAdd(&map, 0, expected, actual, size);
+	PrintErrorMap(&map);
+
+	return map.bad_bytes;
+}
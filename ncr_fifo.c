@@ -0,0 +1,395 @@
+/*
+ * NCR 53C710 DMA Test Tool - DMA FIFO occupancy timeline
+ *
+ * Throughput figures say how fast a move went, not which side held it
+ * up. This mode starts one FIFO_MOVE_SIZE move per region pair and, while
+ * it runs, polls DSP, DBC, DNAD, DFIFO and CTEST1 as fast as the CPU can.
+ * DNAD tells whether the chip is reading the source or writing the
+ * destination, DFIFO minus DBC gives the bytes held in the FIFO and the
+ * CTEST1 empty flags confirm a drained FIFO. The samples are binned into a
+ * timeline: a chip that spends most of its time reading, FIFO waiting to
+ * fill, is held up by the source side; one that spends it writing, FIFO
+ * backed up, by the destination side. Rows where the rate drops mark
+ * stalls (refresh, a move boundary, the CPU on the bus).
+ *
+ * Only registers without read side effects are polled - DSTAT, SSTAT0
+ * and CTEST2 are left to the interrupt handler. The polling itself puts
+ * the CPU on the bus, so an unsampled run is timed first for comparison.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/memory.h>
+#include <proto/exec.h>
+
+#define FIFO_MAGIC        0xF1F0C0DE
+#define DFIFO_BO_MASK     0x7F		// Byte offset counter
+#define CTEST1_FMT        0xF0		// All byte lanes empty
+#define DBC_MASK          0x00FFFFFF	// DCMD shares the longword
+
+/* Sample phases, from where DNAD points */
+#define PHASE_READ        0
+#define PHASE_WRITE       1
+#define PHASE_OTHER       2		// Instruction fetch
+
+/* One register snapshot */
+struct FifoSample {
+	ULONG dsp;
+	ULONG dbc;
+	ULONG dnad;
+	UBYTE dfifo;
+	UBYTE ctest1;
+	UWORD pad;
+};
+
+/* One timeline row */
+struct FifoBin {
+	ULONG samples;
+	ULONG bytes;		// Progress at the last sample
+	ULONG fill_sum;
+	ULONG empty;		// CTEST1 says every lane empty
+	ULONG full;		// Within a longword of FIFO_DEPTH
+	ULONG reads;
+	ULONG writes;
+	BOOL boundary;		// A new move started in this row
+};
+
+static struct FifoSample *g_samples;
+static struct EClockVal g_stamps[FIFO_MAX_SAMPLES / FIFO_STAMP_EVERY + 1];
+static ULONG g_stamp_us[FIFO_MAX_SAMPLES / FIFO_STAMP_EVERY + 1];
+
+/*
+ * Bytes in the DMA FIFO: byte offset counter minus the low DBC bits
+ */
+static ULONG FifoBytes(const struct FifoSample *s)
+{
+	return ((ULONG)s->dfifo - s->dbc) & DFIFO_BO_MASK;
+}
+
+/*
+ * Length of the memory move at inst
+ */
+static ULONG MoveLen(const struct memmove_inst *inst)
+{
+	return ((ULONG)inst->len[0] << 16) | ((ULONG)inst->len[1] << 8) | inst->len[2];
+}
+
+/*
+ * Index of the move a sample belongs to - DSP already points past it
+ */
+static ULONG MoveIndex(const struct FifoSample *s, ULONG script_phys, ULONG nmoves)
+{
+	ULONG i = (s->dsp - script_phys) / sizeof(struct memmove_inst);
+
+	if (s->dsp <= script_phys || i == 0)
+		return 0;
+
+	return (i > nmoves) ? nmoves - 1 : i - 1;
+}
+
+/*
+ * Bytes of the transfer the chip has counted off at a sample
+ */
+static ULONG SampleProgress(const struct FifoSample *s, const struct memmove_inst *moves,
+                            ULONG script_phys, ULONG nmoves)
+{
+	ULONG k = MoveIndex(s, script_phys, nmoves);
+	ULONG done = 0, left, i;
+
+	for (i = 0; i < k; i++)
+		done += MoveLen(&moves[i]);
+
+	left = s->dbc & DBC_MASK;
+	if (left > MoveLen(&moves[k]))
+		left = MoveLen(&moves[k]);
+
+	return done + MoveLen(&moves[k]) - left;
+}
+
+/*
+ * Is DNAD inside the source or destination of its move?
+ */
+static ULONG SamplePhase(const struct FifoSample *s, const struct memmove_inst *moves,
+                         ULONG script_phys, ULONG nmoves)
+{
+	const struct memmove_inst *m = &moves[MoveIndex(s, script_phys, nmoves)];
+	ULONG len = MoveLen(m);
+
+	if (s->dnad >= m->source && s->dnad <= m->source + len)
+		return PHASE_READ;
+	if (s->dnad >= m->dest && s->dnad <= m->dest + len)
+		return PHASE_WRITE;
+
+	return PHASE_OTHER;
+}
+
+/*
+ * Microseconds from the start to sample i, between the two stamps around it
+ */
+static ULONG SampleMicros(ULONG i, ULONG n)
+{
+	ULONG j = i / FIFO_STAMP_EVERY;
+	ULONG span = n - j * FIFO_STAMP_EVERY;
+
+	if (span > FIFO_STAMP_EVERY)
+		span = FIFO_STAMP_EVERY;
+
+	return g_stamp_us[j] +
+	       ((g_stamp_us[j + 1] - g_stamp_us[j]) * (i % FIFO_STAMP_EVERY)) / span;
+}
+
+/*
+ * Run the script at script_phys once while sampling the chip
+ * Returns the number of samples, 0 on failure; *covered is FALSE if the
+ * buffer filled before the move ended
+ */
+static ULONG SampleMove(volatile struct ncr710 *ncr, ULONG script_phys, BOOL *covered)
+{
+	struct FifoSample *s = g_samples;
+	ULONG n = 0, i;
+
+	StartScript(ncr, script_phys);
+	while (!ScriptFinished() && n < FIFO_MAX_SAMPLES) {
+		if ((n % FIFO_STAMP_EVERY) == 0)
+			ReadTimer(&g_stamps[n / FIFO_STAMP_EVERY]);
+		s->dsp = ncr->dsp;
+		s->dbc = ncr->dbc;
+		s->dnad = ncr->dnad;
+		s->dfifo = ncr->dfifo;
+		s->ctest1 = ncr->ctest1;
+		s++;
+		n++;
+	}
+	*covered = (n < FIFO_MAX_SAMPLES);
+	ReadTimer(&g_stamps[(n + FIFO_STAMP_EVERY - 1) / FIFO_STAMP_EVERY]);
+
+	if (FinishScript(ncr, FIFO_MAGIC, "FIFO timeline") != TEST_SUCCESS)
+		return 0;
+
+	for (i = 0; i <= (n + FIFO_STAMP_EVERY - 1) / FIFO_STAMP_EVERY; i++)
+		g_stamp_us[i] = ElapsedMicros(&g_stamps[0], &g_stamps[i]);
+
+	return n;
+}
+
+/*
+ * Bin the samples by time and print the timeline and its verdict
+ */
+static void PrintTimeline(ULONG n, ULONG total_us, const struct memmove_inst *moves,
+                          ULONG script_phys, ULONG nmoves)
+{
+	struct FifoBin bins[FIFO_BINS];
+	struct FifoBin all;
+	ULONG i, b, fill, prev = 0, rate, rates[FIFO_BINS], sorted[FIFO_BINS], median, k;
+	ULONG last_move = 0, progress = 0, bytes;
+	ULONG bin_us = total_us / FIFO_BINS;
+
+	if (!bin_us)
+		bin_us = 1;
+
+	memset(bins, 0, sizeof(bins));
+	memset(&all, 0, sizeof(all));
+
+	for (i = 0; i < n; i++) {
+		const struct FifoSample *s = &g_samples[i];
+		ULONG phase = SamplePhase(s, moves, script_phys, nmoves);
+
+		b = SampleMicros(i, n) / bin_us;
+		if (b >= FIFO_BINS)
+			b = FIFO_BINS - 1;
+
+		fill = FifoBytes(s);
+		k = MoveIndex(s, script_phys, nmoves);
+		if (k != last_move)
+			bins[b].boundary = TRUE;
+		last_move = k;
+
+		// DSP and DBC read while the next move is fetched can put the
+		// estimate at the end of the current move before it drops back.
+		// Real progress never decreases, so hold the highest seen.
+		bytes = SampleProgress(s, moves, script_phys, nmoves);
+		if (bytes < progress)
+			bytes = progress;
+		progress = bytes;
+
+		bins[b].samples++;
+		bins[b].bytes = bytes;
+		bins[b].fill_sum += fill;
+		if ((s->ctest1 & CTEST1_FMT) == CTEST1_FMT)
+			bins[b].empty++;
+		if (fill >= FIFO_DEPTH - 4)
+			bins[b].full++;
+		if (phase == PHASE_READ)
+			bins[b].reads++;
+		else if (phase == PHASE_WRITE)
+			bins[b].writes++;
+	}
+
+	// Rows without a sample carry the progress of the row before
+	for (b = 0; b < FIFO_BINS; b++) {
+		if (!bins[b].samples || bins[b].bytes < prev)
+			bins[b].bytes = prev;
+		rates[b] = CalcRate(bins[b].bytes - prev, bin_us);
+		prev = bins[b].bytes;
+
+		all.samples += bins[b].samples;
+		all.fill_sum += bins[b].fill_sum;
+		all.empty += bins[b].empty;
+		all.full += bins[b].full;
+		all.reads += bins[b].reads;
+		all.writes += bins[b].writes;
+	}
+
+	// Median row rate, the reference for stalls
+	memcpy(sorted, rates, sizeof(sorted));
+	for (i = 1; i < FIFO_BINS; i++) {
+		for (b = i; b > 0 && sorted[b - 1] > sorted[b]; b--) {
+			rate = sorted[b];
+			sorted[b] = sorted[b - 1];
+			sorted[b - 1] = rate;
+		}
+	}
+	median = sorted[FIFO_BINS / 2];
+
+	dbgprintf("      us |  bytes | MB/s   | fill | empty  full | read write\n");
+	for (b = 0; b < FIFO_BINS; b++) {
+		struct FifoBin *r = &bins[b];
+
+		if (!r->samples) {
+			dbgprintf("  %6ld |  %5ld |   -    |   -  |     -     - |   -     -\n",
+			          b * bin_us, r->bytes);
+			continue;
+		}
+
+		rate = rates[b];
+		dbgprintf("  %6ld |  %5ld | %2ld.%02ld  | %4ld | %4ld%% %4ld%% | %3ld%% %4ld%%%s%s\n",
+		          b * bin_us, r->bytes, rate / 100, rate % 100,
+		          r->fill_sum / r->samples,
+		          (r->empty * 100) / r->samples, (r->full * 100) / r->samples,
+		          (r->reads * 100) / r->samples, (r->writes * 100) / r->samples,
+		          (rate * 2 < median) ? "  <- stall" : "",
+		          r->boundary ? "  (new move)" : "");
+	}
+
+	if (!all.samples)
+		return;
+
+	// The chip alternates read and write bursts through the FIFO, so the
+	// side it spends longer on is the one holding the move up
+	dbgprintf("  %ld samples: reading %ld%%, writing %ld%%, FIFO empty %ld%%, full %ld%%, mean fill %ld bytes\n",
+	          all.samples, (all.reads * 100) / all.samples, (all.writes * 100) / all.samples,
+	          (all.empty * 100) / all.samples, (all.full * 100) / all.samples,
+	          all.fill_sum / all.samples);
+	if (all.reads * 10 > all.writes * 11)
+		dbgprintf("  Source side limits (FIFO waits for reads)\n");
+	else if (all.writes * 10 > all.reads * 11)
+		dbgprintf("  Destination side limits (FIFO backs up on writes)\n");
+	else
+		dbgprintf("  Source and destination sides balanced\n");
+}
+
+/*
+ * Sample one FIFO_MOVE_SIZE move between two test buffers
+ */
+static void FifoPair(volatile struct ncr710 *ncr, UBYTE *script, ULONG src_idx, ULONG dst_idx)
+{
+	struct DMASegment src_segs[MAX_DMA_SEGMENTS], dst_segs[MAX_DMA_SEGMENTS];
+	struct memmove_inst *moves = (struct memmove_inst *)script;
+	struct EClockVal t0, t1;
+	UBYTE *src = *g_test_buffers[src_idx].buf;
+	UBYTE *dst = *g_test_buffers[dst_idx].buf;
+	ULONG nsrc, ndst, nmoves, len, phys, n, plain_us, sampled_us;
+	BOOL covered;
+	LONG status;
+
+	dbgprintf("\n%s -> %s, %ld bytes\n", g_test_buffers[src_idx].name,
+	          g_test_buffers[dst_idx].name, (ULONG)FIFO_MOVE_SIZE);
+
+	FillPattern(src, FIFO_MOVE_SIZE, PATTERN_RANDOM);
+
+	nsrc = DMAMapRange(src, FIFO_MOVE_SIZE, DMA_DIR_READ, src_segs, MAX_DMA_SEGMENTS);
+	ndst = DMAMapRange(dst, FIFO_MOVE_SIZE, DMA_DIR_WRITE, dst_segs, MAX_DMA_SEGMENTS);
+	nmoves = (nsrc && ndst) ?
+	         EmitMemMoves(moves, 2 * MAX_DMA_SEGMENTS, src_segs, nsrc, dst_segs, ndst) : 0;
+	if (!nmoves) {
+		dbgprintf("  ERROR: Buffers too fragmented for one script\n");
+		goto done;
+	}
+	BuildIntInst((struct jump_inst *)&moves[nmoves], FIFO_MAGIC);
+	len = nmoves * sizeof(struct memmove_inst) + sizeof(struct jump_inst);
+
+	phys = DMAPhysAddr(script);
+	DMACachePre(script, len, DMA_DIR_READ);
+
+	// Unsampled reference first - the polling loop shares the bus
+	ReadTimer(&t0);
+	status = ExecuteScript(ncr, phys, FIFO_MAGIC, "FIFO reference");
+	ReadTimer(&t1);
+	plain_us = ElapsedMicros(&t0, &t1);
+
+	n = (status == TEST_SUCCESS) ? SampleMove(ncr, phys, &covered) : 0;
+	DMACachePost(script, len, DMA_DIR_READ);
+	if (!n) {
+		dbgprintf("  ERROR: Transfer failed\n");
+		goto done;
+	}
+	sampled_us = SampleMicros(n - 1, n);
+
+	dbgprintf("  %ld move%s; unsampled %ld us (%ld MB/s), sampled %ld us, one sample per %ld ns\n",
+	          nmoves, (nmoves == 1) ? "" : "s", plain_us,
+	          CalcRate(FIFO_MOVE_SIZE, plain_us) / 100, sampled_us,
+	          (sampled_us * 1000) / n);
+	if (!covered)
+		dbgprintf("  WARNING: Sample buffer full - timeline ends before the move\n");
+
+	PrintTimeline(n, sampled_us, moves, phys, nmoves);
+
+done:
+	DMACachePost(src, FIFO_MOVE_SIZE, DMA_DIR_READ);
+	DMACachePost(dst, FIFO_MOVE_SIZE, DMA_DIR_WRITE);
+	dbgflush();
+}
+
+/*
+ * FIFO timeline of every region pair
+ */
+void TestFifoTimeline(volatile struct ncr710 *ncr)
+{
+	UBYTE *script;
+	int s, d;
+
+	dbgprintf("\n=== DMA FIFO Timeline ===\n");
+	dbgprintf("One %ld KB move per region pair, DSP/DBC/DNAD/DFIFO/CTEST1 polled\n",
+	          (ULONG)FIFO_MOVE_SIZE / 1024);
+	dbgprintf("while it runs; fill = DFIFO - DBC, empty = CTEST1 lanes all empty,\n");
+	dbgprintf("read/write = DNAD in the source/destination\n");
+
+	script = AllocScriptMem(FIFO_SCRIPT_SIZE);
+	g_samples = AllocMem(FIFO_MAX_SAMPLES * sizeof(struct FifoSample), MEMF_FAST);
+	if (!script || !g_samples) {
+		dbgprintf("ERROR: Could not allocate FIFO timeline buffers\n");
+		goto cleanup;
+	}
+
+	SeedRandom(0xF1F0F1F0);
+
+	// buf1 of each region as source, buf2 of each as destination
+	for (s = 0; s + 1 < g_num_test_buffers; s += 2) {
+		for (d = 0; d + 1 < g_num_test_buffers; d += 2) {
+			if (!*g_test_buffers[s].buf || !*g_test_buffers[d + 1].buf)
+				continue;
+			FifoPair(ncr, script, s, d + 1);
+		}
+	}
+
+cleanup:
+	if (g_samples)
+		FreeMem(g_samples, FIFO_MAX_SAMPLES * sizeof(struct FifoSample));
+	g_samples = NULL;
+	if (script)
+		FreeScriptMem(script, FIFO_SCRIPT_SIZE);
+
+	dbgprintf("\n=== FIFO Timeline Complete ===\n\n");
+	dbgflush();
+}
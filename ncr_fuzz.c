@@ -0,0 +1,430 @@
+/*
+ * NCR 53C710 DMA Test Tool - Seeded scatter-gather fuzzer
+ *
+ * The fixed gather moves 4KB segments from at most MAX_SG_SEGMENTS sources
+ * through the small g_scripts_buf. Real SCSI page lists are long chains of
+ * odd-sized, oddly aligned pieces. Each fuzz case derives a chain of up to
+ * FUZZ_MAX_SEGMENTS segments (random length, alignment and source region)
+ * from a single seed and gathers it into a guarded destination.
+ *
+ * The script buffer is sized for the chain and may span several pages; the
+ * pages need not be physically adjacent, so the last instruction on each
+ * page is a JUMP to the physical address of the next. A failing case is
+ * logged with its seed; "fuzz 1 <seed>" replays exactly that chain.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/memory.h>
+#include <dos/dos.h>
+#include <proto/exec.h>
+
+#define FUZZ_FILL_SEED  0x5EED0710   // Source contents - fixed for replay
+#define FUZZ_MAGIC      0xF0220710   // DSPS value of the final INT
+#define FUZZ_CAPACITY   (FUZZ_DEST_SIZE - 2 * MATRIX_GUARD - MATRIX_MAX_ALIGN)
+
+/* Worst case moves per segment: source and destination each cross a page */
+#define FUZZ_MOVES_PER_SEG 3
+
+struct FuzzSegment {
+	UBYTE *src;
+	ULONG len;
+	ULONG region;	// Index into g_test_buffers
+};
+
+/* Script being written - pages are chained with JUMPs */
+struct ScriptWriter {
+	UBYTE *base;
+	ULONG size;
+	ULONG pos;
+	struct DMASegment segs[MAX_DMA_SEGMENTS];	// Physical map of base
+	ULONG nsegs;
+};
+
+static struct FuzzSegment g_fuzz_segs[FUZZ_MAX_SEGMENTS];
+static UBYTE *g_fuzz_dest = NULL;
+
+/*
+ * Chain generator - LCG, so a chain depends only on its seed
+ */
+static ULONG FuzzRandom(ULONG *state)
+{
+	*state = *state * 1664525 + 1013904223;
+	return *state >> 8;
+}
+
+/*
+ * Seed of the next case (xorshift32 - never returns 0 for a non-zero seed)
+ */
+static ULONG NextCaseSeed(ULONG seed)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+/*
+ * Build the segment list for one seed
+ * Returns number of segments; *dst_align and *total describe the gather
+ */
+static ULONG GenerateChain(ULONG seed, UBYTE **regions, ULONG *region_idx,
+                           ULONG num_regions, ULONG *dst_align, ULONG *total)
+{
+	ULONG state = seed;
+	ULONG n, i, len, r;
+
+	n = 1 + FuzzRandom(&state) % FUZZ_MAX_SEGMENTS;
+	*dst_align = FuzzRandom(&state) % MATRIX_MAX_ALIGN;
+	*total = 0;
+
+	for (i = 0; i < n; i++) {
+		// Mostly short pieces, some page sized, some longword multiples
+		switch (FuzzRandom(&state) & 3) {
+		case 0:
+			len = 1 + FuzzRandom(&state) % 16;
+			break;
+		case 1:
+			len = 1 + FuzzRandom(&state) % 256;
+			break;
+		case 2:
+			len = 1 + FuzzRandom(&state) % FUZZ_MAX_SEG_LEN;
+			break;
+		default:
+			len = 4 * (1 + FuzzRandom(&state) % (FUZZ_MAX_SEG_LEN / 4));
+			break;
+		}
+
+		if (*total + len > FUZZ_CAPACITY)
+			break;
+
+		r = FuzzRandom(&state) % num_regions;
+		g_fuzz_segs[i].region = region_idx[r];
+		g_fuzz_segs[i].len = len;
+		g_fuzz_segs[i].src = regions[r] +
+		                     FuzzRandom(&state) % (TEST_BUFFER_SIZE - len + 1);
+		*total += len;
+	}
+
+	return i;
+}
+
+/*
+ * Physical address of an offset into the script buffer
+ */
+static ULONG ScriptPhys(struct ScriptWriter *w, ULONG offset)
+{
+	ULONG i;
+
+	for (i = 0; i < w->nsegs; i++) {
+		if (offset < w->segs[i].len)
+			return w->segs[i].phys + offset;
+		offset -= w->segs[i].len;
+	}
+
+	return 0;
+}
+
+/*
+ * Append one instruction, chaining to the next page when this one would
+ * not leave room for the JUMP
+ * Returns FALSE if the buffer is full
+ */
+static BOOL WriteInst(struct ScriptWriter *w, const void *inst, ULONG len)
+{
+	ULONG page_left = DMA_PAGE_SIZE - (((ULONG)w->base + w->pos) & (DMA_PAGE_SIZE - 1));
+
+	if (len + sizeof(struct jump_inst) > page_left) {
+		ULONG next = w->pos + page_left;
+
+		if (next + len > w->size)
+			return FALSE;
+
+		BuildJumpInst((struct jump_inst *)(w->base + w->pos), ScriptPhys(w, next));
+		w->pos = next;
+	}
+
+	if (w->pos + len > w->size)
+		return FALSE;
+
+	memcpy(w->base + w->pos, inst, len);
+	w->pos += len;
+
+	return TRUE;
+}
+
+/*
+ * Verify guards and gathered data
+ * Returns TEST_SUCCESS or TEST_VERIFY_ERROR with the failing segment/offset
+ */
+static LONG VerifyChain(UBYTE *dest, ULONG n, ULONG total, UBYTE fill,
+                        LONG *bad_seg, LONG *bad_offset, LONG *bad_dest)
+{
+	ULONG i, j, offset = 0;
+	LONG g;
+
+	for (g = -MATRIX_GUARD; g < 0; g++) {
+		if (dest[g] != fill) {
+			*bad_seg = -1;
+			*bad_offset = g;
+			*bad_dest = g;
+			return TEST_VERIFY_ERROR;
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < g_fuzz_segs[i].len; j++) {
+			if (dest[offset + j] != g_fuzz_segs[i].src[j]) {
+				*bad_seg = i;
+				*bad_offset = j;
+				*bad_dest = offset + j;
+				return TEST_VERIFY_ERROR;
+			}
+		}
+		offset += g_fuzz_segs[i].len;
+	}
+
+	for (g = 0; g < MATRIX_GUARD; g++) {
+		if (dest[total + g] != fill) {
+			*bad_seg = -1;
+			*bad_offset = total + g;
+			*bad_dest = total + g;
+			return TEST_VERIFY_ERROR;
+		}
+	}
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Run one fuzz case
+ * Returns TEST_SUCCESS or an error code; *moves and *micros describe the run
+ */
+static LONG RunFuzzCase(volatile struct ncr710 *ncr, ULONG seed,
+                        UBYTE **regions, ULONG *region_idx, ULONG num_regions,
+                        ULONG *nsegs_out, ULONG *total_out, ULONG *moves_out,
+                        ULONG *micros)
+{
+	struct DMASegment src_segs[MAX_DMA_SEGMENTS], dst_segs[MAX_DMA_SEGMENTS];
+	struct memmove_inst tmp[2 * MAX_DMA_SEGMENTS];
+	struct jump_inst done;
+	struct ScriptWriter w;
+	struct EClockVal t0, t1;
+	ULONG n, i, k, nsrc, ndst, emitted, dst_align, total;
+	ULONG offset = 0, moves = 0, window;
+	UBYTE *dest;
+	UBYTE fill = (UBYTE)(seed ^ (seed >> 8) ^ 0xA5);
+	LONG status = TEST_SUCCESS;
+	LONG bad_seg, bad_offset, bad_dest;
+
+	n = GenerateChain(seed, regions, region_idx, num_regions, &dst_align, &total);
+	dest = g_fuzz_dest + MATRIX_GUARD + dst_align;
+
+	*nsegs_out = n;
+	*total_out = total;
+	*moves_out = 0;
+	*micros = 0;
+
+	// Script buffer sized for this chain, plus a JUMP and slack per page
+	w.size = n * FUZZ_MOVES_PER_SEG * sizeof(struct memmove_inst) + sizeof(struct jump_inst);
+	w.size += (w.size / (DMA_PAGE_SIZE / 2) + 2) *
+	          (sizeof(struct memmove_inst) + sizeof(struct jump_inst));
+	w.pos = 0;
+	w.base = AllocMem(w.size, MEMF_FAST);
+	if (!w.base) {
+		dbgprintf("ERROR: Could not allocate %ld byte fuzz script\n", w.size);
+		return TEST_FAILED;
+	}
+
+	w.nsegs = DMATranslateRange(w.base, w.size, w.segs, MAX_DMA_SEGMENTS);
+	if (!w.nsegs) {
+		dbgprintf("ERROR: Fuzz script spans too many physical segments\n");
+		FreeMem(w.base, w.size);
+		return TEST_FAILED;
+	}
+
+	// Destination window including guards, pushed to RAM so an overrun
+	// is not hidden by the cache
+	window = MATRIX_GUARD + dst_align + total + MATRIX_GUARD;
+	memset(g_fuzz_dest, fill, window);
+	DMACacheClear();
+	DMACachePre(g_fuzz_dest, window, DMA_DIR_WRITE);
+
+	// Map every piece and emit its moves
+	for (i = 0; i < n; i++) {
+		nsrc = DMAMapRange(g_fuzz_segs[i].src, g_fuzz_segs[i].len, DMA_DIR_READ,
+		                   src_segs, MAX_DMA_SEGMENTS);
+		ndst = DMAMapRange(dest + offset, g_fuzz_segs[i].len, DMA_DIR_WRITE,
+		                   dst_segs, MAX_DMA_SEGMENTS);
+		offset += g_fuzz_segs[i].len;
+
+		if (status != TEST_SUCCESS)
+			continue;
+
+		emitted = (nsrc && ndst) ?
+		          EmitMemMoves(tmp, 2 * MAX_DMA_SEGMENTS, src_segs, nsrc, dst_segs, ndst) : 0;
+		if (!emitted)
+			status = TEST_DMA_ERROR;
+
+		for (k = 0; k < emitted && status == TEST_SUCCESS; k++) {
+			if (!WriteInst(&w, &tmp[k], sizeof(struct memmove_inst)))
+				status = TEST_DMA_ERROR;
+		}
+		moves += emitted;
+	}
+
+	BuildIntInst(&done, FUZZ_MAGIC);
+	if (status == TEST_SUCCESS && !WriteInst(&w, &done, sizeof(done)))
+		status = TEST_DMA_ERROR;
+
+	if (status != TEST_SUCCESS) {
+		dbgprintf("ERROR: Could not build fuzz script (%ld segments)\n", n);
+	} else {
+		DMACachePre(w.base, w.pos, DMA_DIR_READ);
+
+		ReadTimer(&t0);
+		status = ExecuteScript(ncr, w.segs[0].phys, FUZZ_MAGIC, "Fuzz DMA");
+		ReadTimer(&t1);
+		*micros = ElapsedMicros(&t0, &t1);
+
+		DMACachePost(w.base, w.pos, DMA_DIR_READ);
+	}
+
+	// Finish every mapped range
+	DMACachePost(g_fuzz_dest, window, DMA_DIR_WRITE);
+	for (i = 0; i < n; i++)
+		DMACachePost(g_fuzz_segs[i].src, g_fuzz_segs[i].len, DMA_DIR_READ);
+	DMACacheClear();
+
+	FreeMem(w.base, w.size);
+	*moves_out = moves;
+
+	if (status == TEST_SUCCESS &&
+	    VerifyChain(dest, n, total, fill, &bad_seg, &bad_offset, &bad_dest) != TEST_SUCCESS) {
+		status = TEST_VERIFY_ERROR;
+		if (bad_seg < 0) {
+			dbgprintf("  Seed 0x%08lx: guard byte at dest%+ld overwritten (0x%02lx)\n",
+			          seed, bad_offset, (ULONG)dest[bad_offset]);
+		} else {
+			dbgprintf("  Seed 0x%08lx: segment %ld (%s 0x%08lx, %ld bytes) "
+			          "mismatch at offset %ld: expected 0x%02lx got 0x%02lx\n",
+			          seed, bad_seg,
+			          g_test_buffers[g_fuzz_segs[bad_seg].region].name,
+			          (ULONG)g_fuzz_segs[bad_seg].src, g_fuzz_segs[bad_seg].len,
+			          bad_offset, (ULONG)g_fuzz_segs[bad_seg].src[bad_offset],
+			          (ULONG)dest[bad_dest]);
+		}
+	}
+
+	return status;
+}
+
+/*
+ * Run 'cases' fuzz chains starting from 'seed' (0 = seed from the EClock)
+ */
+void FuzzScatterGather(volatile struct ncr710 *ncr, ULONG cases, ULONG seed)
+{
+	UBYTE *regions[MAX_SG_SEGMENTS];
+	ULONG region_idx[MAX_SG_SEGMENTS];
+	ULONG failed_seeds[FUZZ_MAX_FAILED];
+	ULONG num_regions = 0, failed = 0;
+	ULONG c, nsegs, total, moves, micros;
+	ULONG max_segs = 0, total_moves = 0;
+	unsigned long long bytes = 0, dma_micros = 0;
+	struct EClockVal ev;
+	LONG status;
+	int idx;
+
+	for (idx = 0; idx < g_num_test_buffers && num_regions < MAX_SG_SEGMENTS; idx++) {
+		if (*g_test_buffers[idx].buf) {
+			regions[num_regions] = *g_test_buffers[idx].buf;
+			region_idx[num_regions] = idx;
+			num_regions++;
+		}
+	}
+
+	if (num_regions == 0) {
+		dbgprintf("ERROR: No test buffers available for fuzzing\n");
+		return;
+	}
+
+	g_fuzz_dest = AllocMem(FUZZ_DEST_SIZE, MEMF_FAST);
+	if (!g_fuzz_dest) {
+		dbgprintf("ERROR: Could not allocate fuzz destination buffer\n");
+		return;
+	}
+
+	if (!seed) {
+		ReadTimer(&ev);
+		seed = ev.ev_lo ^ ev.ev_hi;
+		if (!seed)
+			seed = FUZZ_FILL_SEED;
+	}
+
+	dbgprintf("\n=== Scatter-Gather Fuzzer ===\n");
+	dbgprintf("%ld cases from seed 0x%08lx, up to %ld segments of 1-%ld bytes "
+	          "from %ld buffers\n",
+	          cases, seed, (ULONG)FUZZ_MAX_SEGMENTS, (ULONG)FUZZ_MAX_SEG_LEN, num_regions);
+
+	// Source contents are fixed so any case can be replayed on its own
+	SeedRandom(FUZZ_FILL_SEED);
+	for (c = 0; c < num_regions; c++)
+		FillPattern(regions[c], TEST_BUFFER_SIZE, PATTERN_RANDOM);
+	dbgflush();
+
+	for (c = 0; c < cases; c++) {
+		if (SetSignal(0, SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C) {
+			dbgprintf("\nFuzzer stopped by user (Ctrl-C)\n");
+			break;
+		}
+
+		status = RunFuzzCase(ncr, seed, regions, region_idx, num_regions,
+		                     &nsegs, &total, &moves, &micros);
+		if (status == TEST_ABORTED)
+			break;
+
+		if (status != TEST_SUCCESS) {
+			dbgprintf("  FAILED seed 0x%08lx: %ld segments, %ld bytes, %ld moves, status %ld\n",
+			          seed, nsegs, total, moves, status);
+			dbgprintf("    replay: ncr_dmatest fuzz 1 0x%08lx\n", seed);
+			if (failed < FUZZ_MAX_FAILED)
+				failed_seeds[failed] = seed;
+			failed++;
+		} else {
+			bytes += total;
+			dma_micros += micros;
+		}
+
+		total_moves += moves;
+		if (nsegs > max_segs)
+			max_segs = nsegs;
+
+		if (((c + 1) % 100) == 0) {
+			dbgprintf("  %ld cases, %ld failed\n", c + 1, failed);
+			dbgflush();
+		}
+
+		seed = NextCaseSeed(seed);
+	}
+
+	dbgprintf("\n=== Fuzzer %s: %ld of %ld cases failed ===\n",
+	          failed ? "FAILED" : "PASSED", failed, c);
+	dbgprintf("  Longest chain %ld segments, %ld memory moves total, "
+	          "%ld KB gathered at %ld.%02ld MB/s\n",
+	          max_segs, total_moves, (ULONG)(bytes / 1024),
+	          (ULONG)(dma_micros ? (bytes * 100ULL) / dma_micros : 0) / 100,
+	          (ULONG)(dma_micros ? (bytes * 100ULL) / dma_micros : 0) % 100);
+
+	if (failed) {
+		dbgprintf("  Failing seeds:");
+		for (c = 0; c < failed && c < FUZZ_MAX_FAILED; c++)
+			dbgprintf(" 0x%08lx", failed_seeds[c]);
+		dbgprintf("%s\n", (failed > FUZZ_MAX_FAILED) ? " ..." : "");
+	}
+	dbgprintf("\n");
+	dbgflush();
+
+	FreeMem(g_fuzz_dest, FUZZ_DEST_SIZE);
+	g_fuzz_dest = NULL;
+}
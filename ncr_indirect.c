@@ -0,0 +1,469 @@
+/*
+ * NCR 53C710 DMA Test Tool - Table-indirect scatter/gather
+ *
+ * The gather in ncr_dmatest.c writes every address into the script itself,
+ * so the script is rebuilt for each transfer. A production driver instead
+ * keeps one fixed script and hands it a descriptor table through DSA.
+ *
+ * The 710 has no table-indirect memory move (and no LOAD/STORE), so the
+ * fixed script uses memory moves on the chip's own registers: it copies
+ * DSA into the source field of a fetch move, fetches the current 16 byte
+ * descriptor over its own transfer slot, runs it, then copies the link
+ * word back into DSA. The last descriptor holds an INT. The 710 does not
+ * prefetch SCRIPTS, so the patched instructions are always re-read.
+ *
+ * The same descriptor path runs a gather, a scatter and a many-to-many
+ * copy with uneven split points, and each is compared with the inline
+ * address gather.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <exec/memory.h>
+#include <proto/exec.h>
+
+#define INDIRECT_MAGIC      0x7AB1E000   // Final descriptor INT
+#define INDIRECT_UNPATCHED  0x7AB1EBAD   // Transfer slot was never fetched
+#define INDIRECT_PROBE      0x12345678   // DSA value for the register probe
+#define INDIRECT_SKEW       509          // Uneven split for many-to-many
+#define INDIRECT_DST_SKEW   1021
+
+/* One descriptor - the fetch copies all 16 bytes over link + xfer */
+struct SGDescriptor {
+	ULONG next;			// Physical address of the next descriptor
+	struct memmove_inst move;	// Transfer, or INT in the last one
+};
+
+#define INDIRECT_MAX_DESC   (DMA_PAGE_SIZE / sizeof(struct SGDescriptor))
+
+/* Fixed descriptor-walking script - layout must stay contiguous */
+struct IndirectScript {
+	struct memmove_inst load;	// DSA -> fetch.source
+	struct memmove_inst fetch;	// descriptor -> link + xfer
+	struct jump_inst skip;		// over the link word
+	ULONG link;
+	struct memmove_inst xfer;	// patched transfer
+	struct memmove_inst advance;	// link -> DSA
+	struct jump_inst loop;
+};
+
+/* One virtual piece of a scatter/gather list */
+struct SGPiece {
+	UBYTE *addr;
+	ULONG len;
+};
+
+static struct IndirectScript *g_ind_script = NULL;
+static ULONG g_ind_script_phys = 0;
+static struct SGDescriptor *g_ind_table = NULL;
+static ULONG g_ind_table_phys = 0;
+
+/*
+ * Bus addresses of DSA as the chip itself sees it (reads at the register,
+ * long writes through the write window like the CPU)
+ */
+static ULONG DSAReadAddr(volatile struct ncr710 *ncr)
+{
+	return (ULONG)ncr + offsetof(struct ncr710, dsa);
+}
+
+static ULONG DSAWriteAddr(volatile struct ncr710 *ncr)
+{
+	return (ULONG)ncr + NCR_WRITE_OFFSET + offsetof(struct ncr710, dsa);
+}
+
+/*
+ * Build the fixed script once (script and table stay in place for the run)
+ */
+static void BuildIndirectScript(volatile struct ncr710 *ncr)
+{
+	struct IndirectScript *s = g_ind_script;
+	ULONG phys = g_ind_script_phys;
+
+	BuildMemMove(&s->load, DSAReadAddr(ncr),
+	             phys + offsetof(struct IndirectScript, fetch) +
+	             offsetof(struct memmove_inst, source), 4);
+	BuildMemMove(&s->fetch, 0, phys + offsetof(struct IndirectScript, link),
+	             sizeof(struct SGDescriptor));
+	BuildJumpInst(&s->skip, phys + offsetof(struct IndirectScript, xfer));
+	s->link = 0;
+	BuildIntInst((struct jump_inst *)&s->xfer, INDIRECT_UNPATCHED);
+	BuildMemMove(&s->advance, phys + offsetof(struct IndirectScript, link),
+	             DSAWriteAddr(ncr), 4);
+	BuildJumpInst(&s->loop, phys);
+}
+
+/*
+ * Check that memory moves can read and write DSA - the descriptor walk
+ * depends on it
+ * Returns TEST_SUCCESS or an error code
+ */
+static LONG ProbeDSAAccess(volatile struct ncr710 *ncr)
+{
+	struct memmove_inst *moves = (struct memmove_inst *)g_ind_table;
+	ULONG *words = (ULONG *)&moves[3];
+	ULONG phys_words = g_ind_table_phys + 3 * sizeof(struct memmove_inst);
+	ULONG got;
+	LONG status;
+
+	words[0] = 0;
+	words[1] = ~INDIRECT_PROBE;
+
+	BuildMemMove(&moves[0], DSAReadAddr(ncr), phys_words, 4);
+	BuildMemMove(&moves[1], phys_words + 4, DSAWriteAddr(ncr), 4);
+	BuildIntInst((struct jump_inst *)&moves[2], INDIRECT_MAGIC);
+
+	WRITE_LONG(ncr, dsa, INDIRECT_PROBE);
+
+	DMACachePre(g_ind_table, DMA_PAGE_SIZE, DMA_DIR_BOTH);
+	status = ExecuteScript(ncr, g_ind_table_phys, INDIRECT_MAGIC, "DSA probe");
+	DMACachePost(g_ind_table, DMA_PAGE_SIZE, DMA_DIR_BOTH);
+
+	if (status != TEST_SUCCESS)
+		return status;
+
+	got = ncr->dsa;
+	if (words[0] != INDIRECT_PROBE || got != ~INDIRECT_PROBE) {
+		dbgprintf("ERROR: Memory move cannot reach DSA "
+		          "(read 0x%08lx, expected 0x%08lx; DSA 0x%08lx, expected 0x%08lx)\n",
+		          words[0], (ULONG)INDIRECT_PROBE, got, (ULONG)~INDIRECT_PROBE);
+		return TEST_DMA_ERROR;
+	}
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Fill the descriptor table for a copy from one list of pieces to another
+ * Every chunk where a source and a destination piece overlap is mapped
+ * (DMAMapRange) and split at physical discontinuities; the caller finishes
+ * the pieces with DMACachePost()
+ * Returns number of descriptors including the final INT, 0 on overflow
+ */
+static ULONG BuildDescTable(struct SGPiece *src, ULONG nsrc,
+                            struct SGPiece *dst, ULONG ndst)
+{
+	struct DMASegment src_segs[MAX_DMA_SEGMENTS], dst_segs[MAX_DMA_SEGMENTS];
+	struct memmove_inst tmp[2 * MAX_DMA_SEGMENTS];
+	ULONG si = 0, di = 0, soff = 0, doff = 0;
+	ULONG n = 0, len, ns, nd, emitted, k;
+	BOOL failed = FALSE;
+
+	while (si < nsrc && di < ndst) {
+		len = src[si].len - soff;
+		if (dst[di].len - doff < len)
+			len = dst[di].len - doff;
+
+		ns = DMAMapRange(src[si].addr + soff, len, DMA_DIR_READ,
+		                 src_segs, MAX_DMA_SEGMENTS);
+		nd = DMAMapRange(dst[di].addr + doff, len, DMA_DIR_WRITE,
+		                 dst_segs, MAX_DMA_SEGMENTS);
+
+		emitted = (ns && nd) ?
+		          EmitMemMoves(tmp, 2 * MAX_DMA_SEGMENTS, src_segs, ns, dst_segs, nd) : 0;
+		if (!emitted || n + emitted >= INDIRECT_MAX_DESC)
+			failed = TRUE;
+
+		for (k = 0; !failed && k < emitted; k++, n++) {
+			g_ind_table[n].move = tmp[k];
+			g_ind_table[n].next = g_ind_table_phys + (n + 1) * sizeof(struct SGDescriptor);
+		}
+
+		soff += len;
+		doff += len;
+		if (soff == src[si].len) {
+			si++;
+			soff = 0;
+		}
+		if (doff == dst[di].len) {
+			di++;
+			doff = 0;
+		}
+	}
+
+	if (failed) {
+		dbgprintf("ERROR: Descriptor table too small (%ld entries)\n",
+		          (ULONG)INDIRECT_MAX_DESC);
+		return 0;
+	}
+
+	memset(&g_ind_table[n], 0, sizeof(struct SGDescriptor));
+	BuildIntInst((struct jump_inst *)&g_ind_table[n].move, INDIRECT_MAGIC);
+
+	return n + 1;
+}
+
+/*
+ * Run one table-indirect transfer - only the table changes, the script
+ * is reused as is
+ * Returns TEST_SUCCESS or an error code; *ndesc is the descriptor count
+ */
+static LONG RunIndirectTransfer(volatile struct ncr710 *ncr,
+                                struct SGPiece *src, ULONG nsrc,
+                                struct SGPiece *dst, ULONG ndst, ULONG *ndesc)
+{
+	ULONG i, n;
+	LONG status;
+
+	DMACacheClear();
+	n = BuildDescTable(src, nsrc, dst, ndst);
+	*ndesc = n;
+
+	if (n) {
+		DMACachePre(g_ind_table, n * sizeof(struct SGDescriptor), DMA_DIR_READ);
+		DMACachePre(g_ind_script, sizeof(struct IndirectScript), DMA_DIR_BOTH);
+
+		WRITE_LONG(ncr, dsa, g_ind_table_phys);
+		status = ExecuteScript(ncr, g_ind_script_phys, INDIRECT_MAGIC, "Indirect DMA");
+
+		// The chip patched the script - drop any stale CPU view of it
+		DMACachePost(g_ind_script, sizeof(struct IndirectScript), DMA_DIR_BOTH);
+		DMACachePost(g_ind_table, n * sizeof(struct SGDescriptor), DMA_DIR_READ);
+	} else {
+		status = TEST_DMA_ERROR;
+	}
+
+	for (i = 0; i < nsrc; i++)
+		DMACachePost(src[i].addr, src[i].len, DMA_DIR_READ);
+	for (i = 0; i < ndst; i++)
+		DMACachePost(dst[i].addr, dst[i].len, DMA_DIR_WRITE);
+	DMACacheClear();
+
+	return status;
+}
+
+/*
+ * Compare the concatenated destination pieces with the source pieces
+ * Returns TEST_SUCCESS or TEST_VERIFY_ERROR with the byte offset
+ */
+static LONG VerifyPieces(struct SGPiece *src, ULONG nsrc,
+                         struct SGPiece *dst, ULONG ndst, ULONG *error_offset)
+{
+	ULONG si = 0, di = 0, soff = 0, doff = 0, pos = 0;
+
+	while (si < nsrc && di < ndst) {
+		if (src[si].addr[soff] != dst[di].addr[doff]) {
+			*error_offset = pos;
+			return TEST_VERIFY_ERROR;
+		}
+		pos++;
+		if (++soff == src[si].len) {
+			si++;
+			soff = 0;
+		}
+		if (++doff == dst[di].len) {
+			di++;
+			doff = 0;
+		}
+	}
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Time INDIRECT_ITERATIONS transfers of one list pair, StatsRuns() times
+ * Returns median rate in hundredths of MB/s, 0 if any transfer failed
+ */
+static ULONG TimeIndirect(volatile struct ncr710 *ncr, const char *name,
+                          struct SGPiece *src, ULONG nsrc,
+                          struct SGPiece *dst, ULONG ndst,
+                          ULONG total, ULONG ref_rate)
+{
+	struct EClockVal t0, t1;
+	ULONG run_us[STATS_MAX_REPS];
+	struct SampleSet set;
+	struct SampleStats st;
+	ULONG micros, ndesc = 0, offset, rate;
+	ULONG i, it, run;
+	LONG status = TEST_SUCCESS;
+
+	StatsBegin(&set, run_us);
+	for (run = 0; run < StatsRuns() && status == TEST_SUCCESS; run++) {
+		micros = 0;
+		for (it = 0; it < INDIRECT_ITERATIONS && status == TEST_SUCCESS; it++) {
+			for (i = 0; i < ndst; i++)
+				memset(dst[i].addr, (it * 0x3B + 0x5A) & 0xFF, dst[i].len);
+
+			ReadTimer(&t0);
+			status = RunIndirectTransfer(ncr, src, nsrc, dst, ndst, &ndesc);
+			ReadTimer(&t1);
+			micros += ElapsedMicros(&t0, &t1);
+
+			if (status == TEST_SUCCESS &&
+			    VerifyPieces(src, nsrc, dst, ndst, &offset) != TEST_SUCCESS) {
+				dbgprintf("  FAILED %s: mismatch at byte %ld (iteration %ld)\n",
+				          name, offset, it);
+				status = TEST_VERIFY_ERROR;
+			}
+		}
+		StatsAdd(&set, micros);
+	}
+
+	if (status != TEST_SUCCESS) {
+		if (status != TEST_VERIFY_ERROR)
+			dbgprintf("  FAILED %s: status %ld\n", name, status);
+		return 0;
+	}
+
+	StatsCompute(&set, &st);
+	rate = StatsRate(total * INDIRECT_ITERATIONS, &st);
+	dbgprintf("  %-14s %2ld -> %-2ld %4ld desc ", name, nsrc, ndst, ndesc - 1);
+	PrintRateStats(total * INDIRECT_ITERATIONS, &st);
+	dbgprintf("  %3ld%% of inline  %ld us/transfer\n",
+	          ref_rate ? (rate * 100) / ref_rate : 0, st.median_us / INDIRECT_ITERATIONS);
+
+	return rate;
+}
+
+/*
+ * Inline-address gather baseline (script rebuilt every transfer)
+ */
+static ULONG TimeInlineGather(volatile struct ncr710 *ncr, UBYTE **sources,
+                              ULONG *sizes, ULONG n, UBYTE *dest, ULONG total)
+{
+	struct TestResult result;
+	struct EClockVal t0, t1;
+	ULONG run_us[STATS_MAX_REPS];
+	struct SampleSet set;
+	struct SampleStats st;
+	ULONG micros, offset = 0;
+	ULONG i, it, run;
+	LONG status = TEST_SUCCESS;
+
+	StatsBegin(&set, run_us);
+	for (run = 0; run < StatsRuns() && status == TEST_SUCCESS; run++) {
+		micros = 0;
+		for (it = 0; it < INDIRECT_ITERATIONS && status == TEST_SUCCESS; it++) {
+			memset(dest, (it * 0x3B + 0x5A) & 0xFF, total);
+
+			ReadTimer(&t0);
+			status = RunScatterGatherTest(ncr, sources, dest, sizes, n);
+			ReadTimer(&t1);
+			micros += ElapsedMicros(&t0, &t1);
+
+			for (i = 0, offset = 0; status == TEST_SUCCESS && i < n; offset += sizes[i++])
+				status = VerifyBuffer(sources[i], dest + offset, sizes[i], &result);
+		}
+		StatsAdd(&set, micros);
+	}
+
+	if (status != TEST_SUCCESS) {
+		dbgprintf("  FAILED inline gather: status %ld\n", status);
+		return 0;
+	}
+
+	StatsCompute(&set, &st);
+	dbgprintf("  %-14s %2ld -> 1  %4ld move ", "inline gather", n, n);
+	PrintRateStats(total * INDIRECT_ITERATIONS, &st);
+	dbgprintf("  100%% of inline  %ld us/transfer\n", st.median_us / INDIRECT_ITERATIONS);
+
+	return StatsRate(total * INDIRECT_ITERATIONS, &st);
+}
+
+/*
+ * Gather, scatter and many-to-many through the descriptor table, each
+ * compared with the inline-address gather of the same bytes
+ */
+void TestTableIndirect(volatile struct ncr710 *ncr)
+{
+	struct SGPiece gsrc[MAX_SG_SEGMENTS], gdst[1];
+	struct SGPiece ssrc[1], sdst[MAX_SG_SEGMENTS];
+	struct SGPiece msrc[MAX_SG_SEGMENTS], mdst[MAX_SG_SEGMENTS];
+	UBYTE *bases[MAX_SG_SEGMENTS];
+	ULONG sizes[MAX_SG_SEGMENTS];
+	UBYTE *linear;
+	ULONG n = 0, total, i, ref;
+	LONG skew, dskew;
+	int idx;
+
+	dbgprintf("\n=== Table-Indirect Scatter/Gather ===\n");
+
+	for (idx = 0; idx < g_num_test_buffers && n < MAX_SG_SEGMENTS; idx++) {
+		if (*g_test_buffers[idx].buf) {
+			bases[n] = *g_test_buffers[idx].buf;
+			sizes[n] = SG_SEGMENT_SIZE;
+			n++;
+		}
+	}
+
+	if (n < 2) {
+		dbgprintf("ERROR: Need at least 2 memory regions for table-indirect tests\n");
+		return;
+	}
+	total = n * SG_SEGMENT_SIZE;
+
+	linear = AllocMem(total, MEMF_FAST);
+	g_ind_script = AllocDMAContig(sizeof(struct IndirectScript), MEMF_FAST | MEMF_CLEAR);
+	g_ind_table = AllocDMAContig(DMA_PAGE_SIZE, MEMF_FAST | MEMF_CLEAR);
+	if (!linear || !g_ind_script || !g_ind_table) {
+		dbgprintf("ERROR: Could not allocate table-indirect buffers\n");
+		goto cleanup;
+	}
+
+	g_ind_script_phys = DMAPhysAddr(g_ind_script);
+	g_ind_table_phys = DMAPhysAddr(g_ind_table);
+
+	if (ProbeDSAAccess(ncr) != TEST_SUCCESS) {
+		dbgprintf("Table-indirect tests skipped\n\n");
+		goto cleanup;
+	}
+
+	BuildIndirectScript(ncr);
+	dbgprintf("Fixed script at 0x%08lx (%ld bytes), table at 0x%08lx (%ld descriptors)\n",
+	          g_ind_script_phys, (ULONG)sizeof(struct IndirectScript),
+	          g_ind_table_phys, (ULONG)INDIRECT_MAX_DESC);
+	dbgprintf("%ld x %ld bytes, %ld transfers per run\n",
+	          n, (ULONG)SG_SEGMENT_SIZE, (ULONG)INDIRECT_ITERATIONS);
+	PrintStatsConfig();
+	dbgprintf("\n");
+
+	SeedRandom(0x7AB1E5ED);
+	for (i = 0; i < n; i++) {
+		FillPattern(bases[i], SG_SEGMENT_SIZE + INDIRECT_SKEW, PATTERN_RANDOM);
+		gsrc[i].addr = bases[i];
+		gsrc[i].len = SG_SEGMENT_SIZE;
+	}
+
+	// Baseline and gather: every region -> one FAST buffer
+	ref = TimeInlineGather(ncr, bases, sizes, n, linear, total);
+
+	gdst[0].addr = linear;
+	gdst[0].len = total;
+	TimeIndirect(ncr, "gather", gsrc, n, gdst, 1, total, ref);
+
+	// Scatter: one FAST buffer -> every region
+	FillPattern(linear, total, PATTERN_RANDOM);
+	ssrc[0].addr = linear;
+	ssrc[0].len = total;
+	for (i = 0; i < n; i++) {
+		sdst[i].addr = bases[i] + INDIRECT_SCATTER_OFFSET;
+		sdst[i].len = SG_SEGMENT_SIZE;
+	}
+	TimeIndirect(ncr, "scatter", ssrc, 1, sdst, n, total, ref);
+
+	// Many-to-many: uneven pieces on both sides, split points never line up
+	for (i = 0; i < n; i++) {
+		skew = (i + 1 < n || (n & 1) == 0) ? ((i & 1) ? -INDIRECT_SKEW : INDIRECT_SKEW) : 0;
+		dskew = (i + 1 < n || (n & 1) == 0) ? ((i & 1) ? INDIRECT_DST_SKEW : -INDIRECT_DST_SKEW) : 0;
+
+		msrc[i].addr = bases[i];
+		msrc[i].len = SG_SEGMENT_SIZE + skew;
+		mdst[i].addr = bases[(i + 1) % n] + INDIRECT_SCATTER_OFFSET + ((i * 13) & 15);
+		mdst[i].len = SG_SEGMENT_SIZE + dskew;
+	}
+	TimeIndirect(ncr, "many-to-many", msrc, n, mdst, n, total, ref);
+
+	dbgprintf("\n");
+
+cleanup:
+	if (g_ind_table)
+		FreeDMAContig(g_ind_table);
+	if (g_ind_script)
+		FreeDMAContig(g_ind_script);
+	if (linear)
+		FreeMem(linear, total);
+	g_ind_table = NULL;
+	g_ind_script = NULL;
+}
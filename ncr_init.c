@@ -4,9 +4,11 @@
 
 #include "ncr_dmatest.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <exec/execbase.h>
 #include <proto/exec.h>
 #include <proto/dos.h>
+#include <dos/var.h>
 #include <hardware/cia.h>
 
 /*
@@ -208,14 +210,98 @@ LONG InitNCR(volatile struct ncr710 *ncr)
 	// Clear SCSI transfer register
 	ncr->sxfer = 0;
 
+	// Use the burst tuner's saved configuration if there is one
+	{
+		struct BurstConfig cfg;
+
+		if (LoadBurstConfig(&cfg) == 0) {
+			dbgprintf("  Applying tuned burst configuration (%s)...\n",
+			          BURST_ENV_NAME);
+			ApplyBurstConfig(ncr, &cfg);
+		}
+	}
+
 	dbgprintf("NCR initialization complete\n");
 	dbgprintf("  DMODE:  0x%02lx\n", (ULONG)ncr->dmode);
+	dbgprintf("  CTEST7: 0x%02lx\n", (ULONG)ncr->ctest7);
 	dbgprintf("  DCNTL:  0x%02lx\n", (ULONG)ncr->dcntl);
 	dbgprintf("  DIEN:   0x%02lx (interrupts disabled)\n", (ULONG)ncr->dien);
 
 	return 0;
 }
 
+/*
+ * Read the current DMA bus configuration
+ */
+void ReadBurstConfig(volatile struct ncr710 *ncr, struct BurstConfig *cfg)
+{
+	cfg->dmode = ncr->dmode;
+	cfg->dcntl = ncr->dcntl;
+	cfg->ctest7 = ncr->ctest7;
+	cfg->pad = 0;
+}
+
+/*
+ * Apply a DMA bus configuration
+ * EA is always kept set - the A4000T bus hangs without it
+ */
+void ApplyBurstConfig(volatile struct ncr710 *ncr, struct BurstConfig *cfg)
+{
+	ncr->dmode = cfg->dmode;
+	ncr->dcntl = cfg->dcntl | DCNTLF_EA;
+	ncr->ctest7 = cfg->ctest7;
+}
+
+/*
+ * Load the saved burst configuration from ENV:
+ * Format: "<dmode> <dcntl> <ctest7>" as hex bytes
+ * Returns 0 if a valid configuration was found, -1 otherwise
+ */
+LONG LoadBurstConfig(struct BurstConfig *cfg)
+{
+	char buf[32];
+	char *p, *end;
+	ULONG val[3];
+	int i;
+
+	if (GetVar(BURST_ENV_NAME, buf, sizeof(buf), GVF_GLOBAL_ONLY) <= 0)
+		return -1;
+
+	p = buf;
+	for (i = 0; i < 3; i++) {
+		val[i] = strtoul(p, &end, 16);
+		if (end == p || val[i] > 0xFF)
+			return -1;
+		p = end;
+	}
+
+	cfg->dmode = val[0];
+	cfg->dcntl = val[1];
+	cfg->ctest7 = val[2];
+	cfg->pad = 0;
+
+	return 0;
+}
+
+/*
+ * Save a burst configuration to ENV: and ENVARC:
+ * Returns 0 on success, -1 on failure
+ */
+LONG SaveBurstConfig(struct BurstConfig *cfg)
+{
+	char buf[32];
+
+	sprintf(buf, "0x%02lx 0x%02lx 0x%02lx",
+	        (ULONG)cfg->dmode, (ULONG)cfg->dcntl, (ULONG)cfg->ctest7);
+
+	if (!SetVar(BURST_ENV_NAME, buf, -1, GVF_GLOBAL_ONLY | GVF_SAVE_VAR)) {
+		dbgprintf("ERROR: Could not save %s\n", BURST_ENV_NAME);
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * Check for and handle any NCR interrupts/errors
  * Returns: 0 if OK, negative if error
@@ -0,0 +1,419 @@
+/*
+ * NCR 53C710 DMA Test Tool - Crash-safe result journal
+ *
+ * A hung bus or a Guru halfway through the standard sweep used to lose
+ * every result. The journal appends each completed sweep cell, each phase
+ * and the scatter-gather stress progress to a small text file, written
+ * out every JOURNAL_SYNC_CELLS cells and at every phase end. With
+ * --resume the next run reads it back and skips what is already done, so
+ * an overnight campaign on flaky hardware keeps making progress. A
+ * resumed run writes every cell out at once; a cell that stops the
+ * machine again on JOURNAL_HANG_RETRIES resumes is recorded as hung and
+ * skipped.
+ *
+ * Records, one per line after the "NCRJ1" header:
+ *   C sdzp st    sweep cell done (src dst size_log2 pattern in hex), status
+ *   R sdzp       run resumed at this cell (written to disk at once)
+ *   H sdzp       cell skipped after hanging JOURNAL_HANG_RETRIES resumes
+ *   P n          phase JPHASE_n done
+ *   G it fails   scatter-gather stress iterations done, failures so far
+ *
+ * A torn last line (crash during the write) is ignored.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <exec/memory.h>
+#include <proto/exec.h>
+#include <proto/dos.h>
+#include <dos/dos.h>
+
+#define JOURNAL_HEADER  "NCRJ1"
+#define CELL_HUNG       0xFF	// g_cell_state[] value of a skipped cell
+
+static char g_journal_path[JOURNAL_MAX_PATH] = JOURNAL_DEFAULT_PATH;
+static BOOL g_journal_resume;
+static BOOL g_journal_active;
+
+/* Records not yet on disk */
+static char g_pending[JOURNAL_BUF_SIZE];
+static ULONG g_pending_len;
+static ULONG g_pending_cells;
+
+/* Completed cells: 0 = not run, status + 1, or CELL_HUNG */
+static UBYTE g_cell_state[JOURNAL_MAX_BUFFERS][JOURNAL_MAX_BUFFERS][16][8];
+static ULONG g_phases;			// Bit per JPHASE_xxx done
+static ULONG g_stress_iterations;
+static ULONG g_stress_failures;
+static ULONG g_resumed_cells;
+
+/* This run resumes an earlier one and has marked where */
+static BOOL g_resuming;
+static BOOL g_resume_marked;
+
+/*
+ * Select the journal file and whether to resume from it
+ */
+void SetJournal(const char *path, BOOL resume)
+{
+	if (path) {
+		strncpy(g_journal_path, path, JOURNAL_MAX_PATH - 1);
+		g_journal_path[JOURNAL_MAX_PATH - 1] = '\0';
+	}
+	g_journal_resume = resume;
+}
+
+/*
+ * Write pending records to the end of the file
+ * Closing the file is what gets the data and its length onto the disk
+ */
+static void JournalSync(void)
+{
+	BPTR fh;
+
+	if (!g_journal_active || !g_pending_len)
+		return;
+
+	fh = Open((STRPTR)g_journal_path, MODE_READWRITE);
+	if (!fh) {
+		dbgprintf("WARNING: Could not write %s - journal off\n", g_journal_path);
+		g_journal_active = FALSE;
+		return;
+	}
+
+	Seek(fh, 0, OFFSET_END);
+	if (Write(fh, g_pending, g_pending_len) != (LONG)g_pending_len)
+		dbgprintf("WARNING: Short write to %s\n", g_journal_path);
+	Close(fh);
+
+	g_pending_len = 0;
+	g_pending_cells = 0;
+}
+
+/*
+ * Queue one record line
+ */
+static void JournalAppend(const char *line)
+{
+	ULONG len = strlen(line);
+
+	if (!g_journal_active)
+		return;
+
+	if (g_pending_len + len > JOURNAL_BUF_SIZE)
+		JournalSync();
+
+	memcpy(g_pending + g_pending_len, line, len);
+	g_pending_len += len;
+}
+
+/*
+ * Cell key as used by the failure history: src dst size_log2 pattern
+ * Returns 0xFFFFFFFF if the cell has no key (not a test buffer)
+ */
+static ULONG CellKey(UBYTE *src_base, UBYTE *dst_base, ULONG size, ULONG pattern)
+{
+	LONG src_idx = FindTestBuffer(src_base);
+	LONG dst_idx = FindTestBuffer(dst_base);
+	ULONG log2 = 0;
+
+	while ((1UL << log2) < size)
+		log2++;
+
+	if (src_idx < 0 || dst_idx < 0 || src_idx >= JOURNAL_MAX_BUFFERS ||
+	    dst_idx >= JOURNAL_MAX_BUFFERS || log2 > 15 || pattern > 7)
+		return 0xFFFFFFFF;
+
+	return (src_idx << 12) | (dst_idx << 8) | (log2 << 4) | pattern;
+}
+
+static BOOL ValidKey(ULONG key)
+{
+	return key <= 0xFFFF && (key >> 12) < JOURNAL_MAX_BUFFERS &&
+	       ((key >> 8) & 0xF) < JOURNAL_MAX_BUFFERS && (key & 0xF) < 8;
+}
+
+static UBYTE *CellState(ULONG key)
+{
+	return &g_cell_state[(key >> 12) & 7][(key >> 8) & 7][(key >> 4) & 15][key & 7];
+}
+
+static void ResetJournalState(void)
+{
+	memset(g_cell_state, 0, sizeof(g_cell_state));
+	g_phases = 0;
+	g_stress_iterations = 0;
+	g_stress_failures = 0;
+	g_resumed_cells = 0;
+	g_resuming = FALSE;
+	g_resume_marked = FALSE;
+	g_pending_len = 0;
+	g_pending_cells = 0;
+}
+
+/*
+ * Read the journal back
+ * Returns 0 on success, -1 if there is none or it is not a journal
+ */
+static LONG LoadJournal(void)
+{
+	BPTR fh;
+	LONG size;
+	char *buf, *p, *line, *end;
+	ULONG key, a, b, hang_key = 0xFFFFFFFF, hang_count = 0;
+	BOOL progress = TRUE, torn;
+
+	fh = Open((STRPTR)g_journal_path, MODE_OLDFILE);
+	if (!fh)
+		return -1;
+
+	Seek(fh, 0, OFFSET_END);
+	size = Seek(fh, 0, OFFSET_BEGINNING);
+	if (size <= 0) {
+		Close(fh);
+		return -1;
+	}
+
+	buf = AllocMem(size + 1, MEMF_ANY);
+	if (!buf) {
+		Close(fh);
+		return -1;
+	}
+	if (Read(fh, buf, size) != size) {
+		FreeMem(buf, size + 1);
+		Close(fh);
+		return -1;
+	}
+	Close(fh);
+	buf[size] = '\0';
+
+	if (strncmp(buf, JOURNAL_HEADER "\n", sizeof(JOURNAL_HEADER)) != 0) {
+		FreeMem(buf, size + 1);
+		return -1;
+	}
+
+	torn = (buf[size - 1] != '\n');
+
+	// Complete lines only - the last one may be torn
+	for (p = buf + sizeof(JOURNAL_HEADER); (end = strchr(p, '\n')) != NULL; p = end + 1) {
+		*end = '\0';
+		if (end - p < 3 || p[1] != ' ')
+			continue;
+		line = p + 2;
+		key = strtoul(line, &line, 16);
+
+		switch (p[0]) {
+		case 'C':
+			a = strtoul(line, NULL, 10);
+			if (ValidKey(key)) {
+				*CellState(key) = (UBYTE)(a + 1);
+				progress = TRUE;
+			}
+			break;
+		case 'H':
+			if (ValidKey(key))
+				*CellState(key) = CELL_HUNG;
+			break;
+		case 'R':
+			// Resumed at the same cell again without getting past it
+			if (key == hang_key && !progress)
+				hang_count++;
+			else
+				hang_count = 1;
+			hang_key = key;
+			progress = FALSE;
+			break;
+		case 'P':
+			// Phase numbers are decimal
+			a = strtoul(p + 2, NULL, 10);
+			if (a < 32)
+				g_phases |= 1UL << a;
+			break;
+		case 'G':
+			a = strtoul(p + 2, &line, 10);
+			b = strtoul(line, NULL, 10);
+			g_stress_iterations = a;
+			g_stress_failures = b;
+			break;
+		}
+	}
+
+	// A torn line must not swallow the next record
+	if (torn)
+		JournalAppend("\n");
+
+	FreeMem(buf, size + 1);
+
+	if (!progress && hang_count >= JOURNAL_HANG_RETRIES && ValidKey(hang_key)) {
+		char rec[16];
+
+		dbgprintf("Journal: cell %04lx stopped the machine %ld times - skipped as hung\n",
+		          hang_key, hang_count + 1);
+		*CellState(hang_key) = CELL_HUNG;
+		sprintf(rec, "H %04lx\n", hang_key);
+		JournalAppend(rec);
+	}
+
+	return 0;
+}
+
+/*
+ * Start the journal for a standard sweep: a new file, or the old one
+ * read back with --resume
+ * Returns TRUE if this run resumes an earlier one
+ */
+BOOL JournalStart(void)
+{
+	BPTR fh;
+
+	ResetJournalState();
+	g_journal_active = TRUE;
+
+	if (g_journal_resume) {
+		if (LoadJournal() == 0) {
+			dbgprintf("Resuming from %s\n", g_journal_path);
+			g_resuming = TRUE;
+			JournalSync();
+			return TRUE;
+		}
+		dbgprintf("No journal to resume in %s - starting over\n", g_journal_path);
+		ResetJournalState();
+	}
+
+	fh = Open((STRPTR)g_journal_path, MODE_NEWFILE);
+	if (!fh) {
+		dbgprintf("WARNING: Could not create %s - running without journal\n",
+		          g_journal_path);
+		g_journal_active = FALSE;
+		return FALSE;
+	}
+	Write(fh, JOURNAL_HEADER "\n", sizeof(JOURNAL_HEADER));
+	Close(fh);
+
+	dbgprintf("Journal: %s\n", g_journal_path);
+
+	return FALSE;
+}
+
+/*
+ * Has an earlier run finished this phase?
+ */
+BOOL JournalPhaseDone(ULONG phase)
+{
+	return (g_phases & (1UL << phase)) != 0;
+}
+
+/*
+ * Record a phase as finished and write everything out
+ */
+void JournalPhase(ULONG phase)
+{
+	char rec[16];
+
+	g_phases |= 1UL << phase;
+	sprintf(rec, "P %ld\n", phase);
+	JournalAppend(rec);
+	JournalSync();
+}
+
+/*
+ * Result of a cell from an earlier run
+ * Returns its status, or -1 if it still has to run. The first cell that
+ * has to run after a resume is marked on disk before it starts.
+ */
+LONG JournalLookupCell(UBYTE *src_base, UBYTE *dst_base, ULONG size, ULONG pattern)
+{
+	ULONG key = CellKey(src_base, dst_base, size, pattern);
+	UBYTE state;
+	char rec[16];
+
+	if (!g_journal_active || key == 0xFFFFFFFF)
+		return -1;
+
+	state = *CellState(key);
+	if (state == CELL_HUNG) {
+		g_resumed_cells++;
+		return TEST_TIMEOUT;
+	}
+	if (state) {
+		g_resumed_cells++;
+		return state - 1;
+	}
+
+	if (g_resuming && !g_resume_marked) {
+		g_resume_marked = TRUE;
+		sprintf(rec, "R %04lx\n", key);
+		JournalAppend(rec);
+		JournalSync();
+	}
+
+	return -1;
+}
+
+/*
+ * Record a finished cell
+ * After a resume every cell goes to disk at once: the crash that made
+ * the resume necessary is likely close by, and hang detection must see
+ * exactly which cell was the last to finish
+ */
+void JournalRecordCell(UBYTE *src_base, UBYTE *dst_base, ULONG size, ULONG pattern,
+                       LONG status)
+{
+	ULONG key = CellKey(src_base, dst_base, size, pattern);
+	char rec[24];
+
+	// An aborted cell never ran to a result - run it again on resume
+	if (!g_journal_active || key == 0xFFFFFFFF || status == TEST_ABORTED)
+		return;
+
+	*CellState(key) = (UBYTE)(status + 1);
+	sprintf(rec, "C %04lx %ld\n", key, status);
+	JournalAppend(rec);
+
+	if (++g_pending_cells >= JOURNAL_SYNC_CELLS || g_resuming)
+		JournalSync();
+}
+
+/*
+ * Stress iterations an earlier run completed
+ * Returns the iteration count, *failures the failures among them
+ */
+ULONG JournalStressResume(ULONG *failures)
+{
+	*failures = g_journal_active ? g_stress_failures : 0;
+
+	return g_journal_active ? g_stress_iterations : 0;
+}
+
+/*
+ * Count stress progress, written out every JOURNAL_STRESS_SYNC iterations
+ */
+void JournalStressProgress(ULONG iterations, ULONG failures)
+{
+	char rec[32];
+
+	if (!g_journal_active || (iterations % JOURNAL_STRESS_SYNC) != 0)
+		return;
+
+	g_stress_iterations = iterations;
+	g_stress_failures = failures;
+	sprintf(rec, "G %ld %ld\n", iterations, failures);
+	JournalAppend(rec);
+	JournalSync();
+}
+
+/*
+ * Close the campaign: everything to disk, say what came from the journal
+ */
+void JournalFinish(void)
+{
+	if (!g_journal_active)
+		return;
+
+	JournalPhase(JPHASE_DONE);
+	if (g_resumed_cells)
+		dbgprintf("Journal: %ld sweep cells taken from earlier runs\n", g_resumed_cells);
+	g_journal_active = FALSE;
+}
@@ -0,0 +1,314 @@
+/*
+ * NCR 53C710 DMA Test Tool - Alignment and odd-length transfer matrix
+ *
+ * RunComprehensiveTest() only moves power-of-two sizes between longword
+ * aligned buffers. Real SCSI I/O hits unaligned and odd-length buffers,
+ * where the 710 FIFO and burst logic take different paths. This mode runs
+ * every source/destination misalignment (0-15) against a set of odd and
+ * prime lengths, verifies each cell (including guard bytes either side of
+ * the destination to catch overruns) and reports MB/s per cell.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <exec/memory.h>
+#include <proto/exec.h>
+
+/* Odd and prime transfer lengths */
+static const ULONG matrix_lengths[] = {
+	1, 3, 5, 7, 13, 15, 31, 61, 127, 255, 509, 1021, 4095, 16381
+};
+#define NUM_MATRIX_LENGTHS (sizeof(matrix_lengths) / sizeof(matrix_lengths[0]))
+
+/* Shorter transfers are dominated by setup cost - kept out of the summary */
+#define MATRIX_SUMMARY_MIN 255
+
+/* Per-cell results for the current length */
+static ULONG g_cell_rate[MATRIX_MAX_ALIGN][MATRIX_MAX_ALIGN];
+static UBYTE g_cell_ok[MATRIX_MAX_ALIGN][MATRIX_MAX_ALIGN];
+static struct SampleStats g_cell_stats[MATRIX_MAX_ALIGN][MATRIX_MAX_ALIGN];
+
+/*
+ * Bytes in the destination window (guard + max misalignment + data + guard)
+ */
+static ULONG WindowSize(ULONG size)
+{
+	return MATRIX_GUARD + MATRIX_MAX_ALIGN + size + MATRIX_GUARD;
+}
+
+/*
+ * Fill the destination window
+ */
+static void FillGuard(UBYTE *dst_base, ULONG size)
+{
+	ULONG i;
+	ULONG total = WindowSize(size);
+
+	for (i = 0; i < total; i++)
+		dst_base[i] = MATRIX_GUARD_BYTE;
+
+	// Push the guards to RAM so an overrun is not hidden by the cache
+	DMACacheClear();
+	DMACachePre(dst_base, total, DMA_DIR_WRITE);
+}
+
+/*
+ * Verify one matrix cell: data must match and the guard bytes either
+ * side of the destination must be untouched
+ * Returns TEST_SUCCESS or TEST_VERIFY_ERROR (offset relative to dst,
+ * negative offsets are reported as the guard below the destination)
+ */
+static LONG VerifyCell(UBYTE *src, UBYTE *dst_base, UBYTE *dst, ULONG size,
+                       LONG *error_offset)
+{
+	LONG i;
+
+	// The same range FillGuard() handed to the chip
+	DMACacheClear();
+	DMACachePost(dst_base, WindowSize(size), DMA_DIR_WRITE);
+
+	for (i = -MATRIX_GUARD; i < 0; i++) {
+		if (dst[i] != MATRIX_GUARD_BYTE) {
+			*error_offset = i;
+			return TEST_VERIFY_ERROR;
+		}
+	}
+
+	for (i = 0; i < (LONG)size; i++) {
+		if (dst[i] != src[i]) {
+			*error_offset = i;
+			return TEST_VERIFY_ERROR;
+		}
+	}
+
+	for (i = size; i < (LONG)(size + MATRIX_GUARD); i++) {
+		if (dst[i] != MATRIX_GUARD_BYTE) {
+			*error_offset = i;
+			return TEST_VERIFY_ERROR;
+		}
+	}
+
+	return TEST_SUCCESS;
+}
+
+/*
+ * Run one matrix cell: src_base+src_align -> dst_base+MATRIX_GUARD+dst_align
+ * The source must already hold size+MATRIX_MAX_ALIGN bytes of pattern.
+ * Returns TEST_SUCCESS or an error code; *micros is the DMA time
+ */
+LONG RunMatrixCell(volatile struct ncr710 *ncr, UBYTE *src_base, UBYTE *dst_base,
+                   ULONG src_align, ULONG dst_align, ULONG size,
+                   ULONG *micros, LONG *error_offset)
+{
+	UBYTE *src = src_base + src_align;
+	UBYTE *dst = dst_base + MATRIX_GUARD + dst_align;
+	struct EClockVal t0, t1;
+	LONG status;
+
+	FillGuard(dst_base, size);
+
+	ReadTimer(&t0);
+	status = RunDMATest(ncr, src, dst, size);
+	ReadTimer(&t1);
+
+	*micros = ElapsedMicros(&t0, &t1);
+
+	if (status == TEST_SUCCESS)
+		status = VerifyCell(src, dst_base, dst, size, error_offset);
+
+	return status;
+}
+
+/*
+ * Print one cell's min/median/p99 and CV
+ */
+static void PrintCellStats(const char *what, ULONG size, ULONG s, ULONG d)
+{
+	dbgprintf("  %-8s src+%-2ld dst+%-2ld:", what, s, d);
+	PrintRateStats(size, &g_cell_stats[s][d]);
+	dbgprintf("\n");
+}
+
+/*
+ * Print the 16x16 grid for one length
+ * Rows are source misalignment, columns destination misalignment.
+ * The grid holds medians; the aligned cell, the slowest cell and every
+ * noisy cell follow with their full statistics.
+ */
+static void PrintMatrixGrid(ULONG size)
+{
+	ULONG s, d, rate, noisy = 0;
+	ULONG slow_s = 0, slow_d = 0, slow_rate = 0xFFFFFFFF;
+
+	dbgprintf("\n  Length %ld bytes (median MB/s, rows=src+N, cols=dst+N):\n   ", size);
+	for (d = 0; d < MATRIX_MAX_ALIGN; d++)
+		dbgprintf(" %4ld", d);
+	dbgprintf("\n");
+
+	for (s = 0; s < MATRIX_MAX_ALIGN; s++) {
+		dbgprintf("%2ld:", s);
+		for (d = 0; d < MATRIX_MAX_ALIGN; d++) {
+			if (!g_cell_ok[s][d]) {
+				dbgprintf("  ERR");
+			} else {
+				rate = g_cell_rate[s][d];
+				dbgprintf("%s%2ld.%01ld", g_cell_stats[s][d].noisy ? "~" : " ",
+				          rate / 100, (rate % 100) / 10);
+				noisy += g_cell_stats[s][d].noisy;
+				if (rate < slow_rate) {
+					slow_rate = rate;
+					slow_s = s;
+					slow_d = d;
+				}
+			}
+		}
+		dbgprintf("\n");
+	}
+
+	dbgprintf("  min/median/p99 MB/s:\n");
+	if (g_cell_ok[0][0])
+		PrintCellStats("aligned", size, 0, 0);
+	if (slow_rate != 0xFFFFFFFF)
+		PrintCellStats("slowest", size, slow_s, slow_d);
+
+	if (noisy) {
+		dbgprintf("  %ld noisy cells (~):\n", noisy);
+		for (s = 0; s < MATRIX_MAX_ALIGN; s++) {
+			for (d = 0; d < MATRIX_MAX_ALIGN; d++) {
+				if (g_cell_ok[s][d] && g_cell_stats[s][d].noisy)
+					PrintCellStats("noisy", size, s, d);
+			}
+		}
+	}
+}
+
+/*
+ * Run the full alignment/length matrix for one region pair
+ * Returns number of failed cells
+ */
+static ULONG RunMatrixPair(volatile struct ncr710 *ncr,
+                           UBYTE *src_base, const char *src_name,
+                           UBYTE *dst_base, const char *dst_name)
+{
+	ULONG src_sum[MATRIX_MAX_ALIGN], dst_sum[MATRIX_MAX_ALIGN];
+	ULONG run_us[STATS_MAX_REPS];
+	struct SampleSet set;
+	ULONG samples = 0;
+	ULONG failed = 0;
+	ULONG l, s, d, size;
+	LONG status, error_offset;
+
+	dbgprintf("\n*** Matrix: %s -> %s ***\n", src_name, dst_name);
+
+	for (s = 0; s < MATRIX_MAX_ALIGN; s++) {
+		src_sum[s] = 0;
+		dst_sum[s] = 0;
+	}
+
+	for (l = 0; l < NUM_MATRIX_LENGTHS; l++) {
+		size = matrix_lengths[l];
+
+		// Source covers every misalignment for this length
+		FillPattern(src_base, size + MATRIX_MAX_ALIGN, PATTERN_RANDOM);
+
+		for (s = 0; s < MATRIX_MAX_ALIGN; s++) {
+			for (d = 0; d < MATRIX_MAX_ALIGN; d++) {
+				UBYTE *dst = dst_base + MATRIX_GUARD + d;
+				ULONG micros, run;
+
+				StatsBegin(&set, run_us);
+				for (run = 0; run < StatsRuns(); run++) {
+					status = RunMatrixCell(ncr, src_base, dst_base, s, d, size,
+					                       &micros, &error_offset);
+					if (status != TEST_SUCCESS)
+						break;
+					StatsAdd(&set, micros);
+				}
+				StatsCompute(&set, &g_cell_stats[s][d]);
+
+				g_cell_rate[s][d] = StatsRate(size, &g_cell_stats[s][d]);
+				g_cell_ok[s][d] = (status == TEST_SUCCESS);
+
+				if (status != TEST_SUCCESS) {
+					failed++;
+					if (status == TEST_VERIFY_ERROR) {
+						dbgprintf("  FAILED len=%ld src+%ld dst+%ld: "
+						          "mismatch at offset %ld (0x%02lx)\n",
+						          size, s, d, error_offset,
+						          (ULONG)dst[error_offset]);
+					} else {
+						dbgprintf("  FAILED len=%ld src+%ld dst+%ld: status=%ld\n",
+						          size, s, d, status);
+					}
+				} else if (size >= MATRIX_SUMMARY_MIN) {
+					src_sum[s] += g_cell_rate[s][d];
+					dst_sum[d] += g_cell_rate[s][d];
+				}
+			}
+		}
+
+		if (size >= MATRIX_SUMMARY_MIN)
+			samples += MATRIX_MAX_ALIGN;
+
+		PrintMatrixGrid(size);
+		dbgflush();
+	}
+
+	// Per-alignment summary relative to the aligned case
+	if (samples) {
+		dbgprintf("\n  Average MB/s per misalignment (lengths >= %ld):\n",
+		          (ULONG)MATRIX_SUMMARY_MIN);
+		dbgprintf("  off    src+N   %%aligned    dst+N   %%aligned\n");
+		for (s = 0; s < MATRIX_MAX_ALIGN; s++) {
+			ULONG sa = src_sum[s] / samples;
+			ULONG da = dst_sum[s] / samples;
+			ULONG sref = src_sum[0] / samples;
+			ULONG dref = dst_sum[0] / samples;
+
+			dbgprintf("  %2ld   %3ld.%02ld   %6ld%%   %3ld.%02ld   %6ld%%\n",
+			          s,
+			          sa / 100, sa % 100, sref ? (sa * 100) / sref : 0,
+			          da / 100, da % 100, dref ? (da * 100) / dref : 0);
+		}
+	}
+
+	dbgprintf("\n*** Matrix: %s -> %s %s (%ld failed cells) ***\n",
+	          src_name, dst_name, failed ? "FAILED" : "PASSED", failed);
+
+	return failed;
+}
+
+/*
+ * Alignment matrix over every region pair (buf1 of each region as
+ * source, buf2 of each region as destination)
+ */
+void TestAlignmentMatrix(volatile struct ncr710 *ncr)
+{
+	int src_idx, dst_idx;
+	ULONG failed = 0;
+
+	dbgprintf("\n=== Alignment / Odd-Length Matrix ===\n");
+	dbgprintf("Misalignment 0-%ld x %ld lengths per region pair\n",
+	          (ULONG)(MATRIX_MAX_ALIGN - 1), (ULONG)NUM_MATRIX_LENGTHS);
+	PrintStatsConfig();
+
+	for (src_idx = 0; src_idx < g_num_test_buffers; src_idx += 2) {
+		for (dst_idx = 1; dst_idx < g_num_test_buffers; dst_idx += 2) {
+			UBYTE *src = *g_test_buffers[src_idx].buf;
+			UBYTE *dst = *g_test_buffers[dst_idx].buf;
+
+			if (!src || !dst) {
+				dbgprintf("*** Skipping: %s -> %s (buffer not available) ***\n",
+				          g_test_buffers[src_idx].name,
+				          g_test_buffers[dst_idx].name);
+				continue;
+			}
+
+			failed += RunMatrixPair(ncr,
+			                        src, g_test_buffers[src_idx].name,
+			                        dst, g_test_buffers[dst_idx].name);
+		}
+	}
+
+	dbgprintf("\n=== Alignment Matrix Complete (%ld failed cells) ===\n\n", failed);
+}
@@ -0,0 +1,262 @@
+/*
+ * NCR 53C710 DMA Test Tool - SCRIPTS micro-op costs
+ *
+ * A production script is a mix of memory moves, jumps and register
+ * operations, and its run time is the sum of what each costs on this bus.
+ * This mode builds chains of MICRO_CHAIN copies of one instruction type
+ * followed by the final INT, times them from the SCRIPTS region chosen by
+ * PlaceScripts(), subtracts the INT-only script and reports nanoseconds
+ * per instruction. Register chains are checked afterwards through the
+ * SCRATCH register, so a chain the chip cut short cannot look fast.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/memory.h>
+#include <proto/exec.h>
+
+#define MICRO_MAGIC     0x3C0DE000
+#define RW_OP_SFBR_TO   0x68	// 01 101 000: MOVE SFBR TO reg
+#define RW_OP_TO_SFBR   0x70	// 01 110 000: MOVE reg TO SFBR
+#define RW_OP_RMW_MOVE  0x78	// 01 111 000: MOVE data8 TO reg
+#define RW_OP_RMW_ADD   0x7E	// 01 111 110: MOVE reg + data8 TO reg
+#define RW_REG_SCRATCH0 0x34	// SCRATCH byte 0 (byte 3 with swapped lanes - SCRATCH either way)
+
+/* Instruction kinds */
+#define MICRO_NOP        0
+#define MICRO_JUMP       1
+#define MICRO_MOVE1      2
+#define MICRO_MOVE4      3
+#define MICRO_MOVE16     4
+#define MICRO_REG_WRITE  5
+#define MICRO_REG_ADD    6
+#define MICRO_TO_SFBR    7
+#define MICRO_FROM_SFBR  8
+#define NUM_MICRO_OPS    9
+
+static const char *micro_names[NUM_MICRO_OPS] = {
+	"JUMP not taken (NOP)",
+	"JUMP taken, to next",
+	"MOVE 1 byte",
+	"MOVE 4 bytes",
+	"MOVE 16 bytes",
+	"SCRATCH0 = data8",
+	"SCRATCH0 += 1",
+	"SCRATCH0 -> SFBR",
+	"SFBR -> SCRATCH0",
+};
+
+/*
+ * Fill in a register read/write instruction
+ */
+static void BuildRegInst(struct rw_reg_inst *inst, UBYTE op, UBYTE reg, UBYTE imm)
+{
+	inst->op = op;
+	inst->reg = reg;
+	inst->imm = imm;
+	inst->res = 0;
+	inst->res2 = 0;
+}
+
+/*
+ * Build a chain of n instructions of one kind at script (physical address
+ * phys), then the final INT; data_phys is a 32-byte FAST RAM area for the
+ * moves
+ * Returns the script length in bytes
+ */
+static ULONG BuildChain(UBYTE *script, ULONG phys, ULONG kind, ULONG n, ULONG data_phys)
+{
+	ULONG i, pos = 0;
+
+	for (i = 0; i < n; i++) {
+		switch (kind) {
+		case MICRO_NOP:
+			BuildJumpInst((struct jump_inst *)(script + pos), 0);
+			((struct jump_inst *)(script + pos))->control = 0x00;	// Jump if false - never
+			pos += sizeof(struct jump_inst);
+			break;
+
+		case MICRO_JUMP:
+			BuildJumpInst((struct jump_inst *)(script + pos),
+			              phys + pos + sizeof(struct jump_inst));
+			pos += sizeof(struct jump_inst);
+			break;
+
+		case MICRO_MOVE1:
+		case MICRO_MOVE4:
+		case MICRO_MOVE16:
+			BuildMemMove((struct memmove_inst *)(script + pos), data_phys,
+			             data_phys + 16,
+			             (kind == MICRO_MOVE1) ? 1 : (kind == MICRO_MOVE4) ? 4 : 16);
+			pos += sizeof(struct memmove_inst);
+			break;
+
+		case MICRO_REG_WRITE:
+			BuildRegInst((struct rw_reg_inst *)(script + pos), RW_OP_RMW_MOVE,
+			             RW_REG_SCRATCH0, 0xA5);
+			pos += sizeof(struct rw_reg_inst);
+			break;
+
+		case MICRO_REG_ADD:
+			BuildRegInst((struct rw_reg_inst *)(script + pos), RW_OP_RMW_ADD,
+			             RW_REG_SCRATCH0, 1);
+			pos += sizeof(struct rw_reg_inst);
+			break;
+
+		case MICRO_TO_SFBR:
+			BuildRegInst((struct rw_reg_inst *)(script + pos), RW_OP_TO_SFBR,
+			             RW_REG_SCRATCH0, 0);
+			pos += sizeof(struct rw_reg_inst);
+			break;
+
+		case MICRO_FROM_SFBR:
+			BuildRegInst((struct rw_reg_inst *)(script + pos), RW_OP_SFBR_TO,
+			             RW_REG_SCRATCH0, 0);
+			pos += sizeof(struct rw_reg_inst);
+			break;
+		}
+	}
+
+	BuildIntInst((struct jump_inst *)(script + pos), MICRO_MAGIC);
+
+	return pos + sizeof(struct jump_inst);
+}
+
+/*
+ * Does one byte of SCRATCH hold value and the others 0?
+ * The lane SCRATCH0 appears in depends on how the chip is wired
+ */
+static BOOL ScratchHolds(volatile struct ncr710 *ncr, UBYTE value)
+{
+	ULONG s = ncr->scratch;
+	ULONG i;
+
+	for (i = 0; i < 32; i += 8) {
+		if (s == ((ULONG)value << i))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/*
+ * Time PLACE_LOOPS runs of the script at phys, StatsRuns() times
+ * Register chains start from SCRATCH = 0 on every run and are checked
+ * Returns 0 on success, -1 on failure
+ */
+static LONG TimeChain(volatile struct ncr710 *ncr, ULONG phys, ULONG kind, ULONG n,
+                      struct SampleStats *st)
+{
+	struct EClockVal t0, t1;
+	ULONG run_us[STATS_MAX_REPS];
+	struct SampleSet set;
+	ULONG r, i;
+	LONG status = TEST_SUCCESS;
+
+	StatsBegin(&set, run_us);
+	for (r = 0; r < StatsRuns() && status == TEST_SUCCESS; r++) {
+		WRITE_LONG(ncr, scratch, 0);
+
+		ReadTimer(&t0);
+		for (i = 0; i < PLACE_LOOPS && status == TEST_SUCCESS; i++)
+			status = ExecuteScript(ncr, phys, MICRO_MAGIC, "Micro-op");
+		ReadTimer(&t1);
+		StatsAdd(&set, ElapsedMicros(&t0, &t1));
+
+		// PLACE_LOOPS chains of n increments each
+		if (status == TEST_SUCCESS && n &&
+		    ((kind == MICRO_REG_WRITE && !ScratchHolds(ncr, 0xA5)) ||
+		     (kind == MICRO_REG_ADD && !ScratchHolds(ncr, (UBYTE)(n * PLACE_LOOPS))))) {
+			dbgprintf("ERROR: SCRATCH is 0x%08lx after the %s chain\n",
+			          ncr->scratch, micro_names[kind]);
+			status = TEST_VERIFY_ERROR;
+		}
+	}
+
+	if (status != TEST_SUCCESS)
+		return -1;
+
+	StatsCompute(&set, st);
+	return 0;
+}
+
+/*
+ * Time a chain of each instruction kind and print ns per instruction
+ */
+void TestMicroOps(volatile struct ncr710 *ncr)
+{
+	struct SampleStats base, chain;
+	struct DMASegment seg;
+	UBYTE *script, *data;
+	ULONG phys, data_phys = 0, len, kind, ns, inst_len;
+
+	dbgprintf("\n=== SCRIPTS Micro-op Costs ===\n");
+	dbgprintf("Chains of %ld instructions in %s RAM, %ld scripts per run;\n",
+	          (ULONG)MICRO_CHAIN, ScriptMemName(), (ULONG)PLACE_LOOPS);
+	dbgprintf("the INT-only script is subtracted from each figure\n");
+	PrintStatsConfig();
+	dbgprintf("\n");
+
+	script = AllocScriptMem(MICRO_SCRIPT_SIZE);
+	data = AllocDMAContig(32, MEMF_FAST | MEMF_CLEAR);
+	if (!script || !data) {
+		dbgprintf("ERROR: Could not allocate micro-op buffers\n");
+		goto cleanup;
+	}
+
+	// Moves copy within this area; the CPU never looks at it
+	if (DMAMapRange(data, 32, DMA_DIR_BOTH, &seg, 1) != 1) {
+		dbgprintf("ERROR: Micro-op data area is not contiguous\n");
+		goto cleanup;
+	}
+	data_phys = seg.phys;
+	phys = DMAPhysAddr(script);
+
+	len = BuildChain(script, phys, MICRO_NOP, 0, data_phys);
+	DMACachePre(script, len, DMA_DIR_READ);
+	if (TimeChain(ncr, phys, MICRO_NOP, 0, &base) < 0) {
+		DMACachePost(script, len, DMA_DIR_READ);
+		dbgprintf("ERROR: INT-only script failed\n");
+		goto cleanup;
+	}
+	DMACachePost(script, len, DMA_DIR_READ);
+
+	dbgprintf("  INT-only script: %ld us from DSP write to task wake-up\n\n",
+	          base.median_us / PLACE_LOOPS);
+	dbgprintf("  instruction            bytes  ns/inst   cv\n");
+
+	for (kind = 0; kind < NUM_MICRO_OPS; kind++) {
+		len = BuildChain(script, phys, kind, MICRO_CHAIN, data_phys);
+		inst_len = (len - sizeof(struct jump_inst)) / MICRO_CHAIN;
+
+		DMACachePre(script, len, DMA_DIR_READ);
+		if (TimeChain(ncr, phys, kind, MICRO_CHAIN, &chain) < 0) {
+			DMACachePost(script, len, DMA_DIR_READ);
+			dbgprintf("  %-22s FAILED\n", micro_names[kind]);
+			continue;
+		}
+		DMACachePost(script, len, DMA_DIR_READ);
+
+		ns = (chain.median_us > base.median_us) ?
+		     ((chain.median_us - base.median_us) * 1000) / (PLACE_LOOPS * MICRO_CHAIN) : 0;
+		dbgprintf("  %-22s %5ld  %7ld  %2ld.%01ld%%%s\n", micro_names[kind], inst_len, ns,
+		          chain.cv / 10, chain.cv % 10, chain.noisy ? " ~" : "");
+		dbgflush();
+	}
+
+	dbgprintf("\nA script's run time is roughly the INT-only time plus the sum of\n");
+	dbgprintf("its instructions; memory moves add their data cycles on top.\n");
+
+cleanup:
+	WRITE_LONG(ncr, scratch, 0);
+	if (data_phys)
+		DMACachePost(data, 32, DMA_DIR_BOTH);
+	if (data)
+		FreeDMAContig(data);
+	if (script)
+		FreeScriptMem(script, MICRO_SCRIPT_SIZE);
+
+	dbgprintf("\n=== Micro-op Costs Complete ===\n\n");
+	dbgflush();
+}
@@ -0,0 +1,416 @@
+/*
+ * NCR 53C710 DMA Test Tool - CopyMem()/CopyMemQuick() offload patch
+ *
+ * Every application copying large blocks goes through exec CopyMem() or
+ * CopyMemQuick(). This mode SetFunction()s both and sends copies above a
+ * threshold through the DMA copy library (ncr_dmacopy.c); anything else
+ * falls through to the original routine.
+ *
+ * The DMA path waits on SIGF_SINGLE, so it is only taken from a task that
+ * is not inside Forbid()/Disable() and not from supervisor mode. Both
+ * ranges must be RAM in the system memory list and must not overlap. A
+ * copy falls back to the CPU when the request pool is empty, the ranges
+ * are too fragmented, the DMA fails or the chip misses the library's
+ * deadline, so correctness never depends on the chip.
+ *
+ * Every call into either patch is counted in g_inflight from its first
+ * statement to its last, fallback included. Removal puts the original
+ * vectors back first and only then waits for the count to drain, so no
+ * task can still be inside this code when it is unloaded.
+ *
+ * The thresholds (one for copies touching CHIP RAM, one for FAST-only
+ * copies) are calibrated at start by timing the original routine against
+ * the DMA path, unless one is given on the command line. Calibration also
+ * measures the DMA rate; a copy larger than that rate finishes within
+ * DMACOPY_TIMEOUT_MS stays on the CPU, so the deadline is never the limit.
+ */
+
+#include "ncr_dmacopy.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/execbase.h>
+#include <exec/memory.h>
+#include <dos/dos.h>
+#include <proto/exec.h>
+#include <proto/dos.h>
+
+#define LVO_CopyMem       -624
+#define LVO_CopyMemQuick  -630
+
+#define PATCH_CHIP        0           // Threshold index: either side in CHIP
+#define PATCH_FAST        1           // Threshold index: FAST only
+#define PATCH_NEVER       0xFFFFFFFF  // Threshold when DMA never wins
+
+/* Why a copy stayed on the CPU */
+#define FB_CONTEXT        0           // Supervisor, Forbid() or Disable()
+#define FB_REGION         1           // Not RAM, or overlapping
+#define FB_BUSY           2           // Pool empty or too fragmented
+#define FB_ERROR          3           // DMA failed - redone by the CPU
+#define FB_TIMEOUT        4           // Chip aborted after the deadline - redone by the CPU
+#define FB_LARGE          5           // Above the size the chip finishes by the deadline
+#define FB_COUNT          6
+
+static const char *fallback_names[FB_COUNT] = {
+	"context", "region", "busy", "error", "timeout", "large"
+};
+
+typedef VOID (*CopyMemFunc)(APTR src __asm("a0"), APTR dst __asm("a1"),
+                            ULONG size __asm("d0"), struct ExecBase *sysbase __asm("a6"));
+
+static CopyMemFunc g_old_copymem = NULL;
+static CopyMemFunc g_old_copymemquick = NULL;
+static ULONG g_threshold[2] = { PATCH_NEVER, PATCH_NEVER };
+static ULONG g_max_size[2];	// Largest copy offloaded, per threshold index
+static volatile BOOL g_patch_enabled = FALSE;
+static volatile ULONG g_inflight = 0;
+
+/* Counters - updated with Disable() held, read the same way */
+static ULONG g_hits = 0;
+static ULONG g_misses = 0;
+static ULONG g_fallbacks[FB_COUNT];
+static unsigned long long g_hit_bytes = 0;
+
+/*
+ * Can this copy go through the chip from the calling context?
+ * Returns -1 if yes, otherwise the FB_xxx reason
+ */
+static LONG CheckOffload(APTR src, APTR dst, ULONG size, ULONG cls)
+{
+	UBYTE *s = src, *d = dst;
+
+	if (size > g_max_size[cls])
+		return FB_LARGE;
+
+	// Waiting would break Forbid()/Disable() or is impossible in supervisor mode
+	if ((SetSR(0, 0) & 0x2000) || SysBase->TDNestCnt >= 0 || SysBase->IDNestCnt >= 0)
+		return FB_CONTEXT;
+
+	if (!TypeOfMem(s) || !TypeOfMem(s + size - 1) ||
+	    !TypeOfMem(d) || !TypeOfMem(d + size - 1))
+		return FB_REGION;
+
+	if (s < d + size && d < s + size)
+		return FB_REGION;
+
+	return -1;
+}
+
+/*
+ * Copy through the DMA library, waiting on SIGF_SINGLE
+ * Returns -1 on success, otherwise the FB_xxx reason
+ */
+static LONG DMACopySync(APTR src, APTR dst, ULONG size)
+{
+	struct DMACopyRequest *req;
+	LONG status;
+
+	req = DMACopySubmit(src, dst, size, SIGF_SINGLE);
+	if (!req)
+		return FB_BUSY;
+
+	status = DMACopyWait(req);
+	DMACopyFree(req);
+
+	// Exec semaphores rely on SIGF_SINGLE - leave none behind
+	SetSignal(0, SIGF_SINGLE);
+
+	if (status == DMACOPY_DONE)
+		return -1;
+
+	return (status == DMACOPY_TIMEOUT) ? FB_TIMEOUT : FB_ERROR;
+}
+
+/*
+ * Common body of both patches
+ * Returns TRUE if the copy was done by the chip
+ */
+static BOOL TryOffload(APTR src, APTR dst, ULONG size)
+{
+	ULONG cls;
+	LONG reason;
+
+	if (!g_patch_enabled || size == 0)
+		return FALSE;
+
+	cls = ((TypeOfMem(src) | TypeOfMem(dst)) & MEMF_CHIP) ? PATCH_CHIP : PATCH_FAST;
+	if (size < g_threshold[cls]) {
+		Disable();
+		g_misses++;
+		Enable();
+		return FALSE;
+	}
+
+	reason = CheckOffload(src, dst, size, cls);
+	if (reason < 0)
+		reason = DMACopySync(src, dst, size);
+
+	Disable();
+	if (reason < 0) {
+		g_hits++;
+		g_hit_bytes += size;
+	} else {
+		g_fallbacks[reason]++;
+	}
+	Enable();
+
+	return reason < 0;
+}
+
+/*
+ * Count a task in and out of the patch code
+ */
+static void EnterPatch(void)
+{
+	Disable();
+	g_inflight++;
+	Enable();
+}
+
+static void LeavePatch(void)
+{
+	Disable();
+	g_inflight--;
+	Enable();
+}
+
+static VOID __attribute__((saveds))
+PatchCopyMem(APTR src __asm("a0"), APTR dst __asm("a1"), ULONG size __asm("d0"))
+{
+	EnterPatch();
+	if (!TryOffload(src, dst, size))
+		g_old_copymem(src, dst, size, SysBase);
+	LeavePatch();
+}
+
+static VOID __attribute__((saveds))
+PatchCopyMemQuick(APTR src __asm("a0"), APTR dst __asm("a1"), ULONG size __asm("d0"))
+{
+	EnterPatch();
+	if (!TryOffload(src, dst, size))
+		g_old_copymemquick(src, dst, size, SysBase);
+	LeavePatch();
+}
+
+/*
+ * Smallest size at which the DMA path beats the original CopyMem()
+ * Returns PATCH_NEVER if it never does up to PATCH_CAL_MAX. *max_size
+ * gets the largest copy the DMA rate measured at PATCH_CAL_MAX finishes
+ * within DMACOPY_TIMEOUT_MS.
+ */
+static ULONG CalibrateThreshold(UBYTE *src, UBYTE *dst, const char *name,
+                                ULONG *max_size)
+{
+	struct EClockVal t0, t1;
+	ULONG cpu_runs[STATS_MAX_REPS], dma_runs[STATS_MAX_REPS];
+	struct SampleSet cpu_set, dma_set;
+	struct SampleStats cpu_st, dma_st;
+	ULONG size, iter, run, cpu_us, dma_us, dma_ms;
+	ULONG threshold = PATCH_NEVER;
+
+	dbgprintf("  %s:\n", name);
+
+	for (size = PATCH_CAL_MIN; size <= PATCH_CAL_MAX; size *= 2) {
+		FillPattern(src, size, PATTERN_RANDOM);
+
+		StatsBegin(&cpu_set, cpu_runs);
+		StatsBegin(&dma_set, dma_runs);
+		for (run = 0; run < StatsRuns(); run++) {
+			ReadTimer(&t0);
+			for (iter = 0; iter < PATCH_CAL_ITERATIONS; iter++)
+				g_old_copymem(src, dst, size, SysBase);
+			ReadTimer(&t1);
+			StatsAdd(&cpu_set, ElapsedMicros(&t0, &t1));
+
+			ReadTimer(&t0);
+			for (iter = 0; iter < PATCH_CAL_ITERATIONS; iter++) {
+				if (DMACopySync(src, dst, size) >= 0)
+					break;
+			}
+			ReadTimer(&t1);
+			StatsAdd(&dma_set, ElapsedMicros(&t0, &t1));
+
+			if (iter < PATCH_CAL_ITERATIONS || memcmp(src, dst, size) != 0) {
+				dbgprintf("    %6ld bytes: DMA copy failed - not offloaded\n", size);
+				return PATCH_NEVER;
+			}
+		}
+		StatsCompute(&cpu_set, &cpu_st);
+		StatsCompute(&dma_set, &dma_st);
+		cpu_us = cpu_st.median_us;
+		dma_us = dma_st.median_us;
+
+		dbgprintf("    %6ld bytes: CPU", size);
+		PrintRateStats(size * PATCH_CAL_ITERATIONS, &cpu_st);
+		dbgprintf("  DMA");
+		PrintRateStats(size * PATCH_CAL_ITERATIONS, &dma_st);
+		dbgprintf("\n");
+
+		if (threshold == PATCH_NEVER && dma_us < cpu_us)
+			threshold = size;
+		else if (threshold != PATCH_NEVER && dma_us >= cpu_us)
+			threshold = PATCH_NEVER;	// DMA must win at every larger size too
+	}
+
+	// Bytes per ms at the largest size, times the fixed deadline
+	dma_ms = dma_us / 1000;
+	if (dma_ms == 0)
+		dma_ms = 1;
+	*max_size = (PATCH_CAL_MAX * PATCH_CAL_ITERATIONS / dma_ms) * DMACOPY_TIMEOUT_MS;
+	dbgprintf("    Largest offload: %ld KB\n", *max_size / 1024);
+
+	return threshold;
+}
+
+/*
+ * Calibration buffers - the test buffers are smaller than PATCH_CAL_MAX
+ * A class whose buffers cannot be allocated stays CPU only
+ */
+static void AllocCalibrationBuffers(UBYTE **chip, UBYTE **fast1, UBYTE **fast2)
+{
+	*chip = AllocMem(PATCH_CAL_MAX, MEMF_CHIP);
+	*fast1 = AllocMem(PATCH_CAL_MAX, MEMF_FAST);
+	*fast2 = AllocMem(PATCH_CAL_MAX, MEMF_FAST);
+}
+
+static void FreeCalibrationBuffers(UBYTE *chip, UBYTE *fast1, UBYTE *fast2)
+{
+	if (chip)
+		FreeMem(chip, PATCH_CAL_MAX);
+	if (fast1)
+		FreeMem(fast1, PATCH_CAL_MAX);
+	if (fast2)
+		FreeMem(fast2, PATCH_CAL_MAX);
+}
+
+static void PrintThreshold(const char *name, ULONG threshold, ULONG max_size)
+{
+	if (threshold == PATCH_NEVER)
+		dbgprintf("  %s copies: CPU only\n", name);
+	else
+		dbgprintf("  %s copies: DMA from %ld bytes up to %ld KB\n", name, threshold,
+		          max_size / 1024);
+}
+
+/*
+ * Print hit, miss and fallback counters
+ */
+static void PrintPatchStats(void)
+{
+	ULONG hits, misses, fb[FB_COUNT];
+	unsigned long long bytes;
+	ULONG i;
+
+	Disable();
+	hits = g_hits;
+	misses = g_misses;
+	for (i = 0; i < FB_COUNT; i++)
+		fb[i] = g_fallbacks[i];
+	bytes = g_hit_bytes;
+	Enable();
+
+	dbgprintf("  DMA: %ld copies (%ld KB), below threshold: %ld, fallback:",
+	          hits, (ULONG)(bytes / 1024), misses);
+	for (i = 0; i < FB_COUNT; i++)
+		dbgprintf(" %s %ld", fallback_names[i], fb[i]);
+	dbgprintf("\n");
+	dbgflush();
+}
+
+/*
+ * Patch CopyMem()/CopyMemQuick() until Ctrl-C
+ * threshold 0 = calibrate; the library installs its own interrupt server,
+ * so the caller must have removed the test one
+ */
+void RunCopyMemPatch(volatile struct ncr710 *ncr, ULONG threshold)
+{
+	UBYTE *chip, *fast1, *fast2;
+	ULONG i;
+
+	dbgprintf("\n=== CopyMem/CopyMemQuick DMA Offload ===\n");
+
+	if (DMACopyInit(ncr) < 0)
+		return;
+
+	for (i = 0; i < FB_COUNT; i++)
+		g_fallbacks[i] = 0;
+
+	// Calibration calls the original routine directly
+	g_old_copymem = (CopyMemFunc)SetFunction((struct Library *)SysBase, LVO_CopyMem,
+	                                         (APTR)PatchCopyMem);
+	g_old_copymemquick = (CopyMemFunc)SetFunction((struct Library *)SysBase, LVO_CopyMemQuick,
+	                                              (APTR)PatchCopyMemQuick);
+
+	// Without calibration the library's own rate bounds the size
+	g_max_size[PATCH_CHIP] = DMACOPY_MIN_RATE * DMACOPY_TIMEOUT_MS;
+	g_max_size[PATCH_FAST] = DMACOPY_MIN_RATE * DMACOPY_TIMEOUT_MS;
+
+	if (threshold) {
+		g_threshold[PATCH_CHIP] = threshold;
+		g_threshold[PATCH_FAST] = threshold;
+	} else {
+		AllocCalibrationBuffers(&chip, &fast1, &fast2);
+		dbgprintf("Calibrating up to %ld KB (%ld copies per run, medians compared):\n",
+		          (ULONG)(PATCH_CAL_MAX / 1024), (ULONG)PATCH_CAL_ITERATIONS);
+		PrintStatsConfig();
+		if (chip && fast1)
+			g_threshold[PATCH_CHIP] = CalibrateThreshold(fast1, chip, "FAST->CHIP",
+			                                             &g_max_size[PATCH_CHIP]);
+		if (fast1 && fast2)
+			g_threshold[PATCH_FAST] = CalibrateThreshold(fast1, fast2, "FAST->FAST",
+			                                             &g_max_size[PATCH_FAST]);
+		FreeCalibrationBuffers(chip, fast1, fast2);
+	}
+
+	dbgprintf("\nThresholds:\n");
+	PrintThreshold("CHIP", g_threshold[PATCH_CHIP], g_max_size[PATCH_CHIP]);
+	PrintThreshold("FAST", g_threshold[PATCH_FAST], g_max_size[PATCH_FAST]);
+	dbgprintf("\nPatch active - Ctrl-C prints counters, Ctrl-D removes the patch\n");
+	dbgflush();
+
+	g_patch_enabled = TRUE;
+
+	for (;;) {
+		ULONG sigs = Wait(SIGBREAKF_CTRL_C | SIGBREAKF_CTRL_D);
+
+		PrintPatchStats();
+		if (sigs & SIGBREAKF_CTRL_D)
+			break;
+	}
+
+	// Stop new offloads; calls already inside finish on the chip or the CPU
+	g_patch_enabled = FALSE;
+
+	// Only unhook if nobody has patched over us meanwhile
+	for (;;) {
+		APTR cur, cur_quick;
+
+		Forbid();
+		cur = SetFunction((struct Library *)SysBase, LVO_CopyMem, (APTR)g_old_copymem);
+		cur_quick = SetFunction((struct Library *)SysBase, LVO_CopyMemQuick,
+		                        (APTR)g_old_copymemquick);
+		if (cur == (APTR)PatchCopyMem && cur_quick == (APTR)PatchCopyMemQuick) {
+			Permit();
+			break;
+		}
+		SetFunction((struct Library *)SysBase, LVO_CopyMem, cur);
+		SetFunction((struct Library *)SysBase, LVO_CopyMemQuick, cur_quick);
+		Permit();
+
+		dbgprintf("CopyMem patched by another program - staying in pass-through, retry with Ctrl-D\n");
+		dbgflush();
+		Wait(SIGBREAKF_CTRL_D);
+	}
+
+	// No new caller can reach the patch now - wait for those inside it.
+	// A caller preempted between the vector jump and EnterPatch() has not
+	// been counted yet, so the count must stay at zero over a settle delay.
+	do {
+		while (g_inflight)
+			Delay(2);
+		Delay(PATCH_SETTLE_TICKS);
+	} while (g_inflight);
+
+	dbgprintf("Patch removed\n");
+	PrintPatchStats();
+	DMACopyCleanup();
+}
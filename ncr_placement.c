@@ -0,0 +1,369 @@
+/*
+ * NCR 53C710 DMA Test Tool - SCRIPTS placement
+ *
+ * The 710 fetches every SCRIPTS instruction over the bus, so where a
+ * script lives adds to the latency of every command. This mode runs the
+ * same scripts from CHIP, MB_FAST and CPU_FASTL RAM and from the program
+ * image (ROM in the ROM build): a sled of PLACE_INSTRUCTIONS NOPs for the
+ * fetch alone, and one of 4-byte memory moves for fetch plus a little
+ * data. The time of the INT-only script is subtracted, leaving the time
+ * per instruction.
+ *
+ * PlaceScripts() times the NOP sled once per RAM region at start-up, and
+ * AllocScriptMem() then hands out SCRIPTS and DSA buffers from the
+ * fastest one. Shared by ncr_dmatest and ncr_scsi, so instructions are
+ * written as plain words rather than with the ncr_dmacopy.c builders.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/memory.h>
+#include <proto/exec.h>
+
+/* NOP: JUMP if false with no compare - never taken */
+#define NOP_1    0x80000000, 0x00000000
+#define NOP_4    NOP_1, NOP_1, NOP_1, NOP_1
+#define NOP_16   NOP_4, NOP_4, NOP_4, NOP_4
+#define NOP_64   NOP_16, NOP_16, NOP_16, NOP_16
+#define NOP_256  NOP_64, NOP_64, NOP_64, NOP_64
+
+#define INT_WORD 0x98080000		// INT, interrupt always
+#define MOVE_OP  0xC0000000		// Memory move, length in the low 24 bits
+
+/* Sled in the program image - position independent, so it runs from ROM */
+static const ULONG g_image_sled[] = {
+	NOP_256,
+	INT_WORD, PLACE_MAGIC
+};
+
+/* The sled is written out as NOP_256 - fails to compile if PLACE_INSTRUCTIONS changes */
+typedef char image_sled_size_check[(sizeof(g_image_sled) == (PLACE_INSTRUCTIONS + 1) * 8) ? 1 : -1];
+
+/* RAM a script can be placed in, preferred first when times are equal */
+struct ScriptRegion {
+	const char *name;
+	ULONG start;		// Address range, 0/0 = by attribute
+	ULONG end;
+	ULONG attr;		// MEMF_CHIP or 0
+	ULONG pool;		// POOL_xxx
+};
+
+static const struct ScriptRegion g_script_regions[] = {
+	{ "CPU_FASTL", CPU_FASTL_START, CPU_FASTL_END, 0,         POOL_CPU_FASTL },
+	{ "MB_FAST",   MB_FAST_START,   MB_FAST_END,   0,         POOL_MB_FAST   },
+	{ "CHIP",      0,               0,             MEMF_CHIP, POOL_CHIP      },
+};
+#define NUM_SCRIPT_REGIONS (sizeof(g_script_regions) / sizeof(g_script_regions[0]))
+
+/* Region AllocScriptMem() uses, -1 = any FAST RAM */
+static LONG g_script_region = -1;
+
+/* Figures for one script location */
+struct PlaceResult {
+	struct SampleStats base;	// INT only
+	struct SampleStats nops;	// NOP sled
+	struct SampleStats moves;	// 4-byte move sled
+	BOOL have_moves;
+};
+
+/*
+ * Cleared page-contiguous block in a region, from its pool if it has one
+ */
+static APTR AllocInRegion(const struct ScriptRegion *r, ULONG size)
+{
+	APTR mem = PoolAlloc(r->pool, size);
+
+	if (mem) {
+		memset(mem, 0, size);
+		return mem;
+	}
+
+	if (r->attr)
+		return AllocDMAContig(size, r->attr | MEMF_CLEAR);
+
+	return AllocDMAContigIn(size, r->start, r->end);
+}
+
+/*
+ * Allocate a SCRIPTS or DSA buffer (one page, cleared) in the region
+ * PlaceScripts() chose, or in any FAST RAM if there is none or it is full
+ * Free with FreeScriptMem()
+ */
+APTR AllocScriptMem(ULONG size)
+{
+	APTR mem = NULL;
+
+	if (g_script_region >= 0)
+		mem = AllocInRegion(&g_script_regions[g_script_region], size);
+	if (!mem) {
+		mem = PoolAlloc(POOL_FAST, size);
+		if (mem)
+			memset(mem, 0, size);
+	}
+	if (!mem)
+		mem = AllocDMAContig(size, MEMF_FAST | MEMF_CLEAR);
+
+	return mem;
+}
+
+/*
+ * Free a block from AllocScriptMem(), size as allocated
+ */
+void FreeScriptMem(APTR mem, ULONG size)
+{
+	if (mem && !PoolFree(mem, size))
+		FreeDMAContig(mem);
+}
+
+/*
+ * Name of the region AllocScriptMem() uses
+ */
+const char *ScriptMemName(void)
+{
+	return (g_script_region >= 0) ? g_script_regions[g_script_region].name : "FAST";
+}
+
+/*
+ * Write n NOPs, or n 4-byte moves within the longwords at data_phys if
+ * data_phys is non-zero, then the final INT
+ * Returns the script length in bytes
+ */
+static ULONG BuildSled(ULONG *w, ULONG n, ULONG data_phys)
+{
+	ULONG i, words = 0;
+
+	for (i = 0; i < n; i++) {
+		if (data_phys) {
+			w[words++] = MOVE_OP | 4;
+			w[words++] = data_phys;
+			w[words++] = data_phys + 4;
+		} else {
+			w[words++] = 0x80000000;
+			w[words++] = 0x00000000;
+		}
+	}
+	w[words++] = INT_WORD;
+	w[words++] = PLACE_MAGIC;
+
+	return words * sizeof(ULONG);
+}
+
+/*
+ * Time PLACE_LOOPS runs of a script, StatsRuns() times
+ * Returns 0 on success, -1 on failure; *st gets the run times
+ */
+static LONG TimeScript(volatile struct ncr710 *ncr, ScriptRunner run,
+                       const ULONG *script, ULONG len, struct SampleStats *st)
+{
+	struct DMASegment seg;
+	struct EClockVal t0, t1;
+	ULONG run_us[STATS_MAX_REPS];
+	struct SampleSet set;
+	ULONG r, i;
+	LONG status = 0;
+
+	st->n = 0;
+
+	if (DMAMapRange((APTR)script, len, DMA_DIR_READ, &seg, 1) != 1) {
+		DMACachePost((APTR)script, len, DMA_DIR_READ);
+		return -1;
+	}
+
+	StatsBegin(&set, run_us);
+	for (r = 0; r < StatsRuns() && status == 0; r++) {
+		ReadTimer(&t0);
+		for (i = 0; i < PLACE_LOOPS && status == 0; i++)
+			status = run(ncr, seg.phys, PLACE_MAGIC, "Placement");
+		ReadTimer(&t1);
+		StatsAdd(&set, ElapsedMicros(&t0, &t1));
+	}
+
+	DMACachePost((APTR)script, len, DMA_DIR_READ);
+
+	if (status != 0)
+		return -1;
+
+	StatsCompute(&set, st);
+	return 0;
+}
+
+/*
+ * Nanoseconds per sled instruction, INT-only script subtracted
+ */
+static ULONG NsPerInst(struct SampleStats *sled, struct SampleStats *base)
+{
+	if (sled->median_us <= base->median_us)
+		return 0;
+
+	return ((sled->median_us - base->median_us) * 1000) /
+	       (PLACE_LOOPS * PLACE_INSTRUCTIONS);
+}
+
+/*
+ * Time the INT-only, NOP and (if data_phys) move scripts in a RAM buffer
+ * of PLACE_SCRIPT_SIZE bytes
+ * Returns 0 on success, -1 on failure
+ */
+static LONG MeasureBuffer(volatile struct ncr710 *ncr, ScriptRunner run,
+                          ULONG *buf, ULONG data_phys, struct PlaceResult *res)
+{
+	ULONG len;
+
+	res->have_moves = FALSE;
+
+	len = BuildSled(buf, 0, 0);
+	if (TimeScript(ncr, run, buf, len, &res->base) < 0)
+		return -1;
+
+	len = BuildSled(buf, PLACE_INSTRUCTIONS, 0);
+	if (TimeScript(ncr, run, buf, len, &res->nops) < 0)
+		return -1;
+
+	if (data_phys) {
+		len = BuildSled(buf, PLACE_INSTRUCTIONS, data_phys);
+		if (TimeScript(ncr, run, buf, len, &res->moves) < 0)
+			return -1;
+		res->have_moves = TRUE;
+	}
+
+	return 0;
+}
+
+/*
+ * Fastest region of those ok[], the preferred one on a tie
+ * Returns the index, -1 if none was measured
+ */
+static LONG FastestRegion(ULONG *ns, BOOL *ok)
+{
+	LONG best = -1;
+	ULONG i;
+
+	for (i = 0; i < NUM_SCRIPT_REGIONS; i++) {
+		if (ok[i] && (best < 0 || ns[i] < ns[best]))
+			best = i;
+	}
+
+	return best;
+}
+
+/*
+ * Time the NOP sled in each RAM region and use the fastest for
+ * AllocScriptMem() from now on
+ */
+void PlaceScripts(volatile struct ncr710 *ncr, ScriptRunner run)
+{
+	struct PlaceResult res;
+	ULONG ns[NUM_SCRIPT_REGIONS];
+	BOOL ok[NUM_SCRIPT_REGIONS];
+	ULONG *buf;
+	ULONG i;
+
+	g_script_region = -1;
+
+	dbgprintf("SCRIPTS placement:");
+	for (i = 0; i < NUM_SCRIPT_REGIONS; i++) {
+		ok[i] = FALSE;
+		buf = AllocInRegion(&g_script_regions[i], PLACE_SCRIPT_SIZE);
+		if (!buf)
+			continue;
+
+		if (MeasureBuffer(ncr, run, buf, 0, &res) == 0) {
+			ns[i] = NsPerInst(&res.nops, &res.base);
+			ok[i] = TRUE;
+			dbgprintf(" %s %ld ns/inst", g_script_regions[i].name, ns[i]);
+		}
+		FreeScriptMem(buf, PLACE_SCRIPT_SIZE);
+	}
+
+	g_script_region = FastestRegion(ns, ok);
+	if (g_script_region >= 0)
+		dbgprintf(" -> %s\n", ScriptMemName());
+	else
+		dbgprintf(" probe failed, using FAST RAM\n");
+}
+
+/*
+ * Print one location's figures
+ */
+static void PrintPlaceResult(const char *name, ULONG addr, struct PlaceResult *res)
+{
+	BOOL noisy = res->base.noisy || res->nops.noisy ||
+	             (res->have_moves && res->moves.noisy);
+
+	dbgprintf("  %-9s 0x%08lx %11ld", name, addr, NsPerInst(&res->nops, &res->base));
+	if (res->have_moves)
+		dbgprintf("%14ld", NsPerInst(&res->moves, &res->base));
+	else
+		dbgprintf("%14s", "-");
+	dbgprintf("%13ld%s\n", res->base.median_us / PLACE_LOOPS, noisy ? " ~" : "");
+}
+
+/*
+ * Time the same scripts from every region and the program image
+ */
+void TestScriptPlacement(volatile struct ncr710 *ncr, ScriptRunner run)
+{
+	struct PlaceResult res;
+	struct DMASegment seg;
+	ULONG ns[NUM_SCRIPT_REGIONS];
+	BOOL ok[NUM_SCRIPT_REGIONS];
+	ULONG *buf, *data;
+	ULONG data_phys = 0, i;
+	LONG best;
+	const ULONG *image_int = &g_image_sled[PLACE_INSTRUCTIONS * 2];
+
+	dbgprintf("\n=== SCRIPTS Placement ===\n");
+	dbgprintf("%ld NOPs or 4-byte moves per script, %ld scripts per run;\n",
+	          (ULONG)PLACE_INSTRUCTIONS, (ULONG)PLACE_LOOPS);
+	dbgprintf("the INT-only script is subtracted from each figure\n");
+	PrintStatsConfig();
+	dbgprintf("\n");
+
+	// The moves copy one longword to the next, always in FAST RAM
+	data = AllocDMAContig(16, MEMF_FAST | MEMF_CLEAR);
+	if (data && DMAMapRange(data, 8, DMA_DIR_BOTH, &seg, 1) == 1)
+		data_phys = seg.phys;
+
+	dbgprintf("  location  address     NOP ns/inst  MOVE ns/inst  INT-only us\n");
+	for (i = 0; i < NUM_SCRIPT_REGIONS; i++) {
+		ok[i] = FALSE;
+		buf = AllocInRegion(&g_script_regions[i], PLACE_SCRIPT_SIZE);
+		if (!buf) {
+			dbgprintf("  %-9s not available\n", g_script_regions[i].name);
+			continue;
+		}
+
+		if (MeasureBuffer(ncr, run, buf, data_phys, &res) == 0) {
+			ns[i] = NsPerInst(&res.nops, &res.base);
+			ok[i] = TRUE;
+			PrintPlaceResult(g_script_regions[i].name, DMAPhysAddr(buf), &res);
+		} else {
+			dbgprintf("  %-9s FAILED\n", g_script_regions[i].name);
+		}
+		FreeScriptMem(buf, PLACE_SCRIPT_SIZE);
+		dbgflush();
+	}
+
+	// Read-only, so only the NOP sled
+	res.have_moves = FALSE;
+	if (TimeScript(ncr, run, image_int, 2 * sizeof(ULONG), &res.base) == 0 &&
+	    TimeScript(ncr, run, g_image_sled, sizeof(g_image_sled), &res.nops) == 0)
+		PrintPlaceResult(TypeOfMem((APTR)g_image_sled) ? "image" : "ROM",
+		                 (ULONG)g_image_sled, &res);
+	else
+		dbgprintf("  %-9s FAILED\n",
+		          TypeOfMem((APTR)g_image_sled) ? "image" : "ROM");
+
+	if (data) {
+		if (data_phys)
+			DMACachePost(data, 8, DMA_DIR_BOTH);
+		FreeDMAContig(data);
+	}
+
+	best = FastestRegion(ns, ok);
+	dbgprintf("\nFastest RAM for SCRIPTS: %s (start-up placement chose %s)\n",
+	          (best >= 0) ? g_script_regions[best].name : "none", ScriptMemName());
+	dbgprintf("\n=== SCRIPTS Placement Complete ===\n\n");
+	dbgflush();
+}
@@ -0,0 +1,280 @@
+/*
+ * NCR 53C710 DMA Test Tool - Region-tagged DMA buffer pools
+ *
+ * Test buffers, scatter-gather destinations, SCRIPTS and DSA blocks used
+ * to come from AllocMem()/AllocAbs() one by one, some of them inside
+ * timed loops. PoolInit() instead reserves one arena per memory region
+ * (CHIP, MB_FAST, CPU_FASTL, CPU_FASTU) at start-up. PoolAlloc() hands out
+ * blocks from power-of-two size classes (POOL_MIN_BLOCK up to
+ * POOL_MIN_BLOCK << (POOL_CLASSES - 1)): a freed block goes on its class
+ * list and is reused first, otherwise the block is cut from the top of
+ * the arena. Both are constant time and never call Exec.
+ *
+ * Blocks are aligned to their size up to DMA_PAGE_SIZE (so at least a
+ * 16-byte cache line, as move16 and CachePreDMA() want), which also means
+ * a block of up to a page never crosses one and can be handed to the chip
+ * as a single address. Freed space stays with its class; the arenas go
+ * back to Exec in PoolCleanup().
+ *
+ * Each arena has a class map with one byte per POOL_MIN_BLOCK: the class
+ * (+1) of the block starting there, 0 if none is handed out. PoolFree()
+ * checks the caller's size against it, so a wrong size or a double free
+ * is reported instead of corrupting a free list.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/memory.h>
+#include <proto/exec.h>
+
+/* Free block of a class list */
+struct PoolBlock {
+	struct PoolBlock *next;
+};
+
+/* One region's arena */
+struct DMAPool {
+	const char *name;
+	ULONG start;		// Address range, 0/0 = by attribute
+	ULONG end;
+	ULONG attr;		// MEMF_CHIP or 0
+	UBYTE *raw;		// Exec allocation
+	ULONG raw_size;
+	UBYTE *base;		// Page-aligned arena
+	ULONG size;
+	UBYTE *top;		// Next uncut byte
+	struct PoolBlock *free[POOL_CLASSES];
+	UBYTE *class_map;	// Class + 1 per POOL_MIN_BLOCK, 0 = not handed out
+	ULONG used;		// Bytes handed out now
+	ULONG peak;
+	ULONG allocs;
+	ULONG fails;
+};
+
+static struct DMAPool g_pools[NUM_POOLS] = {
+	{ "CHIP",      0,               0,               MEMF_CHIP },
+	{ "MB_FAST",   MB_FAST_START,   MB_FAST_END,     0         },
+	{ "CPU_FASTL", CPU_FASTL_START, CPU_FASTL_END,   0         },
+	{ "CPU_FASTU", CPU_FASTU_START, CPU_FASTU_END,   0         },
+};
+
+/* POOL_FAST tries these in order */
+static const ULONG g_fast_order[] = { POOL_CPU_FASTL, POOL_MB_FAST, POOL_CPU_FASTU };
+
+/*
+ * Reserve a pool's arena, halving the size down to POOL_MIN_ARENA until
+ * the region can spare it
+ * Returns 0 on success, -1 if the region has no room (or no RAM)
+ */
+static LONG ReserveArena(struct DMAPool *p, ULONG size)
+{
+	for (; size >= POOL_MIN_ARENA; size /= 2) {
+		if (p->attr) {
+			p->raw_size = size + DMA_PAGE_SIZE;
+			p->raw = AllocMem(p->raw_size, p->attr);
+			if (p->raw)
+				p->base = (UBYTE *)(((ULONG)p->raw + DMA_PAGE_SIZE - 1) &
+				                    ~(ULONG)(DMA_PAGE_SIZE - 1));
+		} else {
+			p->raw_size = size;
+			p->raw = ReserveInRange(p->start, p->end, size, DMA_PAGE_SIZE, 0);
+			p->base = p->raw;
+		}
+
+		if (!p->raw)
+			continue;
+
+		p->class_map = AllocMem(size / POOL_MIN_BLOCK, MEMF_ANY | MEMF_CLEAR);
+		if (!p->class_map) {
+			FreeMem(p->raw, p->raw_size);
+			p->raw = p->base = NULL;
+			continue;
+		}
+
+		p->size = size;
+		p->top = p->base;
+		return 0;
+	}
+
+	return -1;
+}
+
+/*
+ * Reserve an arena of arena_size bytes in every region
+ * Returns 0 if at least the CHIP pool exists, -1 otherwise
+ */
+LONG PoolInit(ULONG arena_size)
+{
+	ULONG i;
+
+	dbgprintf("Reserving DMA buffer pools...\n");
+	for (i = 0; i < NUM_POOLS; i++) {
+		struct DMAPool *p = &g_pools[i];
+
+		if (p->raw)
+			continue;
+
+		memset(p->free, 0, sizeof(p->free));
+		p->used = p->peak = p->allocs = p->fails = 0;
+
+		if (ReserveArena(p, arena_size) == 0)
+			dbgprintf("  %-9s %4ld KB at 0x%08lx\n", p->name, p->size / 1024, (ULONG)p->base);
+		else
+			dbgprintf("  %-9s not available\n", p->name);
+	}
+	dbgprintf("\n");
+
+	return g_pools[POOL_CHIP].raw ? 0 : -1;
+}
+
+/*
+ * Give every arena back to Exec - all blocks are gone with them
+ */
+void PoolCleanup(void)
+{
+	ULONG i;
+
+	for (i = 0; i < NUM_POOLS; i++) {
+		struct DMAPool *p = &g_pools[i];
+
+		if (p->raw) {
+			FreeMem(p->raw, p->raw_size);
+			FreeMem(p->class_map, p->size / POOL_MIN_BLOCK);
+		}
+		p->raw = p->base = p->top = p->class_map = NULL;
+		p->size = 0;
+	}
+}
+
+/*
+ * Size class of a request, POOL_CLASSES if it is too large
+ */
+static ULONG PoolClass(ULONG size)
+{
+	ULONG cls = 0;
+
+	while (cls < POOL_CLASSES && ((ULONG)POOL_MIN_BLOCK << cls) < size)
+		cls++;
+
+	return cls;
+}
+
+/*
+ * Take a block from one pool
+ */
+static APTR AllocFromPool(struct DMAPool *p, ULONG cls)
+{
+	ULONG block = (ULONG)POOL_MIN_BLOCK << cls;
+	ULONG align = (block < DMA_PAGE_SIZE) ? block : DMA_PAGE_SIZE;
+	struct PoolBlock *b;
+	ULONG addr;
+
+	if (!p->raw)
+		return NULL;
+
+	b = p->free[cls];
+	if (b) {
+		p->free[cls] = b->next;
+	} else {
+		addr = ((ULONG)p->top + align - 1) & ~(align - 1);
+		if (addr + block > (ULONG)p->base + p->size) {
+			p->fails++;
+			return NULL;
+		}
+		p->top = (UBYTE *)(addr + block);
+		b = (struct PoolBlock *)addr;
+	}
+
+	p->class_map[((UBYTE *)b - p->base) / POOL_MIN_BLOCK] = cls + 1;
+	p->allocs++;
+	p->used += block;
+	if (p->used > p->peak)
+		p->peak = p->used;
+
+	return b;
+}
+
+/*
+ * Allocate size bytes from a region's pool (POOL_xxx), or from the first
+ * FAST pool with room for POOL_FAST. The block is not cleared.
+ * Returns NULL if the pool is missing or full
+ */
+APTR PoolAlloc(ULONG pool, ULONG size)
+{
+	ULONG cls = PoolClass(size);
+	APTR mem = NULL;
+	ULONG i;
+
+	if (cls >= POOL_CLASSES || !size)
+		return NULL;
+
+	if (pool != POOL_FAST)
+		return (pool < NUM_POOLS) ? AllocFromPool(&g_pools[pool], cls) : NULL;
+
+	for (i = 0; i < sizeof(g_fast_order) / sizeof(g_fast_order[0]) && !mem; i++)
+		mem = AllocFromPool(&g_pools[g_fast_order[i]], cls);
+
+	return mem;
+}
+
+/*
+ * Return a block from PoolAlloc(); size as allocated
+ * A block that was not handed out with that size class (wrong size,
+ * double free, pointer into a block) is reported and left alone
+ * Returns FALSE if mem is not pool memory (nothing is done)
+ */
+BOOL PoolFree(APTR mem, ULONG size)
+{
+	ULONG cls = PoolClass(size);
+	struct PoolBlock *b = mem;
+	ULONG i, offset;
+	UBYTE *tag;
+
+	if (!mem)
+		return FALSE;
+
+	for (i = 0; i < NUM_POOLS; i++) {
+		struct DMAPool *p = &g_pools[i];
+
+		if ((UBYTE *)mem < p->base || (UBYTE *)mem >= p->top)
+			continue;
+
+		offset = (UBYTE *)mem - p->base;
+		tag = &p->class_map[offset / POOL_MIN_BLOCK];
+		if ((offset & (POOL_MIN_BLOCK - 1)) || cls >= POOL_CLASSES || *tag != cls + 1) {
+			dbgprintf("ERROR: PoolFree(0x%08lx, %ld): %s block is %s - not freed\n",
+			          (ULONG)mem, size, p->name,
+			          (!(offset & (POOL_MIN_BLOCK - 1)) && *tag) ? "another size" : "not allocated");
+			return TRUE;
+		}
+
+		*tag = 0;
+		b->next = p->free[cls];
+		p->free[cls] = b;
+		p->used -= (ULONG)POOL_MIN_BLOCK << cls;
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/*
+ * Print arena use
+ */
+void PrintPoolStats(void)
+{
+	ULONG i;
+
+	dbgprintf("\n=== DMA Buffer Pools ===\n");
+	for (i = 0; i < NUM_POOLS; i++) {
+		struct DMAPool *p = &g_pools[i];
+
+		if (!p->raw)
+			continue;
+
+		dbgprintf("  %-9s %4ld KB: peak %ld KB in use, %ld KB cut, %ld allocs, %ld refused\n",
+		          p->name, p->size / 1024, p->peak / 1024,
+		          (ULONG)(p->top - p->base) / 1024, p->allocs, p->fails);
+	}
+}
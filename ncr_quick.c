@@ -0,0 +1,313 @@
+/*
+ * NCR 53C710 DMA Test Tool - Failure history and quick sweep
+ *
+ * The full region sweep runs 30 region pairs x 13 sizes x 5 patterns in a
+ * fixed order, so a fault in the last pair only shows after minutes of
+ * passing tests. Cells that failed are remembered in ENV:/ENVARC: and run
+ * first on the next sweep. QuickSweep() runs those cells and then a sparse
+ * sample of the matrix, stopping at the first failure.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <proto/exec.h>
+#include <proto/dos.h>
+#include <dos/var.h>
+
+/* One remembered sweep cell */
+struct HistoryCell {
+	UBYTE src_idx;		// g_test_buffers[] index
+	UBYTE dst_idx;
+	UBYTE size_log2;	// Transfer size 1 << size_log2
+	UBYTE pattern;		// PATTERN_xxx
+	ULONG fails;		// Failed runs, minus passed reruns
+};
+
+static struct HistoryCell g_history[HISTORY_MAX_CELLS];
+static ULONG g_history_count;
+static BOOL g_history_dirty;
+
+/* Sizes sampled per region pair in quick mode (log2) */
+static const UBYTE quick_sizes[] = { 2, 9, 12, 14 };
+#define NUM_QUICK_SIZES (sizeof(quick_sizes) / sizeof(quick_sizes[0]))
+
+static ULONG SizeLog2(ULONG size)
+{
+	ULONG log2 = 0;
+
+	while ((1UL << log2) < size)
+		log2++;
+
+	return log2;
+}
+
+/*
+ * Sort by failure count, most frequent first
+ */
+static void SortHistory(void)
+{
+	struct HistoryCell tmp;
+	ULONG i, j;
+
+	for (i = 1; i < g_history_count; i++) {
+		tmp = g_history[i];
+		for (j = i; j > 0 && g_history[j - 1].fails < tmp.fails; j--)
+			g_history[j] = g_history[j - 1];
+		g_history[j] = tmp;
+	}
+}
+
+/*
+ * Read the failure history from ENV:
+ * Format: "<key>:<fails> ..." with key = src dst size_log2 pattern as
+ * four hex digits
+ */
+void LoadHistory(void)
+{
+	char buf[HISTORY_MAX_CELLS * 12];
+	char *p, *end;
+	ULONG key, fails;
+
+	g_history_count = 0;
+	g_history_dirty = FALSE;
+
+	if (GetVar(HISTORY_ENV_NAME, buf, sizeof(buf), GVF_GLOBAL_ONLY) <= 0)
+		return;
+
+	p = buf;
+	while (g_history_count < HISTORY_MAX_CELLS) {
+		key = strtoul(p, &end, 16);
+		if (end == p || *end != ':')
+			break;
+		p = end + 1;
+		fails = strtoul(p, &end, 10);
+		if (end == p)
+			break;
+		p = end;
+
+		g_history[g_history_count].src_idx = (key >> 12) & 0xF;
+		g_history[g_history_count].dst_idx = (key >> 8) & 0xF;
+		g_history[g_history_count].size_log2 = (key >> 4) & 0xF;
+		g_history[g_history_count].pattern = key & 0xF;
+		g_history[g_history_count].fails = (fails < HISTORY_MAX_FAILS) ? fails : HISTORY_MAX_FAILS;
+
+		// Drop cells that no longer fit this build's sweep
+		if (g_history[g_history_count].src_idx < g_num_test_buffers &&
+		    g_history[g_history_count].dst_idx < g_num_test_buffers &&
+		    (1UL << g_history[g_history_count].size_log2) >= MIN_TEST_SIZE &&
+		    (1UL << g_history[g_history_count].size_log2) <= MAX_TEST_SIZE &&
+		    g_history[g_history_count].pattern < NUM_TEST_PATTERNS && fails)
+			g_history_count++;
+	}
+
+	SortHistory();
+}
+
+/*
+ * Write the failure history to ENV: and ENVARC: if it changed
+ */
+void SaveHistory(void)
+{
+	char buf[HISTORY_MAX_CELLS * 12];
+	char *p = buf;
+	ULONG i;
+
+	if (!g_history_dirty)
+		return;
+
+	SortHistory();
+	buf[0] = '\0';
+	for (i = 0; i < g_history_count; i++) {
+		struct HistoryCell *c = &g_history[i];
+
+		p += sprintf(p, "%s%lx%lx%lx%lx:%ld", i ? " " : "",
+		             (ULONG)c->src_idx, (ULONG)c->dst_idx,
+		             (ULONG)c->size_log2, (ULONG)c->pattern, c->fails);
+	}
+
+	if (!SetVar(HISTORY_ENV_NAME, buf, -1, GVF_GLOBAL_ONLY | GVF_SAVE_VAR))
+		dbgprintf("WARNING: Could not save %s\n", HISTORY_ENV_NAME);
+	g_history_dirty = FALSE;
+}
+
+/*
+ * Count a sweep cell result into the history
+ * A failure adds the cell (replacing the least frequent one when full),
+ * a pass of a remembered cell ages it out
+ */
+void RecordHistory(UBYTE *src_base, UBYTE *dst_base, ULONG size, ULONG pattern,
+                   LONG status)
+{
+	LONG src_idx = FindTestBuffer(src_base);
+	LONG dst_idx = FindTestBuffer(dst_base);
+	ULONG log2 = SizeLog2(size);
+	ULONG i;
+
+	if (src_idx < 0 || dst_idx < 0 || status == TEST_ABORTED)
+		return;
+
+	for (i = 0; i < g_history_count; i++) {
+		struct HistoryCell *c = &g_history[i];
+
+		if (c->src_idx != src_idx || c->dst_idx != dst_idx ||
+		    c->size_log2 != log2 || c->pattern != pattern)
+			continue;
+
+		if (status != TEST_SUCCESS) {
+			if (c->fails < HISTORY_MAX_FAILS)
+				c->fails++;
+		} else if (--c->fails == 0) {
+			g_history[i] = g_history[--g_history_count];
+		}
+		g_history_dirty = TRUE;
+		return;
+	}
+
+	if (status == TEST_SUCCESS)
+		return;
+
+	if (g_history_count < HISTORY_MAX_CELLS) {
+		i = g_history_count++;
+	} else {
+		// Full - the list is sorted, replace the last (least frequent) entry
+		SortHistory();
+		i = HISTORY_MAX_CELLS - 1;
+	}
+
+	g_history[i].src_idx = src_idx;
+	g_history[i].dst_idx = dst_idx;
+	g_history[i].size_log2 = log2;
+	g_history[i].pattern = pattern;
+	g_history[i].fails = 1;
+	g_history_dirty = TRUE;
+}
+
+/*
+ * Run one cell, optionally record it, and print it if it failed
+ * Returns the test status
+ */
+static LONG RunCell(volatile struct ncr710 *ncr, ULONG src_idx, ULONG dst_idx,
+                    ULONG size, ULONG pattern, ULONG test_num, BOOL record)
+{
+	UBYTE *src = *g_test_buffers[src_idx].buf;
+	UBYTE *dst = *g_test_buffers[dst_idx].buf;
+	struct TestResult result;
+	LONG status;
+
+	status = RunSweepCell(ncr, src, dst, size, pattern, test_num, &result);
+	if (record)
+		RecordHistory(src, dst, size, pattern, status);
+
+	if (status != TEST_SUCCESS) {
+		dbgprintf("*** %s(%ld) -> %s(%ld) ***", g_test_buffers[src_idx].name, src_idx,
+		          g_test_buffers[dst_idx].name, dst_idx);
+		PrintTestResults(&result);
+		dbgprintf("\n");
+	}
+
+	return status;
+}
+
+/*
+ * Rerun the remembered cells, most frequent failure first
+ * In quick mode the results are recorded and the first failure ends the
+ * run; otherwise the full sweep that follows records them
+ * Returns number of cells that failed again
+ */
+ULONG RunHistoryCells(volatile struct ncr710 *ncr, BOOL quick)
+{
+	struct HistoryCell cells[HISTORY_MAX_CELLS];
+	ULONG count = g_history_count;
+	ULONG i, failed = 0;
+	LONG status;
+
+	if (!count)
+		return 0;
+
+	// RunCell() reorders g_history - work from a copy
+	CopyMem(g_history, cells, count * sizeof(cells[0]));
+
+	dbgprintf("Rechecking %ld cells that failed on earlier runs\n", count);
+
+	for (i = 0; i < count; i++) {
+		struct HistoryCell *c = &cells[i];
+
+		if (!*g_test_buffers[c->src_idx].buf || !*g_test_buffers[c->dst_idx].buf)
+			continue;
+		status = RunCell(ncr, c->src_idx, c->dst_idx, 1UL << c->size_log2,
+		                 c->pattern, i + 1, quick);
+		if (status == TEST_SUCCESS)
+			continue;
+		if (status == TEST_ABORTED)
+			break;	// The user stopped it - not a failure
+
+		failed++;
+		if (quick)
+			break;
+	}
+
+	dbgprintf("  %ld of %ld failed again\n", failed, count);
+	dbgflush();
+
+	return failed;
+}
+
+/*
+ * Quick sweep: history cells, then a sparse sample of every region pair
+ * Each pair gets NUM_QUICK_SIZES sizes with the pattern rotating across
+ * pairs, so all patterns are covered at every size. Stops at the first
+ * failure.
+ */
+void QuickSweep(volatile struct ncr710 *ncr)
+{
+	struct EClockVal t0, t1;
+	ULONG src_idx, dst_idx, s, pair = 0;
+	ULONG cells = 0, failed;
+	LONG status;
+
+	dbgprintf("\n=== Quick DMA Sweep ===\n");
+	ReadTimer(&t0);
+
+	LoadHistory();
+	failed = RunHistoryCells(ncr, TRUE);
+
+	for (src_idx = 0; !failed && !g_user_abort && src_idx < (ULONG)g_num_test_buffers; src_idx++) {
+		for (dst_idx = 0; !failed && !g_user_abort && dst_idx < (ULONG)g_num_test_buffers; dst_idx++) {
+			if (src_idx == dst_idx)
+				continue;
+			if (!*g_test_buffers[src_idx].buf || !*g_test_buffers[dst_idx].buf)
+				continue;
+
+			for (s = 0; s < NUM_QUICK_SIZES; s++) {
+				cells++;
+				status = RunCell(ncr, src_idx, dst_idx, 1UL << quick_sizes[s],
+				                 (pair + s) % NUM_TEST_PATTERNS, cells, TRUE);
+				if (status == TEST_ABORTED)
+					break;
+				if (status != TEST_SUCCESS) {
+					failed++;
+					break;
+				}
+			}
+			pair++;
+		}
+	}
+
+	ReadTimer(&t1);
+	SaveHistory();
+
+	if (g_user_abort) {
+		dbgprintf("\n=== Quick Sweep: STOPPED by user after %ld ms ===\n\n",
+		          ElapsedMicros(&t0, &t1) / 1000);
+	} else if (failed) {
+		dbgprintf("\n=== Quick Sweep: FAULT FOUND after %ld ms ===\n",
+		          ElapsedMicros(&t0, &t1) / 1000);
+		dbgprintf("Run without 'quick' for the full sweep and a bisected reproducer\n\n");
+	} else {
+		dbgprintf("\n=== Quick Sweep: PASSED %ld sampled cells in %ld ms ===\n",
+		          cells, ElapsedMicros(&t0, &t1) / 1000);
+		dbgprintf("This is a sample - run without 'quick' for the full sweep\n\n");
+	}
+	dbgflush();
+}
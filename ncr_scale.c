@@ -0,0 +1,278 @@
+/*
+ * NCR 53C710 DMA Test Tool - Large-transfer scaling sweep
+ *
+ * The region sweep stops at MAX_TEST_SIZE (16 KB), but one memory move
+ * carries up to 16 MB - 1 and disk transfers are 256 KB - 1 MB. This mode
+ * takes the largest free block of each region (leaving SCALE_RESERVE for
+ * the system), uses its lower half as source and upper half as
+ * destination, and times transfers from 16 KB up to the largest size the
+ * pair allows. For each pair it reports where throughput plateaus and
+ * whether it falls off again at larger sizes (refresh, DRAM page or MMU
+ * page effects).
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/memory.h>
+#include <exec/execbase.h>
+#include <proto/exec.h>
+
+#define MAX_SCALE_SIZES 16
+
+/* One region's big buffer */
+struct ScaleRegion {
+	const char *name;
+	ULONG start;		// Address range, 0/0 = by attribute
+	ULONG end;
+	ULONG attr;		// MEMF_CHIP or 0
+	UBYTE *buf;
+	ULONG size;		// Allocated bytes
+	ULONG half;		// Usable bytes per half
+};
+
+static struct ScaleRegion g_scale_regions[] = {
+	{ "CHIP",      0,               0,             MEMF_CHIP, NULL, 0, 0 },
+	{ "MB_FAST",   MB_FAST_START,   MB_FAST_END,   0,         NULL, 0, 0 },
+	{ "CPU_FASTL", CPU_FASTL_START, CPU_FASTL_END, 0,         NULL, 0, 0 },
+};
+#define NUM_SCALE_REGIONS (sizeof(g_scale_regions) / sizeof(g_scale_regions[0]))
+
+/*
+ * Find the largest free chunk of a region in the memory list
+ * Returns its size, *addr its address
+ */
+static ULONG LargestFreeChunk(struct ScaleRegion *r, ULONG *addr)
+{
+	struct MemHeader *mh;
+	struct MemChunk *mc;
+	ULONG best = 0;
+
+	Forbid();
+	for (mh = (struct MemHeader *)SysBase->MemList.lh_Head; mh->mh_Node.ln_Succ;
+	     mh = (struct MemHeader *)mh->mh_Node.ln_Succ) {
+		if (r->attr) {
+			if (!(mh->mh_Attributes & r->attr))
+				continue;
+		} else if ((ULONG)mh->mh_Lower < r->start || (ULONG)mh->mh_Lower > r->end) {
+			continue;
+		}
+
+		for (mc = mh->mh_First; mc; mc = mc->mc_Next) {
+			if (mc->mc_Bytes > best) {
+				best = mc->mc_Bytes;
+				*addr = (ULONG)mc;
+			}
+		}
+	}
+	Permit();
+
+	return best;
+}
+
+/*
+ * Allocate the largest page-aligned block the region can spare
+ * Returns 0 on success, -1 if nothing useful was free
+ */
+static LONG AllocScaleRegion(struct ScaleRegion *r)
+{
+	ULONG chunk, addr = 0, aligned, size;
+
+	chunk = LargestFreeChunk(r, &addr);
+	if (chunk < SCALE_RESERVE + 2 * SCALE_MIN_SIZE + DMA_PAGE_SIZE)
+		return -1;
+
+	aligned = (addr + DMA_PAGE_SIZE - 1) & ~(DMA_PAGE_SIZE - 1);
+	size = (chunk - (aligned - addr) - SCALE_RESERVE) & ~(DMA_PAGE_SIZE - 1);
+	if (size > 2 * SCALE_MAX_SIZE)
+		size = 2 * SCALE_MAX_SIZE;
+
+	// Someone may have taken part of it since we looked - shrink and retry
+	while (size >= 2 * SCALE_MIN_SIZE) {
+		r->buf = AllocAbs(size, (APTR)aligned);
+		if (r->buf) {
+			r->size = size;
+			r->half = size / 2;
+			return 0;
+		}
+		size /= 2;
+	}
+
+	return -1;
+}
+
+static void FreeScaleRegions(void)
+{
+	ULONG i;
+
+	for (i = 0; i < NUM_SCALE_REGIONS; i++) {
+		if (g_scale_regions[i].buf)
+			FreeMem(g_scale_regions[i].buf, g_scale_regions[i].size);
+		g_scale_regions[i].buf = NULL;
+		g_scale_regions[i].size = 0;
+	}
+}
+
+/*
+ * Time one transfer size between two regions, StatsRuns() runs
+ * Returns median MB/s in hundredths, 0 on failure; *moves gets the number
+ * of memory moves the script needs (1 if both ranges are contiguous),
+ * *st the run statistics and *run_bytes the bytes moved per run
+ */
+static ULONG TimeScaleSize(volatile struct ncr710 *ncr, UBYTE *src, UBYTE *dst,
+                           ULONG size, ULONG *moves, struct SampleStats *st,
+                           ULONG *run_bytes)
+{
+	struct DMASegment src_segs[MAX_DMA_SEGMENTS], dst_segs[MAX_DMA_SEGMENTS];
+	struct EClockVal t0, t1;
+	struct TestResult result;
+	ULONG run_us[STATS_MAX_REPS];
+	struct SampleSet set;
+	ULONG nsrc, ndst, iter, i, run;
+
+	st->n = 0;
+
+	nsrc = DMATranslateRange(src, size, src_segs, MAX_DMA_SEGMENTS);
+	ndst = DMATranslateRange(dst, size, dst_segs, MAX_DMA_SEGMENTS);
+	*moves = (nsrc && ndst) ? ((nsrc > ndst) ? nsrc : ndst) : 0;
+	if (!*moves)
+		return 0;
+
+	iter = SCALE_BYTES / size;
+	if (iter < SCALE_MIN_ITERATIONS)
+		iter = SCALE_MIN_ITERATIONS;
+
+	StatsBegin(&set, run_us);
+	for (run = 0; run < StatsRuns(); run++) {
+		ReadTimer(&t0);
+		for (i = 0; i < iter; i++) {
+			if (RunDMATest(ncr, src, dst, size) != TEST_SUCCESS)
+				return 0;
+		}
+		ReadTimer(&t1);
+		StatsAdd(&set, ElapsedMicros(&t0, &t1));
+	}
+
+	if (VerifyBuffer(src, dst, size, &result) != TEST_SUCCESS) {
+		dbgprintf("  FAILED %ld bytes: offset 0x%lx expected 0x%02lx got 0x%02lx\n",
+		          size, result.error_offset, result.expected_value, result.actual_value);
+		return 0;
+	}
+
+	// Overwritten by the next size, so a skipped transfer cannot pass
+	memset(dst, 0, size);
+
+	StatsCompute(&set, st);
+	*run_bytes = size * iter;
+
+	return StatsRate(size * iter, st);
+}
+
+/*
+ * Sweep one region pair and report plateau and fall-off
+ */
+static void ScalePair(volatile struct ncr710 *ncr, struct ScaleRegion *s,
+                      struct ScaleRegion *d)
+{
+	ULONG sizes[MAX_SCALE_SIZES], rates[MAX_SCALE_SIZES];
+	ULONG n = 0, i, size, max, moves, run_bytes = 0, peak = 0, plateau = 0;
+	struct SampleStats st;
+	ULONG worst = 0, worst_size = 0;
+	UBYTE *src = s->buf;
+	UBYTE *dst = d->buf + d->half;
+
+	max = (s->half < d->half) ? s->half : d->half;
+	if (max > SCALE_MAX_SIZE)
+		max = SCALE_MAX_SIZE;
+
+	dbgprintf("\n%s -> %s (up to %ld KB)\n", s->name, d->name, max / 1024);
+	dbgprintf("      size | moves |     min/median/p99 MB/s   cv\n");
+
+	SeedRandom(0x5CA1E000);
+	FillPattern(src, max, PATTERN_RANDOM);
+	memset(dst, 0, max);
+
+	// Powers of two from SCALE_MIN_SIZE, then the largest size itself
+	for (size = SCALE_MIN_SIZE; n < MAX_SCALE_SIZES; size *= 2) {
+		if (size > max)
+			size = max;
+
+		rates[n] = TimeScaleSize(ncr, src, dst, size, &moves, &st, &run_bytes);
+		sizes[n] = size;
+		dbgprintf("  %8ld | %5ld |", size, moves);
+		PrintRateStats(run_bytes, &st);
+		dbgprintf("\n");
+		dbgflush();
+
+		if (rates[n] > peak)
+			peak = rates[n];
+		n++;
+
+		if (size == max)
+			break;
+	}
+
+	if (!peak) {
+		dbgprintf("  No transfer completed\n");
+		return;
+	}
+
+	// Plateau: first size within SCALE_PLATEAU_PCT of the peak
+	for (i = 0; i < n; i++) {
+		if (rates[i] * 100 >= peak * SCALE_PLATEAU_PCT) {
+			plateau = i;
+			break;
+		}
+	}
+
+	// Fall-off: worst size after the plateau
+	for (i = plateau + 1; i < n; i++) {
+		if (!worst_size || rates[i] < worst) {
+			worst = rates[i];
+			worst_size = sizes[i];
+		}
+	}
+
+	dbgprintf("  Peak median %ld.%02ld MB/s, within %ld%% from %ld bytes",
+	          peak / 100, peak % 100, (ULONG)SCALE_PLATEAU_PCT, sizes[plateau]);
+	if (worst_size && worst * 100 < peak * SCALE_PLATEAU_PCT)
+		dbgprintf(", falls to %ld%% at %ld bytes\n", (worst * 100) / peak, worst_size);
+	else
+		dbgprintf(", holds up to %ld bytes\n", sizes[n - 1]);
+}
+
+/*
+ * Sweep every region pair from SCALE_MIN_SIZE to the largest size
+ */
+void TestLargeTransfers(volatile struct ncr710 *ncr)
+{
+	ULONG s, d;
+
+	dbgprintf("\n=== Large-Transfer Scaling ===\n");
+	dbgprintf("Largest free block per region, %ld KB left for the system\n",
+	          (ULONG)SCALE_RESERVE / 1024);
+	PrintStatsConfig();
+	dbgprintf("\n");
+
+	for (s = 0; s < NUM_SCALE_REGIONS; s++) {
+		struct ScaleRegion *r = &g_scale_regions[s];
+
+		if (AllocScaleRegion(r) == 0)
+			dbgprintf("  %-9s %6ld KB at 0x%08lx\n", r->name, r->size / 1024, (ULONG)r->buf);
+		else
+			dbgprintf("  %-9s not available\n", r->name);
+	}
+	dbgflush();
+
+	for (s = 0; s < NUM_SCALE_REGIONS; s++) {
+		for (d = 0; d < NUM_SCALE_REGIONS; d++) {
+			if (g_scale_regions[s].buf && g_scale_regions[d].buf)
+				ScalePair(ncr, &g_scale_regions[s], &g_scale_regions[d]);
+		}
+	}
+
+	FreeScaleRegions();
+
+	dbgprintf("\n=== Large-Transfer Scaling Complete ===\n\n");
+	dbgflush();
+}
@@ -6,6 +6,7 @@
 #include "ncr_scsi.h"
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 #include <exec/execbase.h>
 #include <proto/exec.h>
 #include <proto/dos.h>
@@ -69,36 +70,46 @@ FillRandomData(UBYTE *buffer, ULONG size)
 
 /*
  * Verify buffer against pseudo-random pattern
- * Returns 0 on success, offset+1 on mismatch
+ * The expected stream is regenerated a chunk at a time and the whole
+ * buffer is mapped (ncr_errmap.c), not just the first bad byte
+ * Returns 0 on success, offset+1 of the first mismatch
  */
+#define VERIFY_CHUNK_SIZE	4096
+
 static LONG
 VerifyRandomData(UBYTE *buffer, ULONG size, ULONG *error_offset)
 {
-	ULONG i;
-	ULONG random_val;
-	UBYTE expected;
-
-	for (i = 0; i < size; i++) {
-		if ((i & 3) == 0) {
-			random_val = GetRandom();
-		}
-		expected = (random_val >> ((i & 3) * 8)) & 0xFF;
-
-		if (buffer[i] != expected) {
-			*error_offset = i;
-			dbgprintf("ERROR: Mismatch at offset 0x%08lx\n", i);
-			dbgprintf("  Expected: 0x%02lx\n", (ULONG)expected);
-			dbgprintf("  Got:      0x%02lx\n", (ULONG)buffer[i]);
-			return i + 1;  // Return offset+1 (0 = success)
-		}
+	static ULONG expected[VERIFY_CHUNK_SIZE / sizeof(ULONG)];
+	struct ErrorMap map;
+	ULONG offset, len;
+
+	ErrorMapInit(&map, size);
+
+	for (offset = 0; offset < size; offset += len) {
+		len = size - offset;
+		if (len > VERIFY_CHUNK_SIZE)
+			len = VERIFY_CHUNK_SIZE;
+		FillRandomData((UBYTE *)expected, len);
+		ErrorMapAdd(&map, offset, (UBYTE *)expected, buffer + offset, len);
 	}
 
-	return 0;  // Success
+	if (map.first_bad == ERRMAP_NONE)
+		return 0;  // Success
+
+	*error_offset = map.first_bad;
+	dbgprintf("ERROR: Mismatch at offset 0x%08lx\n", map.first_bad);
+	dbgprintf("  Expected: 0x%02lx\n", (ULONG)map.first_expected);
+	dbgprintf("  Got:      0x%02lx\n", (ULONG)map.first_actual);
+	PrintErrorMap(&map);
+
+	return map.first_bad + 1;  // Return offset+1 (0 = success)
 }
 
-/* SCRIPTS program for INQUIRY command */
+/* SCRIPTS program for INQUIRY and READ(10) commands */
 /* Based on ROM driver's SCRIPTS (script.c) with correct instruction encoding */
-static ULONG inquiry_script[] = {
+/* BuildCommandScript() inserts one DATA_IN move per data segment between */
+/* the head and tail so a physically discontiguous buffer is one transfer */
+static const ULONG script_head[] = {
 	// Entry point - start selection
 	// SELECT with ATN, table indirect addressing (opcode 0x47 from ROM)
 	// Address is offset to select_data (offset 20 = 0x14)
@@ -108,14 +119,12 @@ static ULONG inquiry_script[] = {
 	// Address is offset to send_msg (offset 40 = 0x28)
 	0x1E000000, 0x00000028,		// MOVE FROM send_msg, WHEN MSG_OUT
 
-	// Send INQUIRY command (opcode 0x1A = COMMAND phase)
+	// Send command (opcode 0x1A = COMMAND phase)
 	// Address is offset to command_data (offset 48 = 0x30)
 	0x1A000000, 0x00000030,		// MOVE FROM command_data, WHEN COMMAND
+};
 
-	// Receive INQUIRY data (opcode 0x19 = DATA_IN phase)
-	// Address is offset to move_data (offset 0 = 0x00)
-	0x19000000, 0x00000000,		// MOVE FROM move_data, WHEN DATA_IN
-
+static const ULONG script_tail[] = {
 	// Get status byte (opcode 0x1B = STATUS phase)
 	// Address is offset to status_data (offset 24 = 0x18)
 	0x1B000000, 0x00000018,		// MOVE FROM status_data, WHEN STATUS
@@ -135,6 +144,152 @@ static ULONG inquiry_script[] = {
 	0x98080000, 0xBADBAD00,		// INT 0xBADBAD00 (failed label)
 };
 
+#define SCRIPT_HEAD_WORDS (sizeof(script_head) / sizeof(script_head[0]))
+#define SCRIPT_TAIL_WORDS (sizeof(script_tail) / sizeof(script_tail[0]))
+
+/*
+ * Build the command script for nseg data segments
+ * Receive data (opcode 0x19 = DATA_IN phase) from data_sg[0..nseg-1]
+ */
+static void
+BuildCommandScript(ULONG *script, ULONG nseg)
+{
+	ULONG i, w = 0;
+
+	for (i = 0; i < SCRIPT_HEAD_WORDS; i++)
+		script[w++] = script_head[i];
+
+	for (i = 0; i < nseg; i++) {
+		script[w++] = 0x19000000;	// MOVE FROM data_sg[i], WHEN DATA_IN
+		script[w++] = offsetof(struct DSA_entry, data_sg) +
+		              i * sizeof(struct move_data);
+	}
+
+	for (i = 0; i < SCRIPT_TAIL_WORDS; i++)
+		script[w++] = script_tail[i];
+}
+
+/*
+ * Map a command's data buffer into physical segments
+ * Returns number of segments, 0 if it needs more than SCSI_MAX_SG
+ */
+static ULONG
+MapCommandData(UBYTE *data, ULONG len, struct DMASegment *segs)
+{
+	ULONG nseg;
+
+	nseg = DMAMapRange(data, len, DMA_DIR_WRITE, segs, SCSI_MAX_SG);
+	if (!nseg)
+		dbgprintf("ERROR: Data buffer spans more than %ld physical segments\n",
+		          (ULONG)SCSI_MAX_SG);
+
+	return nseg;
+}
+
+/*
+ * Fill the DSA fields common to every command
+ * All addresses the chip sees are physical - dsa_phys is the DSA's own
+ */
+static void
+BuildCommonDSA(struct DSA_entry *dsa, ULONG dsa_phys, UBYTE target_id,
+               struct DMASegment *segs, ULONG nseg)
+{
+	ULONG i;
+
+	// Clear entire DSA
+	memset(dsa, 0, sizeof(struct DSA_entry));
+
+	// Setup data moves - move_data keeps the first segment as before
+	for (i = 0; i < nseg; i++) {
+		dsa->data_sg[i].len  = segs[i].len;
+		dsa->data_sg[i].addr = segs[i].phys;
+	}
+	dsa->move_data = dsa->data_sg[0];
+
+	// Setup selection data (ID and sync value)
+	dsa->select_data.res1 = 0;
+	dsa->select_data.id   = (1 << target_id);  // Bitmask for target
+	dsa->select_data.sync = 0;		   // Async transfer
+	dsa->select_data.res2 = 0;
+
+	// Setup status byte location
+	dsa->status_data.len  = 1;
+	dsa->status_data.addr = dsa_phys + offsetof(struct DSA_entry, status_buf);
+
+	// Setup message in location
+	dsa->recv_msg.len  = 1;
+	dsa->recv_msg.addr = dsa_phys + offsetof(struct DSA_entry, recv_buf);
+
+	// Setup message out (IDENTIFY + LUN)
+	dsa->send_msg.len  = 1;
+	dsa->send_msg.addr = dsa_phys + offsetof(struct DSA_entry, send_buf);
+	dsa->send_buf[0] = MSG_IDENTIFY;  // IDENTIFY message, LUN 0
+
+	// Command follows the message in send_buf
+	dsa->command_data.addr = dsa_phys + offsetof(struct DSA_entry, send_buf) + 1;
+}
+
+/*
+ * Build the command script, push the block to RAM and start it
+ * DSA and DSP are loaded with physical addresses
+ */
+static void
+StartCommand(volatile struct ncr710 *ncr, struct SCSICmdBlock *blk,
+             ULONG blk_phys, ULONG nseg)
+{
+	BuildCommandScript(blk->script, nseg);
+
+	// Cache maintenance for script and DSA (like ROM driver's CachePreDMA)
+	DMACachePre(blk, sizeof(struct SCSICmdBlock), DMA_DIR_BOTH);
+
+	// Load DSA register with our DSA address (like ROM driver)
+	WRITE_LONG(ncr, dsa, blk_phys + offsetof(struct SCSICmdBlock, dsa));
+
+	// Clear any pending interrupts
+	(void)ncr->istat;
+	(void)ncr->dstat;
+	(void)ncr->sstat0;
+
+	// Clear interrupt received flag
+	g_int_state.int_received = 0;
+
+	// Start SCRIPTS execution (load DSP)
+	WRITE_LONG(ncr, dsp, blk_phys + offsetof(struct SCSICmdBlock, script));
+}
+
+/*
+ * Run a script that ends in INT magic and wait for it
+ * Used by PlaceScripts() to time instruction fetch
+ * Returns 0 on success, -1 on failure
+ */
+LONG
+RunProbeScript(volatile struct ncr710 *ncr, ULONG script_phys, ULONG magic,
+               const char *context)
+{
+	ULONG sigs;
+
+	// Clear any pending interrupts
+	(void)ncr->istat;
+	(void)ncr->dstat;
+	(void)ncr->sstat0;
+
+	g_int_state.int_received = 0;
+	WRITE_LONG(ncr, dsp, script_phys);
+
+	sigs = Wait(g_int_state.signal_mask | SIGBREAKF_CTRL_C);
+	if (sigs & SIGBREAKF_CTRL_C)
+		return -1;
+
+	if (!g_int_state.int_received || !(g_int_state.istat & ISTATF_DIP) ||
+	    !(g_int_state.dstat & DSTATF_SIR) || g_int_state.dsps != magic) {
+		dbgprintf("ERROR: %s script did not complete (DSTAT=0x%02lx DSPS=0x%08lx)\n",
+		          context, (ULONG)g_int_state.dstat, g_int_state.dsps);
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * NCR 53C710 Interrupt Handler
  * Called when the NCR chip generates an interrupt
@@ -323,37 +478,14 @@ InitNCRForSCSI(volatile struct ncr710 *ncr)
  * Based on ROM driver's DSA setup
  */
 static void
-BuildInquiryDSA(struct DSA_entry *dsa, UBYTE target_id, UBYTE *data_buf)
+BuildInquiryDSA(struct DSA_entry *dsa, ULONG dsa_phys, UBYTE target_id,
+                struct DMASegment *segs, ULONG nseg)
 {
-	// Clear entire DSA
-	memset(dsa, 0, sizeof(struct DSA_entry));
-
-	// Setup data move (36 bytes of INQUIRY data)
-	dsa->move_data.len  = 36;		// INQUIRY returns 36 bytes
-	dsa->move_data.addr = (ULONG)data_buf;
-
-	// Setup selection data (ID and sync value)
-	dsa->select_data.res1 = 0;
-	dsa->select_data.id   = (1 << target_id);  // Bitmask for target
-	dsa->select_data.sync = 0;		   // Async transfer
-	dsa->select_data.res2 = 0;
-
-	// Setup status byte location
-	dsa->status_data.len  = 1;
-	dsa->status_data.addr = (ULONG)&(dsa->status_buf[0]);
-
-	// Setup message in location
-	dsa->recv_msg.len  = 1;
-	dsa->recv_msg.addr = (ULONG)&(dsa->recv_buf[0]);
-
-	// Setup message out (IDENTIFY + LUN)
-	dsa->send_msg.len  = 1;
-	dsa->send_msg.addr = (ULONG)&(dsa->send_buf[0]);
-	dsa->send_buf[0] = MSG_IDENTIFY;  // IDENTIFY message, LUN 0
+	// Data moves (36 bytes of INQUIRY data), selection, status and message
+	BuildCommonDSA(dsa, dsa_phys, target_id, segs, nseg);
 
 	// Setup INQUIRY command (6 bytes)
 	dsa->command_data.len  = 6;
-	dsa->command_data.addr = (ULONG)&(dsa->send_buf[1]);
 	dsa->send_buf[1] = S_INQUIRY;	// INQUIRY opcode
 	dsa->send_buf[2] = 0x00;	// LUN = 0
 	dsa->send_buf[3] = 0x00;	// Page code = 0
@@ -369,48 +501,53 @@ BuildInquiryDSA(struct DSA_entry *dsa, UBYTE target_id, UBYTE *data_buf)
 LONG
 DoInquiry(volatile struct ncr710 *ncr, UBYTE target_id, struct InquiryData *data)
 {
+	struct SCSICmdBlock *blk;
 	struct DSA_entry *dsa;
+	struct DMASegment segs[SCSI_MAX_SG];
+	ULONG blk_phys, nseg;
 	UBYTE istat, dstat;
 	LONG result = -1;
 
 	dbgprintf("\n=== SCSI INQUIRY Command ===\n");
 	dbgprintf("Target ID: %ld\n", (ULONG)target_id);
 
-	// Allocate DSA in FAST memory (like ROM driver)
-	dsa = AllocMem(sizeof(struct DSA_entry), MEMF_FAST | MEMF_CLEAR);
-	if (!dsa) {
+	// Allocate DSA and script where PlaceScripts() found fetches fastest
+	blk = AllocScriptMem(sizeof(struct SCSICmdBlock));
+	if (!blk) {
 		dbgprintf("ERROR: Could not allocate DSA\n");
 		return -1;
 	}
-
-	dbgprintf("DSA allocated at: 0x%08lx\n", (ULONG)dsa);
+	dsa = &blk->dsa;
+	blk_phys = DMAPhysAddr(blk);
+
+	dbgprintf("DSA allocated at: 0x%08lx (phys 0x%08lx)\n", (ULONG)dsa, blk_phys);
+
+	// Cache maintenance and physical translation for the data buffer
+	DMACacheClear();
+	nseg = MapCommandData((UBYTE *)data, 36, segs);
+	if (!nseg) {
+		DMACachePost(data, 36, DMA_DIR_WRITE);
+		FreeScriptMem(blk, sizeof(struct SCSICmdBlock));
+		return -7;
+	}
 
 	// Build DSA for INQUIRY
-	BuildInquiryDSA(dsa, target_id, (UBYTE *)data);
-
-	// Flush caches (like ROM driver does with CachePreDMA)
-	CacheClearU();
-
-	// Load DSA register with our DSA address (like ROM driver)
-	WRITE_LONG(ncr, dsa, (ULONG)dsa);
-
-	// Clear any pending interrupts
-	(void)ncr->istat;
-	(void)ncr->dstat;
-	(void)ncr->sstat0;
+	BuildInquiryDSA(dsa, blk_phys, target_id, segs, nseg);
 
 	dbgprintf("Starting SCRIPTS execution...\n");
 
-	// Clear interrupt received flag
-	g_int_state.int_received = 0;
-
-	// Start SCRIPTS execution (load DSP)
-	WRITE_LONG(ncr, dsp, (ULONG)inquiry_script);
+	StartCommand(ncr, blk, blk_phys, nseg);
 
 	// Wait for interrupt (with Ctrl-C break)
-	dbgprintf("Waiting for interrupt (signal mask 0x%08lx)...\n", g_int_state.signal_mask);
+	dbgdebug("Waiting for interrupt (signal mask 0x%08lx)...\n", g_int_state.signal_mask);
 	ULONG sigs = Wait(g_int_state.signal_mask | SIGBREAKF_CTRL_C);
-	dbgprintf("Got signal: 0x%08lx, int_received=%ld\n", sigs, g_int_state.int_received);
+	dbgdebug("Got signal: 0x%08lx, int_received=%ld\n", sigs, g_int_state.int_received);
+
+	// Cache maintenance after DMA, before looking at status/data
+	// (like ROM driver's CachePostDMA)
+	DMACacheClear();
+	DMACachePost(data, 36, DMA_DIR_WRITE);
+	DMACachePost(blk, sizeof(struct SCSICmdBlock), DMA_DIR_BOTH);
 
 	if (sigs & SIGBREAKF_CTRL_C) {
 		dbgprintf("ERROR: Interrupted by user (Ctrl-C)\n");
@@ -476,11 +613,8 @@ DoInquiry(volatile struct ncr710 *ncr, UBYTE target_id, struct InquiryData *data
 		}
 	}
 
-	// Flush caches after DMA (like ROM driver's CachePostDMA)
-	CacheClearU();
-
-	// Free DSA
-	FreeMem(dsa, sizeof(struct DSA_entry));
+	// Free DSA and script
+	FreeScriptMem(blk, sizeof(struct SCSICmdBlock));
 
 	return result;
 }
@@ -531,37 +665,14 @@ PrintInquiryData(struct InquiryData *data)
  * Build DSA entry for READ(10) command
  */
 static void
-BuildRead10DSA(struct DSA_entry *dsa, UBYTE target_id, ULONG lba, UWORD blocks, UBYTE *data_buf)
+BuildRead10DSA(struct DSA_entry *dsa, ULONG dsa_phys, UBYTE target_id,
+               ULONG lba, UWORD blocks, struct DMASegment *segs, ULONG nseg)
 {
-	// Clear entire DSA
-	memset(dsa, 0, sizeof(struct DSA_entry));
-
-	// Setup data move (blocks * 512 bytes)
-	dsa->move_data.len  = blocks * SCSI_BLOCK_SIZE;
-	dsa->move_data.addr = (ULONG)data_buf;
-
-	// Setup selection data (ID and sync value)
-	dsa->select_data.res1 = 0;
-	dsa->select_data.id   = (1 << target_id);
-	dsa->select_data.sync = 0;		// Async transfer
-	dsa->select_data.res2 = 0;
-
-	// Setup status byte location
-	dsa->status_data.len  = 1;
-	dsa->status_data.addr = (ULONG)&(dsa->status_buf[0]);
-
-	// Setup message in location
-	dsa->recv_msg.len  = 1;
-	dsa->recv_msg.addr = (ULONG)&(dsa->recv_buf[0]);
-
-	// Setup message out (IDENTIFY + LUN)
-	dsa->send_msg.len  = 1;
-	dsa->send_msg.addr = (ULONG)&(dsa->send_buf[0]);
-	dsa->send_buf[0] = MSG_IDENTIFY;
+	// Data moves (blocks * 512 bytes), selection, status and message
+	BuildCommonDSA(dsa, dsa_phys, target_id, segs, nseg);
 
 	// Setup READ(10) command (10 bytes)
 	dsa->command_data.len  = 10;
-	dsa->command_data.addr = (ULONG)&(dsa->send_buf[1]);
 	dsa->send_buf[1] = S_READ10;		// READ(10) opcode
 	dsa->send_buf[2] = 0x00;		// LUN = 0, flags
 	dsa->send_buf[3] = (lba >> 24) & 0xFF;	// LBA byte 0 (MSB)
@@ -581,40 +692,46 @@ BuildRead10DSA(struct DSA_entry *dsa, UBYTE target_id, ULONG lba, UWORD blocks,
 static LONG
 DoRead10Chunk(volatile struct ncr710 *ncr, UBYTE target_id, ULONG lba, UWORD blocks, UBYTE *data_buf)
 {
+	struct SCSICmdBlock *blk;
 	struct DSA_entry *dsa;
+	struct DMASegment segs[SCSI_MAX_SG];
+	ULONG data_len = blocks * SCSI_BLOCK_SIZE;
+	ULONG blk_phys, nseg;
 	UBYTE istat, dstat;
 	LONG result = -1;
 
-	// Allocate DSA in FAST memory
-	dsa = AllocMem(sizeof(struct DSA_entry), MEMF_FAST | MEMF_CLEAR);
-	if (!dsa) {
+	// Allocate DSA and script where PlaceScripts() found fetches fastest
+	blk = AllocScriptMem(sizeof(struct SCSICmdBlock));
+	if (!blk) {
 		dbgprintf("ERROR: Could not allocate DSA\n");
 		return -1;
 	}
+	dsa = &blk->dsa;
+	blk_phys = DMAPhysAddr(blk);
+
+	// Cache maintenance and physical translation for the data buffer
+	DMACacheClear();
+	nseg = MapCommandData(data_buf, data_len, segs);
+	if (!nseg) {
+		DMACachePost(data_buf, data_len, DMA_DIR_WRITE);
+		FreeScriptMem(blk, sizeof(struct SCSICmdBlock));
+		return -7;
+	}
 
 	// Build DSA for READ(10)
-	BuildRead10DSA(dsa, target_id, lba, blocks, data_buf);
+	BuildRead10DSA(dsa, blk_phys, target_id, lba, blocks, segs, nseg);
 
-	// Flush caches
-	CacheClearU();
-
-	// Load DSA register
-	WRITE_LONG(ncr, dsa, (ULONG)dsa);
-
-	// Clear any pending interrupts
-	(void)ncr->istat;
-	(void)ncr->dstat;
-	(void)ncr->sstat0;
-
-	// Clear interrupt received flag
-	g_int_state.int_received = 0;
-
-	// Start SCRIPTS execution (reuse same SCRIPTS as INQUIRY)
-	WRITE_LONG(ncr, dsp, (ULONG)inquiry_script);
+	// Start SCRIPTS execution (same SCRIPTS as INQUIRY)
+	StartCommand(ncr, blk, blk_phys, nseg);
 
 	// Wait for interrupt
 	ULONG sigs = Wait(g_int_state.signal_mask | SIGBREAKF_CTRL_C);
 
+	// Cache maintenance after DMA, before looking at status/data
+	DMACacheClear();
+	DMACachePost(data_buf, data_len, DMA_DIR_WRITE);
+	DMACachePost(blk, sizeof(struct SCSICmdBlock), DMA_DIR_BOTH);
+
 	if (sigs & SIGBREAKF_CTRL_C) {
 		dbgprintf("ERROR: Interrupted by user (Ctrl-C)\n");
 		result = -8;
@@ -666,49 +783,33 @@ DoRead10Chunk(volatile struct ncr710 *ncr, UBYTE target_id, ULONG lba, UWORD blo
 		}
 	}
 
-	// Flush caches after DMA
-	CacheClearU();
-
-	// Free DSA
-	FreeMem(dsa, sizeof(struct DSA_entry));
+	// Free DSA and script
+	FreeScriptMem(blk, sizeof(struct SCSICmdBlock));
 
 	return result;
 }
 
+/* Per-chunk read times of DoRead32MB() */
+static ULONG g_chunk_us[READ_32MB_BLOCKS / READ_CHUNK_BLOCKS];
+
 /*
- * Read first 32MB from SCSI disk into FAST memory
- * Returns: 0 on success, negative on error
+ * One timed pass of the 32MB read into buffer
+ * Returns: 0 on success, the DoRead10Chunk() error otherwise
  */
-LONG
-DoRead32MB(volatile struct ncr710 *ncr, UBYTE target_id)
+static LONG
+ReadPass(volatile struct ncr710 *ncr, UBYTE target_id, UBYTE *buffer,
+         ULONG pass, ULONG passes)
 {
-	UBYTE *buffer;
 	ULONG lba;
 	ULONG total_blocks = READ_32MB_BLOCKS;
 	ULONG blocks_read = 0;
 	LONG result;
+	struct EClockVal t0, t1;
+	struct SampleSet set;
+	struct SampleStats st;
 
-	dbgprintf("\n=== Reading 32MB from SCSI ID %ld ===\n", (ULONG)target_id);
-	dbgprintf("Total blocks: %ld (%ld bytes)\n", total_blocks, READ_32MB_SIZE);
-	dbgprintf("Chunk size: %ld blocks (%ld bytes)\n\n",
-	          (ULONG)READ_CHUNK_BLOCKS, (ULONG)READ_CHUNK_SIZE);
-
-	// Allocate 32MB buffer in FAST memory
-	dbgprintf("Allocating 32MB FAST memory buffer...\n");
-	buffer = AllocMem(READ_32MB_SIZE, MEMF_FAST);
-	if (!buffer) {
-		dbgprintf("ERROR: Could not allocate 32MB FAST memory\n");
-		dbgprintf("Trying CHIP memory instead...\n");
-		buffer = AllocMem(READ_32MB_SIZE, MEMF_CHIP);
-		if (!buffer) {
-			dbgprintf("ERROR: Could not allocate 32MB memory at all\n");
-			return -1;
-		}
-	}
-
-	dbgprintf("Buffer allocated at: 0x%08lx\n\n", (ULONG)buffer);
-
-	// Read in chunks
+	// Read in chunks, each timed; the first --warmup are discarded (seek, cache)
+	StatsInit(&set, g_chunk_us, READ_32MB_BLOCKS / READ_CHUNK_BLOCKS, StatsWarmup());
 	lba = 0;
 	while (blocks_read < total_blocks) {
 		ULONG blocks_to_read = READ_CHUNK_BLOCKS;
@@ -719,26 +820,28 @@ DoRead32MB(volatile struct ncr710 *ncr, UBYTE target_id)
 			blocks_to_read = total_blocks - blocks_read;
 		}
 
-		dbgprintf("Reading LBA %ld, %ld blocks (%ld KB)... ",
-		          lba, blocks_to_read, (blocks_to_read * SCSI_BLOCK_SIZE) / 1024);
+		dbgdebug("Reading LBA %ld, %ld blocks (%ld KB)...\n",
+		         lba, blocks_to_read, (blocks_to_read * SCSI_BLOCK_SIZE) / 1024);
 
+		ReadTimer(&t0);
 		result = DoRead10Chunk(ncr, target_id, lba, blocks_to_read, chunk_buf);
+		ReadTimer(&t1);
+		StatsAdd(&set, ElapsedMicros(&t0, &t1));
 
 		if (result != 0) {
-			dbgprintf("FAILED (error %ld)\n", result);
+			dbgprintf("Reading LBA %ld, %ld blocks: FAILED (error %ld)\n",
+			          lba, blocks_to_read, result);
 			dbgprintf("\nRead failed at block %ld\n", blocks_read);
-			FreeMem(buffer, READ_32MB_SIZE);
 			return result;
 		}
 
-		dbgprintf("OK\n");
-
 		lba += blocks_to_read;
 		blocks_read += blocks_to_read;
 
 		// Show progress every 1MB
 		if ((blocks_read % (2048)) == 0) {
 			dbgprintf("  Progress: %ld MB / 32 MB\n", blocks_read / 2048);
+			dbgflush();
 		}
 	}
 
@@ -747,6 +850,60 @@ DoRead32MB(volatile struct ncr710 *ncr, UBYTE target_id)
 	dbgprintf("Buffer at: 0x%08lx - 0x%08lx\n",
 	          (ULONG)buffer, (ULONG)(buffer + READ_32MB_SIZE - 1));
 
+	if (StatsCompute(&set, &st) == 0 && st.min_us) {
+		dbgprintf("Pass %ld of %ld: %ld KB READ(10) chunks after %ld warm-up, min/median/p99:\n ",
+		          pass + 1, passes, (ULONG)READ_CHUNK_SIZE / 1024, StatsWarmup());
+		PrintRateStats(READ_CHUNK_SIZE, &st);
+		dbgprintf("\n");
+	}
+
+	return 0;
+}
+
+/*
+ * Read first 32MB from SCSI disk into FAST memory
+ * Each READ(10) chunk is one timed run. The read is repeated --reps
+ * times (StatsRuns() - StatsWarmup()); every pass discards its first
+ * --warmup chunks and reports its own min/median/p99. The data of the
+ * last pass is verified.
+ * Returns: 0 on success, negative on error
+ */
+LONG
+DoRead32MB(volatile struct ncr710 *ncr, UBYTE target_id)
+{
+	UBYTE *buffer;
+	ULONG total_blocks = READ_32MB_BLOCKS;
+	ULONG pass, passes = StatsRuns() - StatsWarmup();
+	LONG result;
+
+	dbgprintf("\n=== Reading 32MB from SCSI ID %ld ===\n", (ULONG)target_id);
+	dbgprintf("Total blocks: %ld (%ld bytes)\n", total_blocks, READ_32MB_SIZE);
+	dbgprintf("Chunk size: %ld blocks (%ld bytes)\n\n",
+	          (ULONG)READ_CHUNK_BLOCKS, (ULONG)READ_CHUNK_SIZE);
+
+	// Allocate 32MB buffer in FAST memory
+	dbgprintf("Allocating 32MB FAST memory buffer...\n");
+	buffer = AllocMem(READ_32MB_SIZE, MEMF_FAST);
+	if (!buffer) {
+		dbgprintf("ERROR: Could not allocate 32MB FAST memory\n");
+		dbgprintf("Trying CHIP memory instead...\n");
+		buffer = AllocMem(READ_32MB_SIZE, MEMF_CHIP);
+		if (!buffer) {
+			dbgprintf("ERROR: Could not allocate 32MB memory at all\n");
+			return -1;
+		}
+	}
+
+	dbgprintf("Buffer allocated at: 0x%08lx\n\n", (ULONG)buffer);
+
+	for (pass = 0; pass < passes; pass++) {
+		result = ReadPass(ncr, target_id, buffer, pass, passes);
+		if (result != 0) {
+			FreeMem(buffer, READ_32MB_SIZE);
+			return result;
+		}
+	}
+
 	// Verify data against pseudo-random pattern
 	dbgprintf("\n=== Verifying Data ===\n");
 	dbgprintf("Checking 32MB against PRNG pattern...\n");
@@ -26,6 +26,9 @@
 #define READ_CHUNK_SIZE		(64 * 1024)		// 64KB per transfer
 #define READ_CHUNK_BLOCKS	(READ_CHUNK_SIZE / SCSI_BLOCK_SIZE)  // 128 blocks
 
+/* Data phase scatter-gather - one entry per physical segment of a chunk */
+#define SCSI_MAX_SG		(READ_CHUNK_SIZE / DMA_PAGE_SIZE + 1)
+
 /* SCSI Status Codes */
 #define SCSI_GOOD		0x00
 #define SCSI_CHECK_CONDITION	0x02
@@ -97,6 +100,17 @@ struct DSA_entry {
 	UBYTE recv_buf[8];			// 72  message in buffer
 	UBYTE status_buf[1];			// 80  status byte
 	UBYTE pad[3];				// 81  padding to longword
+	struct move_data    data_sg[SCSI_MAX_SG];	// 84  data phase SG list
+};
+
+/* Command script: 9 fixed instructions plus one DATA_IN move per SG entry */
+#define SCSI_SCRIPT_WORDS	((9 + SCSI_MAX_SG) * 2)
+
+/* Per-command DMA block - DSA plus the SCRIPTS built for it */
+/* Allocated with AllocDMAContig() so one physical base covers both */
+struct SCSICmdBlock {
+	struct DSA_entry dsa;
+	ULONG script[SCSI_SCRIPT_WORDS];
 };
 
 /* SCSI Command Request */
@@ -142,6 +156,8 @@ struct NCRIntState {
 LONG SetupNCRInterrupts(volatile struct ncr710 *ncr);
 void CleanupNCRInterrupts(volatile struct ncr710 *ncr);
 LONG InitNCRForSCSI(volatile struct ncr710 *ncr);
+LONG RunProbeScript(volatile struct ncr710 *ncr, ULONG script_phys, ULONG magic,
+                    const char *context);
 LONG DoInquiry(volatile struct ncr710 *ncr, UBYTE target_id, struct InquiryData *data);
 void PrintInquiryData(struct InquiryData *data);
 LONG DoRead32MB(volatile struct ncr710 *ncr, UBYTE target_id);
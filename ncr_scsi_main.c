@@ -25,6 +25,11 @@ print_usage(void)
 	dbgprintf("  read <id>                 - Read & verify 32MB from disk at SCSI ID (0-7)\n");
 	dbgprintf("  generate <file>           - Generate 32MB random file (for disk write)\n");
 	dbgprintf("\n");
+	dbgprintf("Options (after the command):\n");
+	dbgprintf("  --reps <n>                - Timed passes of the 32MB read (default 1)\n");
+	dbgprintf("  --warmup <n>              - READ(10) chunks discarded per pass (default %ld)\n",
+	          (ULONG)STATS_DEFAULT_WARMUP);
+	dbgprintf("\n");
 	dbgprintf("Examples:\n");
 	dbgprintf("  ncr_scsi inquiry 3        - Query device at SCSI ID 3\n");
 	dbgprintf("  ncr_scsi generate ram:test.dat - Create 32MB random file\n");
@@ -43,7 +48,9 @@ main(int argc, char **argv)
 	volatile struct ncr710 *ncr;
 	struct InquiryData *inq_data;
 	UBYTE target_id;
+	ULONG reps = 1, warmup = STATS_DEFAULT_WARMUP;
 	LONG result;
+	int i;
 
 	dbgprintf("\n%s\n", VERSION_STRING);
 	dbgprintf("==============================\n\n");
@@ -67,6 +74,24 @@ main(int argc, char **argv)
 		return (result == 0) ? 0 : 1;
 	}
 
+	// Benchmark options follow the command and its argument
+	for (i = 3; i < argc; i++) {
+		if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+			reps = strtoul(argv[++i], NULL, 10);
+			if (reps < 1 || reps > STATS_MAX_REPS) {
+				dbgprintf("ERROR: --reps must be 1-%ld\n", (ULONG)STATS_MAX_REPS);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+			warmup = strtoul(argv[++i], NULL, 10);
+		} else {
+			dbgprintf("ERROR: Unknown option '%s'\n", argv[i]);
+			print_usage();
+			return 1;
+		}
+	}
+	SetStatsConfig(reps, warmup);
+
 	// All other commands need NCR initialization
 
 	// Get NCR chip pointer
@@ -87,12 +112,25 @@ main(int argc, char **argv)
 		return 1;
 	}
 
+	// Timer is used for read throughput and cache maintenance statistics
+	InitTimer();
+
 	// Setup interrupts
 	if (SetupNCRInterrupts(ncr) < 0) {
 		dbgprintf("FATAL: Interrupt setup failed\n");
 		return 1;
 	}
 
+	// Small pools for DSA, script and INQUIRY buffers; given back at exit
+	PoolInit(POOL_SCSI_ARENA);
+	atexit(PoolCleanup);
+
+	// DSA and script go where the chip fetches them fastest
+	PlaceScripts(ncr, RunProbeScript);
+
+	// Hold output in the log ring while commands run (flushed at exit)
+	dbgdefer(1);
+
 	// Parse command
 	if (strcmp(argv[1], "inquiry") == 0) {
 		// INQUIRY command
@@ -110,11 +148,12 @@ main(int argc, char **argv)
 		}
 
 		// Allocate buffer for INQUIRY data
-		inq_data = AllocMem(sizeof(struct InquiryData), MEMF_FAST | MEMF_CLEAR);
+		inq_data = PoolAlloc(POOL_FAST, sizeof(struct InquiryData));
 		if (!inq_data) {
 			dbgprintf("ERROR: Could not allocate INQUIRY buffer\n");
 			return 1;
 		}
+		memset(inq_data, 0, sizeof(struct InquiryData));
 
 		// Execute INQUIRY
 		result = DoInquiry(ncr, target_id, inq_data);
@@ -126,10 +165,15 @@ main(int argc, char **argv)
 			dbgprintf("\nINQUIRY failed with error code %ld\n", result);
 		}
 
-		FreeMem(inq_data, sizeof(struct InquiryData));
+		PoolFree(inq_data, sizeof(struct InquiryData));
+
+		PrintCacheStats();
+		PrintPoolStats();
+		dbgflush();
 
 		// Cleanup interrupts
 		CleanupNCRInterrupts(ncr);
+		CleanupTimer();
 
 		return (result == 0) ? 0 : 1;
 
@@ -155,8 +199,13 @@ main(int argc, char **argv)
 			dbgprintf("\nREAD failed with error code %ld\n", result);
 		}
 
+		PrintCacheStats();
+		PrintPoolStats();
+		dbgflush();
+
 		// Cleanup interrupts
 		CleanupNCRInterrupts(ncr);
+		CleanupTimer();
 
 		return (result == 0) ? 0 : 1;
 
@@ -166,6 +215,7 @@ main(int argc, char **argv)
 
 		// Cleanup interrupts
 		CleanupNCRInterrupts(ncr);
+		CleanupTimer();
 
 		return 1;
 	}
@@ -0,0 +1,274 @@
+/*
+ * NCR 53C710 DMA Test Tool - Time-bounded scatter-gather soak
+ *
+ * Overnight burn-in needs throughput and failure statistics over hours,
+ * not one PASSED line. The soak gathers one SG_SEGMENT_SIZE segment from
+ * every available test buffer into a destination allocated once up front,
+ * for a fixed time or iteration count. Every SOAK_PATTERN_ITERATIONS the
+ * seed, pattern and source offsets rotate; in between only the destination
+ * is cleared. Statistics are printed every report interval and at the end.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/memory.h>
+#include <dos/dos.h>
+#include <proto/exec.h>
+
+#define SOAK_DEST_SIZE  (MAX_SG_SEGMENTS * SG_SEGMENT_SIZE)
+#define SOAK_SEED_BASE  0x12345678
+#define SOAK_OFFSETS    (TEST_BUFFER_SIZE / SG_SEGMENT_SIZE)
+
+struct SoakStats {
+	ULONG iterations;
+	ULONG failures;			// Iterations with a DMA or verify error
+	ULONG dma_errors;
+	ULONG byte_errors;		// Mismatched bytes over all failures
+	unsigned long long bytes;	// Bytes gathered
+	unsigned long long micros;	// Time spent in DMA
+	BOOL failed;			// A failure has been seen
+	ULONG first_fail_secs;		// Time to first failure
+	ULONG first_fail_iteration;
+};
+
+/*
+ * Throughput in hundredths of MB/s for 64-bit totals
+ */
+static ULONG SoakRate(unsigned long long bytes, unsigned long long micros)
+{
+	if (micros == 0)
+		micros = 1;
+
+	return (ULONG)((bytes * 100ULL) / micros);
+}
+
+/*
+ * Print elapsed seconds as hh:mm:ss
+ */
+static void PrintSoakTime(ULONG secs)
+{
+	dbgprintf("%02ld:%02ld:%02ld", secs / 3600, (secs / 60) % 60, secs % 60);
+}
+
+/*
+ * Print totals plus the delta since the previous report
+ */
+static void PrintSoakReport(struct SoakStats *total, struct SoakStats *last,
+                            ULONG secs, ULONG last_secs)
+{
+	ULONG iters = total->iterations - last->iterations;
+	ULONG span = secs - last_secs;
+	ULONG rate;
+
+	dbgprintf("\n  Soak ");
+	PrintSoakTime(secs);
+	rate = SoakRate(total->bytes, total->micros);
+	dbgprintf(": %ld iterations (%ld.%01ld/s), %ld MB moved (%ld.%02ld MB/s DMA)\n",
+	          total->iterations,
+	          secs ? total->iterations / secs : total->iterations,
+	          secs ? ((total->iterations * 10) / secs) % 10 : 0,
+	          (ULONG)(total->bytes / 1000000ULL), rate / 100, rate % 100);
+
+	if (last_secs) {
+		rate = SoakRate(total->bytes - last->bytes, total->micros - last->micros);
+		dbgprintf("    interval: %ld iterations (%ld.%01ld/s), %ld.%02ld MB/s DMA, %ld failures\n",
+		          iters,
+		          span ? iters / span : iters,
+		          span ? ((iters * 10) / span) % 10 : 0,
+		          rate / 100, rate % 100,
+		          total->failures - last->failures);
+	}
+
+	dbgprintf("    failures: %ld of %ld (%ld ppm), %ld DMA errors, %ld bad bytes\n",
+	          total->failures, total->iterations,
+	          total->iterations ?
+	          (ULONG)(((unsigned long long)total->failures * 1000000ULL) / total->iterations) : 0,
+	          total->dma_errors, total->byte_errors);
+
+	dbgprintf("    first failure: ");
+	if (total->failed) {
+		PrintSoakTime(total->first_fail_secs);
+		dbgprintf(" (iteration %ld)\n", total->first_fail_iteration);
+	} else {
+		dbgprintf("none\n");
+	}
+
+	*last = *total;
+}
+
+/*
+ * Gather from every available test buffer for 'seconds' (0 = no limit) or
+ * 'max_iterations' (0 = no limit), reporting every 'report_seconds'
+ * (0 = final summary only). Ctrl-C stops the run early.
+ */
+void SoakScatterGather(volatile struct ncr710 *ncr, ULONG seconds,
+                       ULONG max_iterations, ULONG report_seconds)
+{
+	UBYTE *bases[MAX_SG_SEGMENTS];
+	const char *names[MAX_SG_SEGMENTS];
+	UBYTE *sources[MAX_SG_SEGMENTS];
+	ULONG sizes[MAX_SG_SEGMENTS];
+	ULONG offsets[MAX_SG_SEGMENTS];
+	struct SoakStats total, last;
+	struct EClockVal start, now, t0, t1;
+	UBYTE *dest;
+	ULONG num_segments = 0;
+	ULONG epoch = 0, seed = 0;
+	ULONG secs = 0, last_secs = 0, next_report;
+	ULONG i, j, bad;
+	LONG status;
+	BOOL refill = TRUE;
+	int idx;
+
+	for (idx = 0; idx < g_num_test_buffers && num_segments < MAX_SG_SEGMENTS; idx++) {
+		if (*g_test_buffers[idx].buf) {
+			bases[num_segments] = *g_test_buffers[idx].buf;
+			names[num_segments] = g_test_buffers[idx].name;
+			sizes[num_segments] = SG_SEGMENT_SIZE;
+			num_segments++;
+		}
+	}
+
+	if (num_segments < 2) {
+		dbgprintf("ERROR: Need at least 2 memory regions for scatter-gather soak\n");
+		return;
+	}
+
+	// Allocated once for the whole run
+	dest = PoolAlloc(POOL_FAST, SOAK_DEST_SIZE);
+	if (!dest) {
+		dbgprintf("ERROR: Could not allocate soak destination buffer\n");
+		return;
+	}
+
+	dbgprintf("\n=== Scatter-Gather Soak ===\n");
+	dbgprintf("%ld x %ld byte segments -> 0x%08lx, ",
+	          num_segments, (ULONG)SG_SEGMENT_SIZE, (ULONG)dest);
+	if (seconds)
+		dbgprintf("%ld minutes", seconds / 60);
+	else
+		dbgprintf("%ld iterations", max_iterations);
+	if (report_seconds)
+		dbgprintf(", report every %ld minutes", report_seconds / 60);
+	dbgprintf(" (Ctrl-C stops)\n");
+	dbgflush();
+
+	memset(&total, 0, sizeof(total));
+	memset(&last, 0, sizeof(last));
+	next_report = report_seconds;
+
+	// A resumed sweep picks the stress run up where its journal left it
+	total.iterations = JournalStressResume(&total.failures);
+	if (total.iterations) {
+		dbgprintf("Resuming at iteration %ld (%ld failures so far)\n",
+		          total.iterations, total.failures);
+		epoch = total.iterations / SOAK_PATTERN_ITERATIONS;
+		last = total;
+	}
+
+	ReadTimer(&start);
+
+	for (;;) {
+		if (seconds && secs >= seconds)
+			break;
+		if (max_iterations && total.iterations >= max_iterations)
+			break;
+		if (SetSignal(0, SIGBREAKF_CTRL_C) & SIGBREAKF_CTRL_C) {
+			dbgprintf("\nSoak stopped by user (Ctrl-C)\n");
+			g_user_abort = TRUE;
+			break;
+		}
+
+		// Rotate seed, pattern and source offsets
+		if (refill || (total.iterations % SOAK_PATTERN_ITERATIONS) == 0) {
+			refill = FALSE;
+			seed = SOAK_SEED_BASE ^ (epoch * 0x9E3779B9);
+			SeedRandom(seed);
+			for (i = 0; i < num_segments; i++) {
+				offsets[i] = ((epoch + i) % SOAK_OFFSETS) * SG_SEGMENT_SIZE;
+				sources[i] = bases[i] + offsets[i];
+				FillPattern(sources[i], sizes[i], (epoch + i) % NUM_TEST_PATTERNS);
+			}
+			epoch++;
+		}
+
+		// Different fill each time so stale data cannot pass
+		memset(dest, (total.iterations * 0x3B + 0x5A) & 0xFF, SOAK_DEST_SIZE);
+
+		ReadTimer(&t0);
+		status = RunScatterGatherTest(ncr, sources, dest, sizes, num_segments);
+		ReadTimer(&t1);
+
+		if (status == TEST_ABORTED)
+			break;
+
+		total.iterations++;
+		total.micros += ElapsedMicros(&t0, &t1);
+
+		bad = 0;
+		if (status != TEST_SUCCESS) {
+			total.dma_errors++;
+			dbgprintf("  FAILED iteration %ld: DMA status %ld (seed 0x%08lx)\n",
+			          total.iterations, status, seed);
+		} else {
+			ULONG offset = 0;
+
+			total.bytes += num_segments * SG_SEGMENT_SIZE;
+
+			for (i = 0; i < num_segments; i++) {
+				ULONG seg_bad = 0, first = 0;
+
+				for (j = 0; j < sizes[i]; j++) {
+					if (dest[offset + j] != sources[i][j]) {
+						if (!seg_bad)
+							first = j;
+						seg_bad++;
+					}
+				}
+
+				if (seg_bad) {
+					dbgprintf("  FAILED iteration %ld: segment %ld (%s+0x%05lx) "
+					          "%ld bad bytes from offset %ld, "
+					          "expected 0x%02lx got 0x%02lx (seed 0x%08lx)\n",
+					          total.iterations, i, names[i], offsets[i],
+					          seg_bad, first, (ULONG)sources[i][first],
+					          (ULONG)dest[offset + first], seed);
+					bad += seg_bad;
+				}
+				offset += sizes[i];
+			}
+			total.byte_errors += bad;
+		}
+
+		ReadTimer(&now);
+		secs = ElapsedSeconds(&start, &now);
+
+		if (status != TEST_SUCCESS || bad) {
+			total.failures++;
+			if (!total.failed) {
+				total.failed = TRUE;
+				total.first_fail_secs = secs;
+				total.first_fail_iteration = total.iterations;
+			}
+		}
+
+		JournalStressProgress(total.iterations, total.failures);
+
+		if (report_seconds && secs >= next_report) {
+			PrintSoakReport(&total, &last, secs, last_secs);
+			dbgflush();
+			last_secs = secs;
+			while (next_report <= secs)
+				next_report += report_seconds;
+		}
+	}
+
+	dbgprintf("\n=== Soak %s ===", total.failures ? "FAILED" : "PASSED");
+	last_secs = 0;
+	PrintSoakReport(&total, &last, secs, last_secs);
+	dbgprintf("\n");
+	dbgflush();
+
+	PoolFree(dest, SOAK_DEST_SIZE);
+}
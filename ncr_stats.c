@@ -0,0 +1,192 @@
+/*
+ * NCR 53C710 DMA Test Tool - Repeated measurement statistics
+ *
+ * A single timed run mixes the transfer with whatever Exec, interrupts
+ * and DRAM refresh did at the same moment. Benchmarks take every
+ * measurement StatsRuns() times: the first 'warmup' runs are discarded
+ * (cold caches, first-touch MMU walks, the interrupt server paging in),
+ * the rest are kept and reduced to min, median and 99th percentile time
+ * and the coefficient of variation. A cell whose CV exceeds
+ * STATS_NOISY_CV is flagged, so a scheduler hiccup is not mistaken for
+ * a slower board. Integer arithmetic only.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+
+static ULONG g_stats_reps = STATS_DEFAULT_REPS;
+static ULONG g_stats_warmup = STATS_DEFAULT_WARMUP;
+
+/*
+ * Set runs kept and discarded per measurement (--reps, --warmup)
+ */
+void SetStatsConfig(ULONG reps, ULONG warmup)
+{
+	if (reps < 1)
+		reps = 1;
+	if (reps > STATS_MAX_REPS)
+		reps = STATS_MAX_REPS;
+
+	g_stats_reps = reps;
+	g_stats_warmup = warmup;
+}
+
+/*
+ * Timed runs per measurement, warm-up included
+ */
+ULONG StatsRuns(void)
+{
+	return g_stats_warmup + g_stats_reps;
+}
+
+/*
+ * Runs discarded before the kept ones
+ */
+ULONG StatsWarmup(void)
+{
+	return g_stats_warmup;
+}
+
+/*
+ * Print the configuration under a benchmark heading
+ */
+void PrintStatsConfig(void)
+{
+	dbgprintf("Each figure: %ld runs after %ld warm-up, min/median/p99 of run time;\n",
+	          g_stats_reps, g_stats_warmup);
+	dbgprintf("'~' marks CV above %ld.%01ld%%\n",
+	          (ULONG)STATS_NOISY_CV / 10, (ULONG)STATS_NOISY_CV % 10);
+}
+
+/*
+ * Start a set on the caller's array of max samples
+ * warmup = runs to discard before keeping any
+ */
+void StatsInit(struct SampleSet *set, ULONG *samples, ULONG max, ULONG warmup)
+{
+	set->us = samples;
+	set->max = max;
+	set->n = 0;
+	set->seen = 0;
+	set->warmup = warmup;
+}
+
+/*
+ * Start a set with the configured warm-up (STATS_MAX_REPS samples)
+ */
+void StatsBegin(struct SampleSet *set, ULONG *samples)
+{
+	StatsInit(set, samples, STATS_MAX_REPS, g_stats_warmup);
+}
+
+/*
+ * Add one run's time
+ */
+void StatsAdd(struct SampleSet *set, ULONG us)
+{
+	if (++set->seen <= set->warmup)
+		return;
+
+	if (set->n < set->max)
+		set->us[set->n++] = us;
+}
+
+/*
+ * Integer square root
+ */
+ULONG ISqrt64(unsigned long long v)
+{
+	unsigned long long r = 0, bit = 1ULL << 62;
+
+	while (bit > v)
+		bit >>= 2;
+
+	while (bit) {
+		if (v >= r + bit) {
+			v -= r + bit;
+			r = (r >> 1) + bit;
+		} else {
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return (ULONG)r;
+}
+
+/*
+ * Reduce the kept samples (sorts them in place)
+ * Returns 0 on success, -1 if no sample was kept
+ */
+LONG StatsCompute(struct SampleSet *set, struct SampleStats *st)
+{
+	unsigned long long sum = 0, var = 0;
+	ULONG n = set->n;
+	ULONG *v = set->us;
+	ULONG i, j, x, mean, sd;
+
+	st->n = n;
+	if (!n) {
+		st->min_us = st->median_us = st->p99_us = st->mean_us = 0;
+		st->cv = 0;
+		st->noisy = FALSE;
+		return -1;
+	}
+
+	// Insertion sort - at most a few hundred samples
+	for (i = 1; i < n; i++) {
+		x = v[i];
+		for (j = i; j > 0 && v[j - 1] > x; j--)
+			v[j] = v[j - 1];
+		v[j] = x;
+	}
+
+	for (i = 0; i < n; i++)
+		sum += v[i];
+	mean = sum / n;
+
+	for (i = 0; i < n; i++) {
+		long long d = (long long)v[i] - mean;
+		var += d * d;
+	}
+	sd = ISqrt64(var / n);
+
+	st->min_us = v[0];
+	st->median_us = (n & 1) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+	st->p99_us = v[(n * 99 + 99) / 100 - 1];	// Nearest rank
+	st->mean_us = mean;
+	st->cv = mean ? (ULONG)(((unsigned long long)sd * 1000) / mean) : 0;
+	st->noisy = (n >= 3 && st->cv > STATS_NOISY_CV);
+
+	return 0;
+}
+
+/*
+ * Median rate in hundredths of MB/s for 'bytes' per run
+ */
+ULONG StatsRate(ULONG bytes, struct SampleStats *st)
+{
+	return st->n ? CalcRate(bytes, st->median_us) : 0;
+}
+
+/*
+ * Print " min/median/p99 MB/s cv x.x%" for 'bytes' per run
+ * min is the fastest run, p99 the slow tail
+ */
+void PrintRateStats(ULONG bytes, struct SampleStats *st)
+{
+	ULONG best, med, p99;
+
+	if (!st->n) {
+		dbgprintf("     no samples");
+		return;
+	}
+
+	best = CalcRate(bytes, st->min_us);
+	med = CalcRate(bytes, st->median_us);
+	p99 = CalcRate(bytes, st->p99_us);
+
+	dbgprintf(" %3ld.%02ld/%3ld.%02ld/%3ld.%02ld MB/s cv %2ld.%01ld%%%s",
+	          best / 100, best % 100, med / 100, med % 100, p99 / 100, p99 % 100,
+	          st->cv / 10, st->cv % 10, st->noisy ? " ~" : "");
+}
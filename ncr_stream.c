@@ -0,0 +1,288 @@
+/*
+ * NCR 53C710 DMA Test Tool - Fixed-address (DMODE FAM) streaming
+ *
+ * InitNCR() leaves DMODE FAM clear, so every memory move walks both
+ * addresses. A capture board with a single data port needs the port side
+ * held still instead. This mode sets FAM for its own scripts only, moves
+ * STREAM_MOVES x STREAM_BUF_SIZE bytes from the port into a FAST RAM
+ * buffer (source) and from the buffer into the port (sink), and reports
+ * sustained MB/s next to a CPU longword loop doing the same job.
+ *
+ * The port is given as a longword-aligned physical address on the command
+ * line; without one a cache line of FAST RAM stands in for it. With the
+ * stand-in the mode also checks what FAM held: after a source run the
+ * buffer shows whether the RAM side still incremented, after a sink run
+ * the stand-in holds the first or the last longword of the buffer.
+ *
+ * The CPU loop dereferences the port address as given, so it needs the
+ * address to be mapped 1:1. That is only assumed for RAM in Exec's memory
+ * list (TypeOfMem() knows it); for any other port the CPU comparison is
+ * skipped.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <string.h>
+#include <exec/memory.h>
+#include <proto/exec.h>
+
+#define STREAM_MAGIC      0x57EA3000
+#define STREAM_PORT_VALUE 0x5EED1234	// Stand-in contents for the source run
+#define STREAM_BYTES      (STREAM_MOVES * STREAM_BUF_SIZE)
+
+/*
+ * Build STREAM_MOVES identical moves and the final INT
+ * Returns the script length in bytes
+ */
+static ULONG BuildStreamScript(struct memmove_inst *moves, ULONG src, ULONG dst)
+{
+	ULONG i;
+
+	for (i = 0; i < STREAM_MOVES; i++)
+		BuildMemMove(&moves[i], src, dst, STREAM_BUF_SIZE);
+	BuildIntInst((struct jump_inst *)&moves[STREAM_MOVES], STREAM_MAGIC);
+
+	return STREAM_SCRIPT_SIZE;
+}
+
+/*
+ * Time StatsRuns() runs of the script with FAM set
+ * DMODE is restored whatever happens
+ * Returns 0 on success, -1 on failure
+ */
+static LONG TimeFixedScript(volatile struct ncr710 *ncr, UBYTE *script, ULONG len,
+                            struct SampleStats *st)
+{
+	struct BurstConfig base, fam;
+	struct EClockVal t0, t1;
+	ULONG run_us[STATS_MAX_REPS];
+	struct SampleSet set;
+	ULONG phys, r;
+	LONG status = TEST_SUCCESS;
+
+	phys = DMAPhysAddr(script);
+	DMACachePre(script, len, DMA_DIR_READ);
+
+	ReadBurstConfig(ncr, &base);
+	fam = base;
+	fam.dmode |= DMODEF_FAM;
+	ApplyBurstConfig(ncr, &fam);
+
+	StatsBegin(&set, run_us);
+	for (r = 0; r < StatsRuns() && status == TEST_SUCCESS; r++) {
+		ReadTimer(&t0);
+		status = ExecuteScript(ncr, phys, STREAM_MAGIC, "Fixed-address stream");
+		ReadTimer(&t1);
+		StatsAdd(&set, ElapsedMicros(&t0, &t1));
+	}
+
+	ApplyBurstConfig(ncr, &base);
+	DMACachePost(script, len, DMA_DIR_READ);
+
+	if (status != TEST_SUCCESS)
+		return -1;
+
+	StatsCompute(&set, st);
+	return 0;
+}
+
+/*
+ * Time the CPU loop the DMA replaces: one longword at a time between the
+ * port and the buffer, STREAM_BYTES per run
+ */
+static void TimeCpuStream(volatile ULONG *port, ULONG *buf, BOOL sink, struct SampleStats *st)
+{
+	struct EClockVal t0, t1;
+	ULONG run_us[STATS_MAX_REPS];
+	struct SampleSet set;
+	ULONG r, m, n;
+	ULONG *p;
+
+	StatsBegin(&set, run_us);
+	for (r = 0; r < StatsRuns(); r++) {
+		ReadTimer(&t0);
+		for (m = 0; m < STREAM_MOVES; m++) {
+			p = buf;
+			n = STREAM_BUF_SIZE / sizeof(ULONG);
+			if (sink) {
+				while (n--)
+					*port = *p++;
+			} else {
+				while (n--)
+					*p++ = *port;
+			}
+		}
+		ReadTimer(&t1);
+		StatsAdd(&set, ElapsedMicros(&t0, &t1));
+	}
+
+	StatsCompute(&set, st);
+}
+
+/*
+ * Longwords of buf holding value
+ */
+static ULONG CountLongs(const ULONG *buf, ULONG value)
+{
+	ULONG i, n = 0;
+
+	for (i = 0; i < STREAM_BUF_SIZE / sizeof(ULONG); i++) {
+		if (buf[i] == value)
+			n++;
+	}
+
+	return n;
+}
+
+/*
+ * Report what FAM held during a stand-in run
+ */
+static void PrintStandinCheck(ULONG *standin, ULONG *buf, BOOL sink)
+{
+	ULONG longs = STREAM_BUF_SIZE / sizeof(ULONG);
+	ULONG n;
+
+	if (sink) {
+		if (standin[0] == buf[longs - 1])
+			dbgprintf("  Stand-in holds the last buffer longword: RAM side incremented\n");
+		else if (standin[0] == buf[0])
+			dbgprintf("  Stand-in holds the first buffer longword: RAM side was held too\n");
+		else
+			dbgprintf("  WARNING: Stand-in holds 0x%08lx, not from the buffer\n", standin[0]);
+		return;
+	}
+
+	n = CountLongs(buf, STREAM_PORT_VALUE);
+	if (n == longs)
+		dbgprintf("  Every buffer longword holds the port value: RAM side incremented\n");
+	else if (n == 1 && buf[0] == STREAM_PORT_VALUE)
+		dbgprintf("  Only the first buffer longword holds the port value: RAM side was held too\n");
+	else
+		dbgprintf("  WARNING: %ld of %ld buffer longwords hold the port value\n", n, longs);
+}
+
+/*
+ * One direction: DMA with FAM, then the CPU loop if cpu is set
+ */
+static void StreamDirection(volatile struct ncr710 *ncr, UBYTE *script, ULONG port_phys,
+                            ULONG *port, ULONG *buf, ULONG buf_phys, BOOL sink, BOOL standin,
+                            BOOL cpu)
+{
+	struct SampleStats st;
+	ULONG len, i;
+	LONG status;
+
+	dbgprintf("\n%s\n", sink ? "Sink: RAM -> port" : "Source: port -> RAM");
+
+	if (sink) {
+		for (i = 0; i < STREAM_BUF_SIZE / sizeof(ULONG); i++)
+			buf[i] = 0xB0F00000 + i;
+		if (standin)
+			port[0] = 0;
+		len = BuildStreamScript((struct memmove_inst *)script, buf_phys, port_phys);
+	} else {
+		memset(buf, 0, STREAM_BUF_SIZE);
+		if (standin)
+			port[0] = STREAM_PORT_VALUE;
+		len = BuildStreamScript((struct memmove_inst *)script, port_phys, buf_phys);
+	}
+
+	// Only RAM goes through the caches - a real port is the board's business
+	DMACachePre(buf, STREAM_BUF_SIZE, sink ? DMA_DIR_READ : DMA_DIR_WRITE);
+	if (standin)
+		DMACachePre(port, sizeof(ULONG), sink ? DMA_DIR_WRITE : DMA_DIR_READ);
+
+	status = TimeFixedScript(ncr, script, len, &st);
+
+	DMACachePost(buf, STREAM_BUF_SIZE, sink ? DMA_DIR_READ : DMA_DIR_WRITE);
+	if (standin)
+		DMACachePost(port, sizeof(ULONG), sink ? DMA_DIR_WRITE : DMA_DIR_READ);
+
+	if (status != 0) {
+		dbgprintf("  DMA FAILED\n");
+		return;
+	}
+
+	dbgprintf("  DMA (FAM) :");
+	PrintRateStats(STREAM_BYTES, &st);
+	dbgprintf("\n");
+
+	if (standin)
+		PrintStandinCheck(port, buf, sink);
+
+	if (!cpu) {
+		dbgprintf("  CPU loop  : skipped - port is not RAM with a known logical address\n");
+		dbgflush();
+		return;
+	}
+
+	TimeCpuStream((volatile ULONG *)port, buf, sink, &st);
+	dbgprintf("  CPU loop  :");
+	PrintRateStats(STREAM_BYTES, &st);
+	dbgprintf("%s\n", standin ? " (stand-in is cached)" : "");
+	dbgflush();
+}
+
+/*
+ * Fixed-address streaming from and to port (physical address, 0 = stand-in)
+ */
+void TestFixedStream(volatile struct ncr710 *ncr, ULONG port)
+{
+	struct DMASegment seg;
+	UBYTE *script;
+	ULONG *buf, *standin = NULL;
+	ULONG port_phys, buf_phys;
+	BOOL cpu;
+
+	dbgprintf("\n=== Fixed-Address Streaming (DMODE FAM) ===\n");
+	dbgprintf("%ld moves of %ld KB per run between one port address and FAST RAM\n",
+	          (ULONG)STREAM_MOVES, (ULONG)STREAM_BUF_SIZE / 1024);
+	PrintStatsConfig();
+
+	// The chip moves longwords to and from the port
+	if (port & 3) {
+		dbgprintf("ERROR: Port 0x%08lx is not longword aligned\n", port);
+		return;
+	}
+
+	script = AllocScriptMem(STREAM_SCRIPT_SIZE);
+	buf = PoolAlloc(POOL_FAST, STREAM_BUF_SIZE);
+	if (!port)
+		standin = PoolAlloc(POOL_FAST, POOL_MIN_BLOCK);
+	if (!script || !buf || (!port && !standin)) {
+		dbgprintf("ERROR: Could not allocate stream buffers\n");
+		goto cleanup;
+	}
+
+	// Each move covers the whole buffer, so it must be contiguous
+	if (DMATranslateRange(buf, STREAM_BUF_SIZE, &seg, 1) != 1) {
+		dbgprintf("ERROR: Stream buffer is not physically contiguous\n");
+		goto cleanup;
+	}
+	buf_phys = seg.phys;
+
+	if (port) {
+		port_phys = port;
+		cpu = TypeOfMem((APTR)port) != 0;
+		dbgprintf("Port at 0x%08lx (physical, used as given%s)\n", port_phys,
+		          cpu ? "" : ", not Exec RAM - no CPU comparison");
+	} else {
+		cpu = TRUE;
+		port_phys = DMAPhysAddr(standin);
+		dbgprintf("No port given - RAM stand-in at 0x%08lx\n", port_phys);
+	}
+
+	StreamDirection(ncr, script, port_phys, port ? (ULONG *)port : standin, buf, buf_phys,
+	                FALSE, !port, cpu);
+	StreamDirection(ncr, script, port_phys, port ? (ULONG *)port : standin, buf, buf_phys,
+	                TRUE, !port, cpu);
+
+cleanup:
+	PoolFree(standin, POOL_MIN_BLOCK);
+	PoolFree(buf, STREAM_BUF_SIZE);
+	if (script)
+		FreeScriptMem(script, STREAM_SCRIPT_SIZE);
+
+	dbgprintf("\n=== Fixed-Address Streaming Complete ===\n\n");
+	dbgflush();
+}
@@ -0,0 +1,119 @@
+/*
+ * NCR 53C710 DMA Test Tool - EClock based timing
+ *
+ * Uses timer.device ReadEClock() for throughput measurements.
+ * The EClock runs at ~709 kHz (PAL) / ~715 kHz (NTSC), which gives
+ * roughly 1.4us resolution - good enough for transfers of a few
+ * hundred bytes upwards.
+ */
+
+#include "ncr_dmatest.h"
+#include <exec/io.h>
+#include <devices/timer.h>
+#include <proto/exec.h>
+#include <proto/timer.h>
+
+/* Base for ReadEClock() - set up by InitTimer() */
+struct Device *TimerBase = NULL;
+
+static struct timerequest g_timer_req;
+static ULONG g_eclock_freq = 0;
+
+/*
+ * Open timer.device so ReadEClock() can be used
+ * Returns 0 on success, -1 on failure
+ */
+LONG InitTimer(void)
+{
+	struct EClockVal ev;
+
+	if (TimerBase)
+		return 0;
+
+	if (OpenDevice(TIMERNAME, UNIT_ECLOCK, &g_timer_req.tr_node, 0) != 0) {
+		dbgprintf("ERROR: Could not open %s\n", TIMERNAME);
+		return -1;
+	}
+
+	TimerBase = g_timer_req.tr_node.io_Device;
+	g_eclock_freq = ReadEClock(&ev);
+
+	dbgprintf("EClock frequency: %ld Hz\n", g_eclock_freq);
+
+	return 0;
+}
+
+/*
+ * Close timer.device
+ */
+void CleanupTimer(void)
+{
+	if (!TimerBase)
+		return;
+
+	CloseDevice(&g_timer_req.tr_node);
+	TimerBase = NULL;
+}
+
+/*
+ * Sample the EClock (reads zero if timer.device is not open)
+ */
+void ReadTimer(struct EClockVal *ev)
+{
+	if (!TimerBase) {
+		ev->ev_hi = 0;
+		ev->ev_lo = 0;
+		return;
+	}
+
+	ReadEClock(ev);
+}
+
+/*
+ * Microseconds between two EClock samples (saturates at ~71 minutes)
+ */
+ULONG ElapsedMicros(struct EClockVal *start, struct EClockVal *end)
+{
+	unsigned long long s, e, us;
+
+	if (!g_eclock_freq)
+		return 0;
+
+	s = ((unsigned long long)start->ev_hi << 32) | start->ev_lo;
+	e = ((unsigned long long)end->ev_hi << 32) | end->ev_lo;
+
+	us = ((e - s) * 1000000ULL) / g_eclock_freq;
+	if (us > 0xFFFFFFFFULL)
+		us = 0xFFFFFFFFULL;
+
+	return (ULONG)us;
+}
+
+/*
+ * Whole seconds between two EClock samples - for runs longer than
+ * ElapsedMicros() can express
+ */
+ULONG ElapsedSeconds(struct EClockVal *start, struct EClockVal *end)
+{
+	unsigned long long s, e;
+
+	if (!g_eclock_freq)
+		return 0;
+
+	s = ((unsigned long long)start->ev_hi << 32) | start->ev_lo;
+	e = ((unsigned long long)end->ev_hi << 32) | end->ev_lo;
+
+	return (ULONG)((e - s) / g_eclock_freq);
+}
+
+/*
+ * Transfer rate in hundredths of MB/s (1 MB = 10^6 bytes)
+ * Print with "%ld.%02ld", rate / 100, rate % 100
+ */
+ULONG CalcRate(ULONG bytes, ULONG micros)
+{
+	if (micros == 0)
+		micros = 1;
+
+	return (ULONG)(((unsigned long long)bytes * 100ULL) / micros);
+}
@@ -0,0 +1,265 @@
+/*
+ * NCR 53C710 DMA Test Tool - DMODE/CTEST7/DCNTL burst tuner
+ *
+ * ResetNCR() forces CTEST7 CDIS (burst disabled) and InitNCR() fixes DMODE
+ * to BL1|BL0|FC2 - the ROM driver's conservative choices. This mode sweeps
+ * burst length, CDIS and DCNTL fast arbitration, runs a reduced alignment
+ * matrix for every region pair under each combination and recommends the
+ * fastest configuration that produced zero errors. With "save" the result
+ * is written to ENV:/ENVARC: and picked up by InitNCR() from then on.
+ */
+
+#include "ncr_dmatest.h"
+#include <stdio.h>
+#include <exec/memory.h>
+#include <proto/exec.h>
+
+/* Reduced matrix run for every configuration and region pair */
+static const ULONG tune_lengths[] = { 255, 4095, 4096, 16381, 16384 };
+static const ULONG tune_aligns[] = { 0, 1, 2, 3 };
+#define NUM_TUNE_LENGTHS (sizeof(tune_lengths) / sizeof(tune_lengths[0]))
+#define NUM_TUNE_ALIGNS  (sizeof(tune_aligns) / sizeof(tune_aligns[0]))
+
+#define MAX_TUNE_PAIRS   16
+
+static const char *burst_names[] = { "1", "2", "4", "8" };
+
+struct TuneResult {
+	struct BurstConfig cfg;
+	ULONG bytes;
+	ULONG micros;
+	ULONG errors;
+	ULONG pair_bytes[MAX_TUNE_PAIRS];
+	ULONG pair_errors[MAX_TUNE_PAIRS];
+	struct SampleStats pair_stats[MAX_TUNE_PAIRS];
+};
+
+static struct TuneResult g_tune[NUM_TUNE_CONFIGS];
+
+/*
+ * Build configuration 'index' on top of the current register values
+ * index bits: [3:2] burst length, [1] CDIS, [0] FA
+ */
+void BuildTuneConfig(ULONG index, struct BurstConfig *base,
+                     struct BurstConfig *cfg)
+{
+	ULONG bl = (index >> 2) & 3;
+
+	cfg->dmode = (base->dmode & ~(DMODEF_BL1 | DMODEF_BL0)) | (bl << 6);
+	cfg->ctest7 = base->ctest7 & ~CTREST7_CDIS;
+	if (index & 2)
+		cfg->ctest7 |= CTREST7_CDIS;
+	cfg->dcntl = base->dcntl & ~DCNTLF_FA;
+	if (index & 1)
+		cfg->dcntl |= DCNTLF_FA;
+	cfg->pad = 0;
+}
+
+/*
+ * Print a configuration in human-readable form
+ */
+void PrintTuneConfig(struct BurstConfig *cfg)
+{
+	dbgprintf("BL=%s CDIS=%ld FA=%ld (DMODE=0x%02lx DCNTL=0x%02lx CTEST7=0x%02lx)",
+	          burst_names[(cfg->dmode >> 6) & 3],
+	          (ULONG)((cfg->ctest7 & CTREST7_CDIS) ? 1 : 0),
+	          (ULONG)((cfg->dcntl & DCNTLF_FA) ? 1 : 0),
+	          (ULONG)cfg->dmode, (ULONG)cfg->dcntl, (ULONG)cfg->ctest7);
+}
+
+/*
+ * One pass of the reduced matrix over a region pair
+ * Returns number of failed cells; bytes/micros of the good ones are added
+ */
+static ULONG TunePass(volatile struct ncr710 *ncr, UBYTE *src, UBYTE *dst,
+                      ULONG *bytes, ULONG *micros)
+{
+	ULONG l, s, d, errors = 0;
+
+	for (l = 0; l < NUM_TUNE_LENGTHS; l++) {
+		ULONG size = tune_lengths[l];
+
+		FillPattern(src, size + MATRIX_MAX_ALIGN, PATTERN_RANDOM);
+
+		for (s = 0; s < NUM_TUNE_ALIGNS; s++) {
+			for (d = 0; d < NUM_TUNE_ALIGNS; d++) {
+				ULONG us;
+				LONG error_offset;
+
+				if (RunMatrixCell(ncr, src, dst,
+				                  tune_aligns[s], tune_aligns[d],
+				                  size, &us, &error_offset) != TEST_SUCCESS) {
+					errors++;
+					continue;
+				}
+				*bytes += size;
+				*micros += us;
+			}
+		}
+	}
+
+	return errors;
+}
+
+/*
+ * Run the reduced matrix for every region pair under the currently
+ * applied configuration, StatsRuns() passes per pair
+ * The pair rate is that of the median pass
+ */
+static void RunTuneConfig(volatile struct ncr710 *ncr, struct TuneResult *res)
+{
+	int src_idx, dst_idx;
+	ULONG pair = 0;
+	ULONG run_us[STATS_MAX_REPS];
+	struct SampleSet set;
+	struct SampleStats st;
+
+	res->bytes = 0;
+	res->micros = 0;
+	res->errors = 0;
+
+	for (src_idx = 0; src_idx < g_num_test_buffers; src_idx += 2) {
+		for (dst_idx = 1; dst_idx < g_num_test_buffers; dst_idx += 2) {
+			UBYTE *src = *g_test_buffers[src_idx].buf;
+			UBYTE *dst = *g_test_buffers[dst_idx].buf;
+			ULONG bytes = 0, micros = 0, errors = 0, run;
+
+			if (pair >= MAX_TUNE_PAIRS)
+				return;
+
+			st.n = 0;
+			if (src && dst) {
+				StatsBegin(&set, run_us);
+				for (run = 0; run < StatsRuns(); run++) {
+					ULONG run_micros = 0;
+
+					bytes = 0;
+					errors += TunePass(ncr, src, dst, &bytes, &run_micros);
+					StatsAdd(&set, run_micros);
+				}
+				StatsCompute(&set, &st);
+				micros = st.median_us;
+			}
+
+			res->pair_bytes[pair] = bytes;
+			res->pair_stats[pair] = st;
+			res->pair_errors[pair] = errors;
+			res->bytes += bytes;
+			res->micros += micros;
+			res->errors += errors;
+			pair++;
+		}
+	}
+}
+
+/*
+ * Print per-pair results for one configuration
+ */
+static void PrintTunePairs(struct TuneResult *res)
+{
+	int src_idx, dst_idx;
+	ULONG pair = 0;
+
+	for (src_idx = 0; src_idx < g_num_test_buffers; src_idx += 2) {
+		for (dst_idx = 1; dst_idx < g_num_test_buffers; dst_idx += 2) {
+			if (pair >= MAX_TUNE_PAIRS)
+				return;
+
+			if (*g_test_buffers[src_idx].buf && *g_test_buffers[dst_idx].buf) {
+				dbgprintf("    %-9s -> %-9s", g_test_buffers[src_idx].name,
+				          g_test_buffers[dst_idx].name);
+				PrintRateStats(res->pair_bytes[pair], &res->pair_stats[pair]);
+				dbgprintf("  %ld errors\n", res->pair_errors[pair]);
+			}
+			pair++;
+		}
+	}
+}
+
+/*
+ * Sweep all burst configurations and recommend the fastest clean one
+ */
+void TestBurstTuning(volatile struct ncr710 *ncr, BOOL save)
+{
+	struct BurstConfig base;
+	struct TuneResult *best = NULL;
+	struct TuneResult *current = NULL;
+	ULONG i, rate;
+
+	ReadBurstConfig(ncr, &base);
+
+	dbgprintf("\n=== DMA Burst Configuration Tuner ===\n");
+	dbgprintf("Current: ");
+	PrintTuneConfig(&base);
+	dbgprintf("\n%ld configurations x %ld lengths x %ld alignments per region pair\n",
+	          (ULONG)NUM_TUNE_CONFIGS, (ULONG)NUM_TUNE_LENGTHS,
+	          (ULONG)(NUM_TUNE_ALIGNS * NUM_TUNE_ALIGNS));
+	PrintStatsConfig();
+
+	for (i = 0; i < NUM_TUNE_CONFIGS; i++) {
+		struct TuneResult *res = &g_tune[i];
+
+		BuildTuneConfig(i, &base, &res->cfg);
+
+		dbgprintf("\n[%2ld] ", i);
+		PrintTuneConfig(&res->cfg);
+		dbgprintf("\n");
+
+		ApplyBurstConfig(ncr, &res->cfg);
+		RunTuneConfig(ncr, res);
+		ApplyBurstConfig(ncr, &base);
+
+		rate = CalcRate(res->bytes, res->micros);
+		PrintTunePairs(res);
+		dbgprintf("    Total: %ld.%02ld MB/s, %ld errors\n",
+		          rate / 100, rate % 100, res->errors);
+		dbgflush();
+
+		if (res->cfg.dmode == base.dmode && res->cfg.ctest7 == base.ctest7 &&
+		    (res->cfg.dcntl | DCNTLF_EA) == (base.dcntl | DCNTLF_EA))
+			current = res;
+
+		if (res->errors == 0 &&
+		    (!best || rate > CalcRate(best->bytes, best->micros)))
+			best = res;
+	}
+
+	dbgprintf("\n=== Tuning Summary ===\n");
+	for (i = 0; i < NUM_TUNE_CONFIGS; i++) {
+		rate = CalcRate(g_tune[i].bytes, g_tune[i].micros);
+		dbgprintf("  [%2ld] %3ld.%02ld MB/s %5ld errors  ", i,
+		          rate / 100, rate % 100, g_tune[i].errors);
+		PrintTuneConfig(&g_tune[i].cfg);
+		dbgprintf("%s\n", (&g_tune[i] == best) ? "  <== BEST" : "");
+	}
+
+	if (!best) {
+		dbgprintf("\nNo configuration ran without errors - keeping current settings\n\n");
+		return;
+	}
+
+	rate = CalcRate(best->bytes, best->micros);
+	dbgprintf("\nRecommended: ");
+	PrintTuneConfig(&best->cfg);
+	dbgprintf("\n  %ld.%02ld MB/s", rate / 100, rate % 100);
+	if (current && current->micros) {
+		ULONG cur = CalcRate(current->bytes, current->micros);
+
+		if (cur)
+			dbgprintf(" (%ld%% of current setting's %ld.%02ld MB/s)",
+			          (rate * 100) / cur, cur / 100, cur % 100);
+	}
+	dbgprintf("\n");
+
+	if (save) {
+		if (SaveBurstConfig(&best->cfg) == 0) {
+			ApplyBurstConfig(ncr, &best->cfg);
+			dbgprintf("Saved to %s - InitNCR() will apply it from now on\n",
+			          BURST_ENV_NAME);
+		}
+	} else {
+		dbgprintf("Run 'ncr_dmatest tune save' to store it in %s\n", BURST_ENV_NAME);
+	}
+
+	dbgprintf("\n");
+}